@@ -0,0 +1,100 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#ifdef BLUEMARBLE_COUNT_ALLOCATIONS
+
+namespace
+{
+	// Inicialização constante, então ler daqui dentro do operator new não aloca
+	thread_local uint64_t ThreadAllocationCount = 0;
+
+	void* CountedAllocate(size_t Size)
+	{
+		ThreadAllocationCount++;
+		return std::malloc(Size ? Size : 1);
+	}
+
+	void* CountedAllocateAligned(size_t Size, std::align_val_t Alignment)
+	{
+		ThreadAllocationCount++;
+		const size_t AlignmentBytes = static_cast<size_t>(Alignment);
+#ifdef _MSC_VER
+		return _aligned_malloc(Size ? Size : 1, AlignmentBytes);
+#else
+		// aligned_alloc exige tamanho múltiplo do alinhamento
+		const size_t RoundedSize = (std::max<size_t>(Size, 1) + AlignmentBytes - 1) / AlignmentBytes * AlignmentBytes;
+		return std::aligned_alloc(AlignmentBytes, RoundedSize);
+#endif
+	}
+
+	void FreeAligned(void* Pointer)
+	{
+#ifdef _MSC_VER
+		_aligned_free(Pointer);
+#else
+		std::free(Pointer);
+#endif
+	}
+
+	void* CheckAllocation(void* Pointer)
+	{
+		if (!Pointer)
+		{
+			throw std::bad_alloc{};
+		}
+		return Pointer;
+	}
+}
+
+bool IsAllocationCountingEnabled()
+{
+	return true;
+}
+
+uint64_t GetThreadAllocationCount()
+{
+	return ThreadAllocationCount;
+}
+
+void* operator new(size_t Size) { return CheckAllocation(CountedAllocate(Size)); }
+void* operator new[](size_t Size) { return CheckAllocation(CountedAllocate(Size)); }
+void* operator new(size_t Size, const std::nothrow_t&) noexcept { return CountedAllocate(Size); }
+void* operator new[](size_t Size, const std::nothrow_t&) noexcept { return CountedAllocate(Size); }
+void* operator new(size_t Size, std::align_val_t Alignment) { return CheckAllocation(CountedAllocateAligned(Size, Alignment)); }
+void* operator new[](size_t Size, std::align_val_t Alignment) { return CheckAllocation(CountedAllocateAligned(Size, Alignment)); }
+void* operator new(size_t Size, std::align_val_t Alignment, const std::nothrow_t&) noexcept { return CountedAllocateAligned(Size, Alignment); }
+void* operator new[](size_t Size, std::align_val_t Alignment, const std::nothrow_t&) noexcept { return CountedAllocateAligned(Size, Alignment); }
+
+void operator delete(void* Pointer) noexcept { std::free(Pointer); }
+void operator delete[](void* Pointer) noexcept { std::free(Pointer); }
+void operator delete(void* Pointer, size_t) noexcept { std::free(Pointer); }
+void operator delete[](void* Pointer, size_t) noexcept { std::free(Pointer); }
+void operator delete(void* Pointer, const std::nothrow_t&) noexcept { std::free(Pointer); }
+void operator delete[](void* Pointer, const std::nothrow_t&) noexcept { std::free(Pointer); }
+void operator delete(void* Pointer, std::align_val_t) noexcept { FreeAligned(Pointer); }
+void operator delete[](void* Pointer, std::align_val_t) noexcept { FreeAligned(Pointer); }
+void operator delete(void* Pointer, size_t, std::align_val_t) noexcept { FreeAligned(Pointer); }
+void operator delete[](void* Pointer, size_t, std::align_val_t) noexcept { FreeAligned(Pointer); }
+void operator delete(void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(Pointer); }
+void operator delete[](void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(Pointer); }
+
+#else
+
+bool IsAllocationCountingEnabled()
+{
+	return false;
+}
+
+uint64_t GetThreadAllocationCount()
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Com a opção BLUEMARBLE_COUNT_ALLOCATIONS do CMake o operator new global é
+// trocado por um que conta as alocações de cada thread, para conferir que os
+// frames em regime não alocam nada no heap. Sem a opção as contagens ficam em
+// zero e nada é trocado.
+bool IsAllocationCountingEnabled();
+
+// Alocações feitas pela thread que chama desde que ela começou
+uint64_t GetThreadAllocationCount();
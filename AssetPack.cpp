@@ -0,0 +1,70 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+AssetPack& AssetPack::Get()
+{
+	static AssetPack Pack;
+	return Pack;
+}
+
+bool AssetPack::Open(const char* FilePath)
+{
+	Close();
+
+	if (!File.Open(FilePath))
+	{
+		return false;
+	}
+
+	AssetPackHeader Header;
+	bool bValid = File.GetSize() >= sizeof(Header);
+	if (bValid)
+	{
+		std::memcpy(&Header, File.GetData(), sizeof(Header));
+		bValid = std::memcmp(Header.Magic, AssetPackFormat::Magic, sizeof(Header.Magic)) == 0 && Header.Version == AssetPackFormat::Version &&
+		         File.GetSize() >= sizeof(Header) + static_cast<size_t>(Header.NumEntries) * sizeof(AssetEntry);
+	}
+
+	// O índice vem logo depois do cabeçalho, que tem o tamanho de um múltiplo de 8
+	const AssetEntry* IndexEntries = reinterpret_cast<const AssetEntry*>(File.GetData() + sizeof(Header));
+	for (uint32_t EntryIndex = 0; bValid && EntryIndex < Header.NumEntries; ++EntryIndex)
+	{
+		const AssetEntry& Entry = IndexEntries[EntryIndex];
+		bValid = Entry.Name[AssetPackFormat::MaxNameLength - 1] == '\0' && Entry.Offset <= File.GetSize() && Entry.Size <= File.GetSize() - Entry.Offset;
+	}
+
+	if (!bValid)
+	{
+		std::cout << "Pacote de assets invalido: " << FilePath << std::endl;
+		File.Close();
+		return false;
+	}
+
+	Entries = IndexEntries;
+	NumEntries = Header.NumEntries;
+
+	std::cout << "Usando o pacote de assets " << FilePath << " com " << NumEntries << " arquivos" << std::endl;
+	return true;
+}
+
+void AssetPack::Close()
+{
+	File.Close();
+	Entries = nullptr;
+	NumEntries = 0;
+}
+
+const AssetEntry* AssetPack::Find(const char* Name) const
+{
+	if (!IsOpen())
+	{
+		return nullptr;
+	}
+
+	const AssetEntry* End = Entries + NumEntries;
+	const AssetEntry* It = std::lower_bound(Entries, End, Name, [](const AssetEntry& Entry, const char* Key) { return std::strcmp(Entry.Name, Key) < 0; });
+	return It != End && std::strcmp(It->Name, Name) == 0 ? It : nullptr;
+}
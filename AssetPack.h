@@ -0,0 +1,30 @@
+#pragma once
+
+#include "AssetPackFormat.h"
+#include "MappedFile.h"
+
+// Pacote de assets gerado pelo BuildAssetPack, mapeado na memória. Os
+// carregadores de texturas, shaders e malhas procuram o arquivo no pacote
+// antes de ir ao disco, e recebem ponteiros direto para a memória mapeada.
+// Sem o pacote tudo continua sendo lido dos arquivos soltos.
+class AssetPack
+{
+public:
+	// O pacote do processo, aberto no início da renderização
+	static AssetPack& Get();
+
+	bool Open(const char* FilePath);
+	void Close();
+
+	bool IsOpen() const { return Entries != nullptr; }
+
+	// Busca binária no índice. Retorna nullptr se o arquivo não está no pacote.
+	const AssetEntry* Find(const char* Name) const;
+
+	const unsigned char* GetData(const AssetEntry& Entry) const { return File.GetData() + Entry.Offset; }
+
+private:
+	MappedFile File;
+	const AssetEntry* Entries = nullptr;
+	uint32_t NumEntries = 0;
+};
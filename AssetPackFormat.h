@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Formato do pacote de assets: um AssetPackHeader, o índice com um
+// AssetEntry por arquivo, ordenado pelo nome, e os dados de cada arquivo
+// alinhados a BlobAlignment. Os dados já estão no formato que vai para a
+// GPU, então o pacote mapeado na memória é enviado sem cópias nem
+// decodificação.
+namespace AssetPackFormat
+{
+	constexpr char Magic[4] = { 'B', 'M', 'A', 'P' };
+	constexpr uint32_t Version = 1;
+	constexpr size_t BlobAlignment = 64;
+	constexpr size_t MaxNameLength = 56;
+
+	// Malha da esfera com todos os níveis de SphereLOD
+	constexpr const char* SphereMeshName = "meshes/esfera";
+}
+
+namespace EAssetType
+{
+	enum Type : uint32_t
+	{
+		// Bytes do arquivo original, como os shaders
+		Raw,
+
+		// Imagem decodificada, com os mips em sequência do maior para o menor
+		Texture,
+
+		// MeshSection de cada nível, depois os Vertex e os Triangle
+		Mesh,
+	};
+}
+
+namespace ETextureFormat
+{
+	enum Type : uint32_t
+	{
+		// 3 bytes por texel, só o nível 0
+		RGB8,
+
+		// Blocos 4x4 de 8 bytes (DXT1), todos os mips
+		BC1,
+	};
+}
+
+struct AssetPackHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t NumEntries;
+	uint32_t Reserved[5];
+};
+
+static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader precisa ter 32 bytes");
+
+struct AssetEntry
+{
+	// Caminho relativo usado pelo código, como "textures/terra.jpg"
+	char Name[AssetPackFormat::MaxNameLength];
+
+	uint32_t Type;
+	uint32_t Format;
+	uint64_t Offset;
+	uint64_t Size;
+
+	// Texturas: largura, altura e número de mips.
+	// Malhas: número de vértices, de triângulos e de seções.
+	uint32_t Dimensions[3];
+	uint32_t Reserved;
+};
+
+static_assert(sizeof(AssetEntry) == 96, "AssetEntry precisa ter 96 bytes");
+
+// Bytes de um mip em BC1
+inline size_t GetBC1LevelSize(uint32_t Width, uint32_t Height)
+{
+	return static_cast<size_t>((Width + 3) / 4) * ((Height + 3) / 4) * 8;
+}
@@ -0,0 +1,197 @@
+#include "AsteroidField.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/ext.hpp>
+
+#define STB_PERLIN_IMPLEMENTATION
+#include "deps/stb/stb_perlin.h"
+
+namespace
+{
+	// Poucos vértices por rocha: o custo está no número de instâncias
+	constexpr GLuint RockResolution = 7;
+
+	// Raio da órbita da Terra, que tem velocidade angular 1
+	constexpr float ReferenceOrbitRadius = 60.0f;
+
+	void GenerateRock(int Shape, std::vector<Vertex>& Vertices, std::vector<Triangle>& Indices)
+	{
+		GenerateSphere(RockResolution, Vertices, Indices);
+
+		// Cada rocha usa uma região diferente do ruído e um achatamento próprio
+		const float NoiseOffset = Shape * 13.7f;
+		const glm::vec3 Squash{ 1.0f, 0.6f + 0.1f * Shape, 0.85f - 0.05f * Shape };
+
+		for (Vertex& RockVertex : Vertices)
+		{
+			const glm::vec3 P = RockVertex.Position * 1.5f;
+			const float Noise = stb_perlin_fbm_noise3(P.x + NoiseOffset, P.y, P.z, 2.0f, 0.5f, 3);
+			RockVertex.Position *= (1.0f + 0.4f * Noise) * Squash;
+			RockVertex.Normal = glm::vec3{ 0.0f };
+		}
+
+		// As normais são refeitas a partir das faces deformadas
+		for (const Triangle& Face : Indices)
+		{
+			Vertex& V0 = Vertices[Face.V0];
+			Vertex& V1 = Vertices[Face.V1];
+			Vertex& V2 = Vertices[Face.V2];
+
+			const glm::vec3 FaceNormal = glm::cross(V1.Position - V0.Position, V2.Position - V0.Position);
+			V0.Normal += FaceNormal;
+			V1.Normal += FaceNormal;
+			V2.Normal += FaceNormal;
+		}
+
+		for (Vertex& RockVertex : Vertices)
+		{
+			const float Length = glm::length(RockVertex.Normal);
+			RockVertex.Normal = Length > 0.0f ? RockVertex.Normal / Length : glm::normalize(RockVertex.Position);
+		}
+	}
+
+	AsteroidInstance GenerateAsteroid(const AsteroidBeltDesc& Belt, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Unit{ 0.0f, 1.0f };
+		std::normal_distribution<float> Normal{ 0.0f, 1.0f };
+
+		// Mais asteroides no meio do cinturão do que nas bordas
+		const float Middle = 0.5f * (Belt.InnerRadius + Belt.OuterRadius);
+		const float HalfWidth = 0.5f * (Belt.OuterRadius - Belt.InnerRadius);
+		const float SemiMajorAxis = glm::clamp(Middle + Normal(Random) * HalfWidth * 0.5f, Belt.InnerRadius, Belt.OuterRadius);
+
+		const float Eccentricity = Belt.MaxEccentricity * Unit(Random) * Unit(Random);
+		const float Inclination = glm::min(glm::abs(Normal(Random)) * Belt.MaxInclination * 0.4f, Belt.MaxInclination);
+
+		// Terceira lei de Kepler: a velocidade angular cai com o raio elevado a 3/2
+		const float AngularSpeed = glm::pow(ReferenceOrbitRadius / SemiMajorAxis, 1.5f);
+
+		// Muitos asteroides pequenos e poucos grandes
+		const float Size = Unit(Random);
+		const float Scale = glm::mix(Belt.MinScale, Belt.MaxScale, Size * Size * Size);
+
+		AsteroidInstance Asteroid;
+		Asteroid.Orbit = glm::vec4{ SemiMajorAxis, Eccentricity, Unit(Random) * glm::two_pi<float>(), AngularSpeed };
+		Asteroid.Orientation = glm::vec4{ Inclination, Unit(Random) * glm::two_pi<float>(), Scale, glm::mix(-2.0f, 2.0f, Unit(Random)) };
+		return Asteroid;
+	}
+}
+
+void AsteroidField::Create(const AsteroidBeltDesc* Belts, size_t NumBelts, float CountScale)
+{
+	std::vector<Vertex> Vertices;
+	std::vector<Triangle> Indices;
+	{
+		std::vector<Vertex> RockVertices;
+		std::vector<Triangle> RockIndices;
+		for (int Shape = 0; Shape < NumRockShapes; ++Shape)
+		{
+			GenerateRock(Shape, RockVertices, RockIndices);
+			RockSections[Shape] = AppendMesh(RockVertices, RockIndices, Vertices, Indices);
+		}
+	}
+
+	// Os asteroides de cada cinturão são divididos igualmente entre as rochas
+	std::vector<AsteroidInstance> Instances;
+	for (int Shape = 0; Shape < NumRockShapes; ++Shape)
+	{
+		RockFirstInstance[Shape] = static_cast<GLuint>(Instances.size());
+
+		for (size_t BeltIndex = 0; BeltIndex < NumBelts; ++BeltIndex)
+		{
+			const AsteroidBeltDesc& Belt = Belts[BeltIndex];
+			const GLuint BeltCount = static_cast<GLuint>(Belt.Count * CountScale);
+			const GLuint ShapeCount = BeltCount / NumRockShapes + (Shape < static_cast<int>(BeltCount % NumRockShapes) ? 1 : 0);
+
+			// A semente inclui a rocha para que cada grupo tenha órbitas diferentes
+			std::mt19937 Random{ Belt.Seed * NumRockShapes + Shape };
+			for (GLuint Index = 0; Index < ShapeCount; ++Index)
+			{
+				Instances.push_back(GenerateAsteroid(Belt, Random));
+			}
+		}
+
+		RockInstanceCount[Shape] = static_cast<GLuint>(Instances.size()) - RockFirstInstance[Shape];
+	}
+	NumAsteroids = static_cast<GLuint>(Instances.size());
+
+	std::cout << "Cinturoes de asteroides com " << NumAsteroids << " asteroides" << std::endl;
+
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenBuffers(1, &VertexBuffer);
+	glGenBuffers(1, &ElementBuffer);
+	glGenBuffers(1, &InstanceBuffer);
+
+	glBindVertexArray(VertexArrayId);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Normal)));
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(Triangle), Indices.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, Instances.size() * sizeof(AsteroidInstance), Instances.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribDivisor(2, 1);
+	glVertexAttribDivisor(3, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void AsteroidField::Release()
+{
+	glDeleteBuffers(1, &InstanceBuffer);
+	glDeleteBuffers(1, &ElementBuffer);
+	glDeleteBuffers(1, &VertexBuffer);
+	glDeleteVertexArrays(1, &VertexArrayId);
+
+	InstanceBuffer = 0;
+	ElementBuffer = 0;
+	VertexBuffer = 0;
+	VertexArrayId = 0;
+	NumAsteroids = 0;
+}
+
+void AsteroidField::Draw(GLuint ProgramId, const glm::mat4& BeltMatrix) const
+{
+	if (ProgramId == 0 || NumAsteroids == 0)
+	{
+		return;
+	}
+
+	glUseProgram(ProgramId);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "BeltMatrix"), 1, GL_FALSE, glm::value_ptr(BeltMatrix));
+
+	glBindVertexArray(VertexArrayId);
+	glBindBuffer(GL_ARRAY_BUFFER, InstanceBuffer);
+
+	// Um draw por rocha. Os atributos por instância são apontados para o
+	// primeiro asteroide do grupo, o que dispensa base instance.
+	for (int Shape = 0; Shape < NumRockShapes; ++Shape)
+	{
+		if (RockInstanceCount[Shape] == 0)
+		{
+			continue;
+		}
+
+		const GLintptr InstanceOffset = RockFirstInstance[Shape] * sizeof(AsteroidInstance);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(AsteroidInstance), reinterpret_cast<void*>(InstanceOffset + offsetof(AsteroidInstance, Orbit)));
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(AsteroidInstance), reinterpret_cast<void*>(InstanceOffset + offsetof(AsteroidInstance, Orientation)));
+
+		const MeshSection& Section = RockSections[Shape];
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, Section.IndexCount, GL_UNSIGNED_INT, reinterpret_cast<void*>(Section.FirstIndex * sizeof(GLuint)),
+		                                  RockInstanceCount[Shape], Section.BaseVertex);
+	}
+
+	glBindVertexArray(0);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+// Distribuição dos elementos orbitais de um cinturão
+struct AsteroidBeltDesc
+{
+	float InnerRadius;
+	float OuterRadius;
+	float MaxInclination;
+	float MaxEccentricity;
+	float MinScale;
+	float MaxScale;
+	GLuint Count;
+	uint32_t Seed;
+};
+
+// Dados fixos de cada asteroide. A posição na órbita é calculada no vertex
+// shader a partir do tempo, então nada é enviado para a GPU depois do Create.
+struct AsteroidInstance
+{
+	// x = semi-eixo maior, y = excentricidade, z = fase inicial, w = velocidade angular
+	glm::vec4 Orbit;
+
+	// x = inclinação, y = longitude do nó ascendente, z = escala, w = velocidade de rotação
+	glm::vec4 Orientation;
+};
+
+// Todos os cinturões de asteroides, desenhados com instancing a partir de
+// algumas poucas rochas geradas deformando esferas com ruído de Perlin
+class AsteroidField
+{
+public:
+	static constexpr int NumRockShapes = 4;
+
+	// CountScale reduz o número de asteroides de todos os cinturões, por
+	// exemplo quando o OpenGL é emulado por software
+	void Create(const AsteroidBeltDesc* Belts, size_t NumBelts, float CountScale);
+	void Release();
+
+	// BeltMatrix leva o plano das órbitas para o espaço do mundo
+	void Draw(GLuint ProgramId, const glm::mat4& BeltMatrix) const;
+
+	GLuint GetNumAsteroids() const { return NumAsteroids; }
+
+private:
+	GLuint VertexArrayId = 0;
+	GLuint VertexBuffer = 0;
+	GLuint ElementBuffer = 0;
+	GLuint InstanceBuffer = 0;
+	GLuint NumAsteroids = 0;
+
+	// As instâncias ficam agrupadas pela rocha usada
+	MeshSection RockSections[NumRockShapes] = {};
+	GLuint RockFirstInstance[NumRockShapes] = {};
+	GLuint RockInstanceCount[NumRockShapes] = {};
+};
@@ -0,0 +1,434 @@
+#include "Atmosphere.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <glm/ext.hpp>
+
+#include "Mesh.h"
+
+namespace
+{
+	constexpr int TransmittanceSteps = 64;
+	constexpr int ScatteringSteps = 48;
+
+	// Muda sempre que a integração ou o formato do arquivo mudar
+	constexpr uint32_t CacheVersion = 1;
+	constexpr char CacheMagic[4] = { 'B', 'M', 'A', 'T' };
+
+	struct CacheHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint64_t Key;
+	};
+
+	size_t TransmittanceFloats()
+	{
+		return static_cast<size_t>(AtmosphereLUT::TransmittanceMuSize) * AtmosphereLUT::TransmittanceRSize * 3;
+	}
+
+	size_t ScatteringFloats()
+	{
+		using namespace AtmosphereLUT;
+		return static_cast<size_t>(ScatteringMuSSize) * ScatteringNuSize * ScatteringMuSize * ScatteringRSize * 4;
+	}
+
+	// FNV-1a dos parâmetros e dos tamanhos das tabelas
+	uint64_t MakeCacheKey(const AtmosphereParams& Params)
+	{
+		using namespace AtmosphereLUT;
+		const float Values[] =
+		{
+			Params.TopRadius,
+			Params.RayleighScattering.r, Params.RayleighScattering.g, Params.RayleighScattering.b, Params.RayleighScaleHeight,
+			Params.MieScattering.r, Params.MieScattering.g, Params.MieScattering.b, Params.MieScaleHeight,
+			static_cast<float>(TransmittanceMuSize), static_cast<float>(TransmittanceRSize),
+			static_cast<float>(ScatteringMuSSize), static_cast<float>(ScatteringNuSize), static_cast<float>(ScatteringMuSize), static_cast<float>(ScatteringRSize),
+			MinMuS, static_cast<float>(CacheVersion),
+		};
+
+		uint64_t Hash = 14695981039346656037ull;
+		const unsigned char* Bytes = reinterpret_cast<const unsigned char*>(Values);
+		for (size_t Index = 0; Index < sizeof(Values); ++Index)
+		{
+			Hash = (Hash ^ Bytes[Index]) * 1099511628211ull;
+		}
+		return Hash;
+	}
+
+	std::string MakeCachePath(uint64_t Key)
+	{
+		std::ostringstream Path;
+		Path << "cache/atmosfera_" << std::hex << std::setw(16) << std::setfill('0') << Key << ".bin";
+		return Path.str();
+	}
+
+	bool LoadCache(const std::string& Path, uint64_t Key, std::vector<float>& Transmittance, std::vector<float>& Scattering)
+	{
+		std::ifstream File{ Path, std::ios::binary };
+		if (!File)
+		{
+			return false;
+		}
+
+		CacheHeader Header;
+		if (!File.read(reinterpret_cast<char*>(&Header), sizeof(Header)) || std::memcmp(Header.Magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+		    Header.Version != CacheVersion || Header.Key != Key)
+		{
+			return false;
+		}
+
+		Transmittance.resize(TransmittanceFloats());
+		Scattering.resize(ScatteringFloats());
+		File.read(reinterpret_cast<char*>(Transmittance.data()), Transmittance.size() * sizeof(float));
+		File.read(reinterpret_cast<char*>(Scattering.data()), Scattering.size() * sizeof(float));
+		return static_cast<bool>(File);
+	}
+
+	void SaveCache(const std::string& Path, uint64_t Key, const std::vector<float>& Transmittance, const std::vector<float>& Scattering)
+	{
+		std::error_code Error;
+		std::filesystem::create_directories(std::filesystem::path{ Path }.parent_path(), Error);
+
+		std::ofstream File{ Path, std::ios::binary };
+		if (!File)
+		{
+			std::cout << "Nao foi possivel salvar " << Path << std::endl;
+			return;
+		}
+
+		CacheHeader Header;
+		std::memcpy(Header.Magic, CacheMagic, sizeof(CacheMagic));
+		Header.Version = CacheVersion;
+		Header.Key = Key;
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+		File.write(reinterpret_cast<const char*>(Transmittance.data()), Transmittance.size() * sizeof(float));
+		File.write(reinterpret_cast<const char*>(Scattering.data()), Scattering.size() * sizeof(float));
+	}
+
+	// Distância do ponto a altura R (centro do planeta na origem, raio 1) até
+	// o chão ou o topo da atmosfera, seguindo a direção com cosseno Mu em
+	// relação à vertical
+	float DistanceToBoundary(float R, float Mu, float TopRadius, bool& bHitsGround)
+	{
+		const float GroundDiscriminant = R * R * (Mu * Mu - 1.0f) + 1.0f;
+		bHitsGround = Mu < 0.0f && GroundDiscriminant >= 0.0f;
+		if (bHitsGround)
+		{
+			return glm::max(0.0f, -R * Mu - glm::sqrt(GroundDiscriminant));
+		}
+
+		const float TopDiscriminant = R * R * (Mu * Mu - 1.0f) + TopRadius * TopRadius;
+		return glm::max(0.0f, -R * Mu + glm::sqrt(glm::max(TopDiscriminant, 0.0f)));
+	}
+
+	glm::vec3 Extinction(const AtmosphereParams& Params, float Altitude)
+	{
+		const glm::vec3 MieExtinction = Params.MieScattering / 0.9f;
+		return Params.RayleighScattering * glm::exp(-Altitude / Params.RayleighScaleHeight) + MieExtinction * glm::exp(-Altitude / Params.MieScaleHeight);
+	}
+
+	// Coordenada da tabela (de 0 a Size - 1) para um valor entre Min e Max
+	float ToTableCoord(float Value, float Min, float Max, int Size)
+	{
+		return glm::clamp((Value - Min) / (Max - Min), 0.0f, 1.0f) * (Size - 1);
+	}
+
+	glm::vec3 LookupTransmittance(const std::vector<float>& Transmittance, float TopRadius, float R, float Mu)
+	{
+		using namespace AtmosphereLUT;
+		const float X = ToTableCoord(Mu, -1.0f, 1.0f, TransmittanceMuSize);
+		const float Y = ToTableCoord(R, 1.0f, TopRadius, TransmittanceRSize);
+		const int X0 = glm::min(static_cast<int>(X), TransmittanceMuSize - 2);
+		const int Y0 = glm::min(static_cast<int>(Y), TransmittanceRSize - 2);
+		const float FracX = X - X0;
+		const float FracY = Y - Y0;
+
+		auto Texel = [&](int TX, int TY)
+		{
+			const float* Value = &Transmittance[(static_cast<size_t>(TY) * TransmittanceMuSize + TX) * 3];
+			return glm::vec3{ Value[0], Value[1], Value[2] };
+		};
+
+		return glm::mix(glm::mix(Texel(X0, Y0), Texel(X0 + 1, Y0), FracX), glm::mix(Texel(X0, Y0 + 1), Texel(X0 + 1, Y0 + 1), FracX), FracY);
+	}
+
+	// Executa Work(Index) para Index de 0 a Count - 1 em todas as threads disponíveis
+	template<typename WorkFunction>
+	void ParallelFor(int Count, const WorkFunction& Work)
+	{
+		std::atomic<int> NextIndex{ 0 };
+		auto Worker = [&]()
+		{
+			for (int Index = NextIndex++; Index < Count; Index = NextIndex++)
+			{
+				Work(Index);
+			}
+		};
+
+		const unsigned NumThreads = glm::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::thread> Threads;
+		for (unsigned ThreadIndex = 1; ThreadIndex < NumThreads; ++ThreadIndex)
+		{
+			Threads.emplace_back(Worker);
+		}
+		Worker();
+
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+	}
+}
+
+void PrecomputeAtmosphere(const AtmosphereParams& Params, std::vector<float>& Transmittance, std::vector<float>& Scattering)
+{
+	using namespace AtmosphereLUT;
+
+	Transmittance.resize(TransmittanceFloats());
+	Scattering.resize(ScatteringFloats());
+
+	// Transmitância do ponto até o chão ou o topo da atmosfera
+	ParallelFor(TransmittanceRSize, [&](int RIndex)
+	{
+		const float R = glm::mix(1.0f, Params.TopRadius, static_cast<float>(RIndex) / (TransmittanceRSize - 1));
+		for (int MuIndex = 0; MuIndex < TransmittanceMuSize; ++MuIndex)
+		{
+			const float Mu = glm::mix(-1.0f, 1.0f, static_cast<float>(MuIndex) / (TransmittanceMuSize - 1));
+
+			bool bHitsGround;
+			const float Distance = DistanceToBoundary(R, Mu, Params.TopRadius, bHitsGround);
+			const float Step = Distance / TransmittanceSteps;
+
+			glm::vec3 OpticalDepth{ 0.0f };
+			for (int Sample = 0; Sample < TransmittanceSteps; ++Sample)
+			{
+				const float T = (Sample + 0.5f) * Step;
+				const float SampleR = glm::sqrt(R * R + T * T + 2.0f * R * Mu * T);
+				OpticalDepth += Extinction(Params, SampleR - 1.0f) * Step;
+			}
+
+			const glm::vec3 Value = glm::exp(-OpticalDepth);
+			float* Texel = &Transmittance[(static_cast<size_t>(RIndex) * TransmittanceMuSize + MuIndex) * 3];
+			Texel[0] = Value.r;
+			Texel[1] = Value.g;
+			Texel[2] = Value.b;
+		}
+	});
+
+	// Luz do Sol espalhada uma vez ao longo do raio de visão
+	const int ScatteringWidth = ScatteringMuSSize * ScatteringNuSize;
+	ParallelFor(ScatteringRSize, [&](int RIndex)
+	{
+		const float R = glm::mix(1.0f, Params.TopRadius, static_cast<float>(RIndex) / (ScatteringRSize - 1));
+		const glm::vec3 Origin{ 0.0f, 0.0f, R };
+
+		for (int MuIndex = 0; MuIndex < ScatteringMuSize; ++MuIndex)
+		{
+			const float Mu = glm::mix(-1.0f, 1.0f, static_cast<float>(MuIndex) / (ScatteringMuSize - 1));
+			const glm::vec3 ViewDirection{ glm::sqrt(glm::max(0.0f, 1.0f - Mu * Mu)), 0.0f, Mu };
+
+			bool bHitsGround;
+			const float Distance = DistanceToBoundary(R, Mu, Params.TopRadius, bHitsGround);
+			const float Step = Distance / ScatteringSteps;
+
+			for (int NuIndex = 0; NuIndex < ScatteringNuSize; ++NuIndex)
+			{
+				const float Nu = glm::mix(-1.0f, 1.0f, static_cast<float>(NuIndex) / (ScatteringNuSize - 1));
+
+				for (int MuSIndex = 0; MuSIndex < ScatteringMuSSize; ++MuSIndex)
+				{
+					const float MuS = glm::mix(MinMuS, 1.0f, static_cast<float>(MuSIndex) / (ScatteringMuSSize - 1));
+
+					// Direção do Sol com o cosseno MuS em relação à vertical e Nu em relação à visão
+					glm::vec3 SunDirection{ 0.0f, 0.0f, MuS };
+					SunDirection.x = ViewDirection.x > 1e-4f ? (Nu - Mu * MuS) / ViewDirection.x : 0.0f;
+					SunDirection.y = glm::sqrt(glm::max(0.0f, 1.0f - SunDirection.x * SunDirection.x - MuS * MuS));
+					SunDirection = glm::normalize(SunDirection);
+
+					glm::vec3 OpticalDepth{ 0.0f };
+					glm::vec3 Rayleigh{ 0.0f };
+					float Mie = 0.0f;
+
+					for (int Sample = 0; Sample < ScatteringSteps; ++Sample)
+					{
+						const glm::vec3 Point = Origin + ViewDirection * ((Sample + 0.5f) * Step);
+						const float PointR = glm::length(Point);
+						const float Altitude = PointR - 1.0f;
+
+						OpticalDepth += Extinction(Params, Altitude) * (Step * 0.5f);
+
+						// Pontos na sombra do planeta não recebem luz do Sol
+						const float PointMuS = glm::dot(Point, SunDirection) / PointR;
+						bool bSunBlocked;
+						DistanceToBoundary(PointR, PointMuS, Params.TopRadius, bSunBlocked);
+						if (!bSunBlocked)
+						{
+							const glm::vec3 Attenuation = glm::exp(-OpticalDepth) * LookupTransmittance(Transmittance, Params.TopRadius, PointR, PointMuS);
+							Rayleigh += Attenuation * glm::exp(-Altitude / Params.RayleighScaleHeight) * Step;
+							Mie += Attenuation.r * glm::exp(-Altitude / Params.MieScaleHeight) * Step;
+						}
+
+						OpticalDepth += Extinction(Params, Altitude) * (Step * 0.5f);
+					}
+
+					Rayleigh *= Params.RayleighScattering;
+					Mie *= Params.MieScattering.r;
+
+					const size_t X = static_cast<size_t>(NuIndex) * ScatteringMuSSize + MuSIndex;
+					float* Texel = &Scattering[((static_cast<size_t>(RIndex) * ScatteringMuSize + MuIndex) * ScatteringWidth + X) * 4];
+					Texel[0] = Rayleigh.r;
+					Texel[1] = Rayleigh.g;
+					Texel[2] = Rayleigh.b;
+					Texel[3] = Mie;
+				}
+			}
+		}
+	});
+}
+
+void Atmosphere::Create(const AtmosphereParams& InParams)
+{
+	using namespace AtmosphereLUT;
+
+	Params = InParams;
+
+	const uint64_t Key = MakeCacheKey(Params);
+	const std::string CachePath = MakeCachePath(Key);
+
+	std::vector<float> Transmittance;
+	std::vector<float> Scattering;
+	if (LoadCache(CachePath, Key, Transmittance, Scattering))
+	{
+		std::cout << "Carregando atmosfera de " << CachePath << std::endl;
+	}
+	else
+	{
+		const auto StartTime = std::chrono::steady_clock::now();
+		PrecomputeAtmosphere(Params, Transmittance, Scattering);
+		const auto Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime);
+		std::cout << "Atmosfera calculada em " << Elapsed.count() << " ms" << std::endl;
+
+		SaveCache(CachePath, Key, Transmittance, Scattering);
+	}
+
+	glGenTextures(1, &TransmittanceTextureId);
+	glBindTexture(GL_TEXTURE_2D, TransmittanceTextureId);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, TransmittanceMuSize, TransmittanceRSize, 0, GL_RGB, GL_FLOAT, Transmittance.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &ScatteringTextureId);
+	glBindTexture(GL_TEXTURE_3D, ScatteringTextureId);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, ScatteringMuSSize * ScatteringNuSize, ScatteringMuSize, ScatteringRSize, 0, GL_RGBA, GL_FLOAT, Scattering.data());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	// Casca esférica com o raio do topo da atmosfera
+	std::vector<Vertex> Vertices;
+	std::vector<Triangle> Indices;
+	GenerateSphere(48, Vertices, Indices);
+	IndexCount = static_cast<GLsizei>(Indices.size() * 3);
+
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenBuffers(1, &VertexBuffer);
+	glGenBuffers(1, &ElementBuffer);
+
+	glBindVertexArray(VertexArrayId);
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(Triangle), Indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Atmosphere::Release()
+{
+	glDeleteBuffers(1, &ElementBuffer);
+	glDeleteBuffers(1, &VertexBuffer);
+	glDeleteVertexArrays(1, &VertexArrayId);
+	glDeleteTextures(1, &ScatteringTextureId);
+	glDeleteTextures(1, &TransmittanceTextureId);
+
+	ElementBuffer = 0;
+	VertexBuffer = 0;
+	VertexArrayId = 0;
+	ScatteringTextureId = 0;
+	TransmittanceTextureId = 0;
+}
+
+void Atmosphere::Draw(GLuint ProgramId, const glm::mat4& PlanetModelMatrix, float PlanetRadius, const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix) const
+{
+	if (ProgramId == 0)
+	{
+		return;
+	}
+
+	const glm::mat4 ShellMatrix = glm::scale(PlanetModelMatrix, glm::vec3{ Params.TopRadius });
+	const glm::vec3 PlanetCenter = ViewMatrix * PlanetModelMatrix[3];
+
+	glUseProgram(ProgramId);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "ModelViewMatrix"), 1, GL_FALSE, glm::value_ptr(ViewMatrix * ShellMatrix));
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "ModelViewProjection"), 1, GL_FALSE, glm::value_ptr(ViewProjectionMatrix * ShellMatrix));
+	glUniform4fv(glGetUniformLocation(ProgramId, "PlanetSphere"), 1, glm::value_ptr(glm::vec4{ PlanetCenter, PlanetRadius }));
+	glUniform1f(glGetUniformLocation(ProgramId, "TopRadius"), Params.TopRadius);
+	glUniform3fv(glGetUniformLocation(ProgramId, "RayleighScattering"), 1, glm::value_ptr(Params.RayleighScattering));
+	glUniform3fv(glGetUniformLocation(ProgramId, "MieScattering"), 1, glm::value_ptr(Params.MieScattering));
+	glUniform1f(glGetUniformLocation(ProgramId, "MieAnisotropy"), Params.MieAnisotropy);
+	glUniform1i(glGetUniformLocation(ProgramId, "TransmittanceLUT"), 0);
+	glUniform1i(glGetUniformLocation(ProgramId, "ScatteringLUT"), 1);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, TransmittanceTextureId);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_3D, ScatteringTextureId);
+
+	// Cor final = luz espalhada + transmitância * cor que já estava na tela
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	// De fora da atmosfera a face da frente da casca fica na frente do
+	// planeta. De dentro só a face de trás existe, e ela fica atrás do chão.
+	const bool bCameraInside = glm::length(PlanetCenter) < PlanetRadius * Params.TopRadius;
+	if (bCameraInside)
+	{
+		glCullFace(GL_FRONT);
+		glDisable(GL_DEPTH_TEST);
+	}
+
+	glBindVertexArray(VertexArrayId);
+	glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, nullptr);
+	glBindVertexArray(0);
+
+	if (bCameraInside)
+	{
+		glCullFace(GL_BACK);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_3D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
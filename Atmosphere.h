@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Parâmetros físicos de uma atmosfera. Distâncias são medidas em raios do
+// planeta e os coeficientes de espalhamento por raio do planeta, então a
+// mesma atmosfera serve para qualquer escala do corpo.
+struct AtmosphereParams
+{
+	float TopRadius;
+	glm::vec3 RayleighScattering;
+	float RayleighScaleHeight;
+	glm::vec3 MieScattering;
+	float MieScaleHeight;
+	float MieAnisotropy;
+};
+
+// Tamanho das tabelas, iguais às constantes em atmosphere_frag.glsl
+namespace AtmosphereLUT
+{
+	constexpr int TransmittanceMuSize = 256;
+	constexpr int TransmittanceRSize = 64;
+
+	// A tabela de espalhamento é 4D (r, mu, mu_s, nu) guardada numa textura
+	// 3D com as fatias de nu lado a lado no eixo X
+	constexpr int ScatteringMuSSize = 32;
+	constexpr int ScatteringNuSize = 8;
+	constexpr int ScatteringMuSize = 128;
+	constexpr int ScatteringRSize = 32;
+
+	// Abaixo disso o Sol está bem abaixo do horizonte e não há espalhamento
+	constexpr float MinMuS = -0.2f;
+}
+
+// Atmosfera com espalhamento Rayleigh e Mie (espalhamento simples) no estilo
+// de Bruneton. A transmitância e o espalhamento são integrados na CPU uma
+// única vez, em várias threads, e guardados em cache/ com o hash dos
+// parâmetros no nome. Em tempo de execução o shader só consulta as tabelas.
+class Atmosphere
+{
+public:
+	void Create(const AtmosphereParams& Params);
+	void Release();
+
+	// Desenha a casca da atmosfera sobre o planeta já desenhado, atenuando o
+	// que está atrás e somando a luz espalhada
+	void Draw(GLuint ProgramId, const glm::mat4& PlanetModelMatrix, float PlanetRadius, const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix) const;
+
+private:
+	AtmosphereParams Params = {};
+
+	GLuint TransmittanceTextureId = 0;
+	GLuint ScatteringTextureId = 0;
+
+	GLuint VertexArrayId = 0;
+	GLuint VertexBuffer = 0;
+	GLuint ElementBuffer = 0;
+	GLsizei IndexCount = 0;
+};
+
+// Integra as duas tabelas. Transmittance tem RGB por texel e Scattering tem
+// Rayleigh em RGB e o canal vermelho do Mie em A.
+void PrecomputeAtmosphere(const AtmosphereParams& Params, std::vector<float>& Transmittance, std::vector<float>& Scattering);
@@ -0,0 +1,249 @@
+#include "BodyTransforms.h"
+
+#include "SimdMath.h"
+
+namespace
+{
+#if SIMD_MATH_SSE
+	// Uma matriz 4x4 de quatro corpos, um por lane: Elements[Coluna * 4 + Linha]
+	struct MatrixLanes
+	{
+		__m128 Elements[16];
+	};
+
+	// Out = A * Model, com A igual para todos os corpos (cada elemento de A
+	// repetido nas quatro lanes). A última linha do modelo é (0, 0, 0, 1),
+	// então esses termos não são multiplicados.
+	void MultiplyModel(const __m128* A, const MatrixLanes& Model, MatrixLanes& Out)
+	{
+		using namespace SimdMathDetail;
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			const __m128* ModelColumn = &Model.Elements[Column * 4];
+			for (int Row = 0; Row < 4; ++Row)
+			{
+				__m128 Sum = _mm_mul_ps(A[Row], ModelColumn[0]);
+				Sum = MultiplyAdd(A[4 + Row], ModelColumn[1], Sum);
+				Sum = MultiplyAdd(A[8 + Row], ModelColumn[2], Sum);
+				Out.Elements[Column * 4 + Row] = Column == 3 ? _mm_add_ps(Sum, A[12 + Row]) : Sum;
+			}
+		}
+	}
+
+	// Columns[Corpo][Coluna] com as colunas de cada corpo, prontas para gravar
+	void TransposeLanes(const MatrixLanes& M, int NumColumns, __m128 Columns[4][4])
+	{
+		for (int Column = 0; Column < NumColumns; ++Column)
+		{
+			__m128 Row0 = M.Elements[Column * 4];
+			__m128 Row1 = M.Elements[Column * 4 + 1];
+			__m128 Row2 = M.Elements[Column * 4 + 2];
+			__m128 Row3 = M.Elements[Column * 4 + 3];
+			_MM_TRANSPOSE4_PS(Row0, Row1, Row2, Row3);
+			Columns[0][Column] = Row0;
+			Columns[1][Column] = Row1;
+			Columns[2][Column] = Row2;
+			Columns[3][Column] = Row3;
+		}
+	}
+
+	void BroadcastMatrix(const glm::mat4& M, __m128 Out[16])
+	{
+		const float* Elements = &M[0][0];
+		for (int Index = 0; Index < 16; ++Index)
+		{
+			Out[Index] = _mm_set1_ps(Elements[Index]);
+		}
+	}
+#endif
+}
+
+void BodyTransforms::Resize(size_t InNumBodies)
+{
+	NumBodies = InNumBodies;
+
+	const size_t PaddedSize = (NumBodies + 3) / 4 * 4;
+	PositionsX.assign(PaddedSize, 0.0f);
+	PositionsY.assign(PaddedSize, 0.0f);
+	PositionsZ.assign(PaddedSize, 0.0f);
+	RotationsX.assign(PaddedSize, 0.0f);
+	RotationsY.assign(PaddedSize, 0.0f);
+	RotationsZ.assign(PaddedSize, 0.0f);
+	RotationsW.assign(PaddedSize, 1.0f);
+	Scales.assign(PaddedSize, 0.0f);
+
+	ModelMatrices.resize(NumBodies);
+}
+
+void BodyTransforms::SetTransform(size_t BodyIndex, const glm::vec3& Position, const glm::quat& Rotation, float Scale)
+{
+	PositionsX[BodyIndex] = Position.x;
+	PositionsY[BodyIndex] = Position.y;
+	PositionsZ[BodyIndex] = Position.z;
+	RotationsX[BodyIndex] = Rotation.x;
+	RotationsY[BodyIndex] = Rotation.y;
+	RotationsZ[BodyIndex] = Rotation.z;
+	RotationsW[BodyIndex] = Rotation.w;
+	Scales[BodyIndex] = Scale;
+}
+
+glm::mat4 BodyTransforms::ComputeModelMatrix(size_t BodyIndex) const
+{
+	const glm::quat Rotation{ RotationsW[BodyIndex], RotationsX[BodyIndex], RotationsY[BodyIndex], RotationsZ[BodyIndex] };
+	glm::mat4 ModelMatrix = glm::mat4_cast(Rotation) * Scales[BodyIndex];
+	ModelMatrix[3] = glm::vec4{ GetPosition(BodyIndex), 1.0f };
+	return ModelMatrix;
+}
+
+void BodyTransforms::Update(const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix, const glm::vec4* TextureLayers, InstanceData* Instances, const uint32_t* InstanceSlots)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+
+	__m128 View[16];
+	__m128 ViewProjection[16];
+	BroadcastMatrix(ViewMatrix, View);
+	BroadcastMatrix(ViewProjectionMatrix, ViewProjection);
+
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Two = _mm_set1_ps(2.0f);
+
+	MatrixLanes Model;
+	MatrixLanes ModelView;
+	MatrixLanes ModelViewProjection;
+	MatrixLanes Normal;
+	__m128 Columns[4][4];
+
+	for (size_t FirstBody = 0; FirstBody < NumBodies; FirstBody += 4)
+	{
+		const size_t NumLanes = NumBodies - FirstBody < 4 ? NumBodies - FirstBody : 4;
+
+		// Rotação do quaternion como em glm::mat3_cast, já multiplicada pela escala
+		const __m128 X = _mm_loadu_ps(&RotationsX[FirstBody]);
+		const __m128 Y = _mm_loadu_ps(&RotationsY[FirstBody]);
+		const __m128 Z = _mm_loadu_ps(&RotationsZ[FirstBody]);
+		const __m128 W = _mm_loadu_ps(&RotationsW[FirstBody]);
+		const __m128 Scale = _mm_loadu_ps(&Scales[FirstBody]);
+		const __m128 TwoScale = _mm_mul_ps(Two, Scale);
+
+		const __m128 XX = _mm_mul_ps(X, X);
+		const __m128 YY = _mm_mul_ps(Y, Y);
+		const __m128 ZZ = _mm_mul_ps(Z, Z);
+		const __m128 XY = _mm_mul_ps(X, Y);
+		const __m128 XZ = _mm_mul_ps(X, Z);
+		const __m128 YZ = _mm_mul_ps(Y, Z);
+		const __m128 WX = _mm_mul_ps(W, X);
+		const __m128 WY = _mm_mul_ps(W, Y);
+		const __m128 WZ = _mm_mul_ps(W, Z);
+
+		Model.Elements[0] = _mm_sub_ps(Scale, _mm_mul_ps(TwoScale, _mm_add_ps(YY, ZZ)));
+		Model.Elements[1] = _mm_mul_ps(TwoScale, _mm_add_ps(XY, WZ));
+		Model.Elements[2] = _mm_mul_ps(TwoScale, _mm_sub_ps(XZ, WY));
+		Model.Elements[3] = Zero;
+		Model.Elements[4] = _mm_mul_ps(TwoScale, _mm_sub_ps(XY, WZ));
+		Model.Elements[5] = _mm_sub_ps(Scale, _mm_mul_ps(TwoScale, _mm_add_ps(XX, ZZ)));
+		Model.Elements[6] = _mm_mul_ps(TwoScale, _mm_add_ps(YZ, WX));
+		Model.Elements[7] = Zero;
+		Model.Elements[8] = _mm_mul_ps(TwoScale, _mm_add_ps(XZ, WY));
+		Model.Elements[9] = _mm_mul_ps(TwoScale, _mm_sub_ps(YZ, WX));
+		Model.Elements[10] = _mm_sub_ps(Scale, _mm_mul_ps(TwoScale, _mm_add_ps(XX, YY)));
+		Model.Elements[11] = Zero;
+		Model.Elements[12] = _mm_loadu_ps(&PositionsX[FirstBody]);
+		Model.Elements[13] = _mm_loadu_ps(&PositionsY[FirstBody]);
+		Model.Elements[14] = _mm_loadu_ps(&PositionsZ[FirstBody]);
+		Model.Elements[15] = One;
+
+		TransposeLanes(Model, 4, Columns);
+		for (size_t Lane = 0; Lane < NumLanes; ++Lane)
+		{
+			float* ModelMatrix = &ModelMatrices[FirstBody + Lane][0][0];
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				_mm_storeu_ps(ModelMatrix + Column * 4, Columns[Lane][Column]);
+			}
+		}
+
+		if (!Instances)
+		{
+			continue;
+		}
+
+		MultiplyModel(View, Model, ModelView);
+		MultiplyModel(ViewProjection, Model, ModelViewProjection);
+
+		// A parte 3x3 da ModelView é s * R, e a inversa transposta é R / s
+		const __m128 ScaleSquared = MultiplyAdd(ModelView.Elements[2], ModelView.Elements[2], MultiplyAdd(ModelView.Elements[1], ModelView.Elements[1], _mm_mul_ps(ModelView.Elements[0], ModelView.Elements[0])));
+		const __m128 InverseScaleSquared = _mm_div_ps(One, ScaleSquared);
+		for (int Column = 0; Column < 3; ++Column)
+		{
+			Normal.Elements[Column * 4] = _mm_mul_ps(ModelView.Elements[Column * 4], InverseScaleSquared);
+			Normal.Elements[Column * 4 + 1] = _mm_mul_ps(ModelView.Elements[Column * 4 + 1], InverseScaleSquared);
+			Normal.Elements[Column * 4 + 2] = _mm_mul_ps(ModelView.Elements[Column * 4 + 2], InverseScaleSquared);
+			Normal.Elements[Column * 4 + 3] = Zero;
+		}
+
+		// Cada InstanceData é gravado inteiro e em ordem, porque o destino
+		// costuma ser a memória mapeada do ring buffer (write-combined)
+		__m128 ModelViewColumns[4][4];
+		__m128 ModelViewProjectionColumns[4][4];
+		__m128 NormalColumns[4][4];
+		TransposeLanes(ModelView, 4, ModelViewColumns);
+		TransposeLanes(ModelViewProjection, 4, ModelViewProjectionColumns);
+		TransposeLanes(Normal, 3, NormalColumns);
+
+		for (size_t Lane = 0; Lane < NumLanes; ++Lane)
+		{
+			const size_t BodyIndex = FirstBody + Lane;
+			const uint32_t Slot = InstanceSlots ? InstanceSlots[BodyIndex] : static_cast<uint32_t>(BodyIndex);
+			if (Slot == InvalidSlot)
+			{
+				continue;
+			}
+
+			InstanceData& Instance = Instances[Slot];
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				_mm_storeu_ps(&Instance.ModelViewMatrix[Column][0], ModelViewColumns[Lane][Column]);
+			}
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				_mm_storeu_ps(&Instance.ModelViewProjection[Column][0], ModelViewProjectionColumns[Lane][Column]);
+			}
+			for (int Column = 0; Column < 3; ++Column)
+			{
+				_mm_storeu_ps(&Instance.NormalMatrix[Column][0], NormalColumns[Lane][Column]);
+			}
+			_mm_storeu_ps(&Instance.TextureLayers[0], _mm_loadu_ps(&TextureLayers[BodyIndex][0]));
+		}
+	}
+#else
+	for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+	{
+		ModelMatrices[BodyIndex] = ComputeModelMatrix(BodyIndex);
+
+		const uint32_t Slot = InstanceSlots ? InstanceSlots[BodyIndex] : static_cast<uint32_t>(BodyIndex);
+		if (Instances && Slot != InvalidSlot)
+		{
+			WriteInstanceData(Instances[Slot], TextureLayers[BodyIndex], ModelMatrices[BodyIndex], ViewMatrix, ViewProjectionMatrix);
+		}
+	}
+#endif
+}
+
+void WriteInstanceData(InstanceData& Instance, const glm::vec4& TextureLayers, const glm::mat4& ModelMatrix, const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix)
+{
+	const glm::mat4 ModelViewMatrix = ViewMatrix * ModelMatrix;
+
+	// Com escala uniforme a inversa transposta da parte 3x3 é ela mesma
+	// dividida pelo quadrado da escala
+	const glm::vec3 Column0{ ModelViewMatrix[0] };
+	const float InverseScaleSquared = 1.0f / glm::dot(Column0, Column0);
+
+	Instance.ModelViewMatrix = ModelViewMatrix;
+	Instance.ModelViewProjection = ViewProjectionMatrix * ModelMatrix;
+	Instance.NormalMatrix[0] = glm::vec4{ Column0 * InverseScaleSquared, 0.0f };
+	Instance.NormalMatrix[1] = glm::vec4{ glm::vec3{ ModelViewMatrix[1] } * InverseScaleSquared, 0.0f };
+	Instance.NormalMatrix[2] = glm::vec4{ glm::vec3{ ModelViewMatrix[2] } * InverseScaleSquared, 0.0f };
+	Instance.TextureLayers = TextureLayers;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "ShaderData.h"
+
+// Posição, rotação e escala de todos os corpos em structure of arrays. Uma
+// única passada monta a matriz de modelo e o InstanceData (ModelView, MVP e
+// NormalMatrix) de quatro corpos por vez com SSE, sem as cadeias de
+// glm::rotate, glm::translate e glm::scale e sem a inversa geral: a escala
+// é uniforme, então a NormalMatrix é a ModelView dividida pelo quadrado da
+// escala.
+class BodyTransforms
+{
+public:
+	// Corpo sem instância no frame, só a matriz de modelo é calculada
+	static constexpr uint32_t InvalidSlot = ~0u;
+
+	void Resize(size_t NumBodies);
+	size_t GetNumBodies() const { return NumBodies; }
+
+	// Rotation precisa estar normalizada
+	void SetTransform(size_t BodyIndex, const glm::vec3& Position, const glm::quat& Rotation, float Scale);
+
+	glm::vec3 GetPosition(size_t BodyIndex) const { return glm::vec3{ PositionsX[BodyIndex], PositionsY[BodyIndex], PositionsZ[BodyIndex] }; }
+
+	// Matriz de modelo de um corpo fora da passada, com as transformações já gravadas
+	glm::mat4 ComputeModelMatrix(size_t BodyIndex) const;
+
+	// A passada sobre todos os corpos. Grava as matrizes de modelo e, se
+	// Instances não for nulo, o InstanceData de cada corpo em
+	// Instances[InstanceSlots[Corpo]], ou em Instances[Corpo] sem InstanceSlots.
+	void Update(const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix, const glm::vec4* TextureLayers, InstanceData* Instances, const uint32_t* InstanceSlots = nullptr);
+
+	// Calculadas pelo último Update
+	const std::vector<glm::mat4>& GetModelMatrices() const { return ModelMatrices; }
+
+private:
+	size_t NumBodies = 0;
+
+	// Com tamanho múltiplo de 4. Os corpos que sobram no último grupo têm
+	// escala zero e nunca são gravados.
+	std::vector<float> PositionsX;
+	std::vector<float> PositionsY;
+	std::vector<float> PositionsZ;
+	std::vector<float> RotationsX;
+	std::vector<float> RotationsY;
+	std::vector<float> RotationsZ;
+	std::vector<float> RotationsW;
+	std::vector<float> Scales;
+
+	std::vector<glm::mat4> ModelMatrices;
+};
+
+// InstanceData de um único corpo, para o terreno e para o caminho sem SSE.
+// ModelMatrix precisa ter escala uniforme.
+void WriteInstanceData(InstanceData& Instance, const glm::vec4& TextureLayers, const glm::mat4& ModelMatrix, const glm::mat4& ViewMatrix, const glm::mat4& ViewProjectionMatrix);
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "deps/stb/stb_image.h"
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "deps/stb/stb_image_resize.h"
+#define STB_DXT_IMPLEMENTATION
+#include "deps/stb/stb_dxt.h"
+
+#include "AssetPackFormat.h"
+#include "Mesh.h"
+
+// Junta shaders e texturas num único pacote lido pelo AssetPack, junto com a
+// malha da esfera já gerada. As imagens são decodificadas aqui: as que vêm
+// depois de --bc1 são comprimidas em BC1 com todos os mips, as outras ficam
+// em RGB8 (o panorama do fundo precisa dos texels na CPU). Os caminhos são
+// guardados como foram passados, então a ferramenta roda na raiz do projeto.
+//
+// Uso: BuildAssetPack assets.bmpak shaders/*.glsl textures/fundo_via_lactea.jpg --bc1 textures/terra.jpg ...
+
+namespace
+{
+	struct PackedAsset
+	{
+		AssetEntry Entry;
+		std::vector<unsigned char> Data;
+	};
+
+	bool IsImageFile(const std::string& FilePath)
+	{
+		const size_t Dot = FilePath.find_last_of('.');
+		const std::string Extension = Dot == std::string::npos ? std::string{} : FilePath.substr(Dot);
+		return Extension == ".jpg" || Extension == ".jpeg" || Extension == ".png" || Extension == ".tga" || Extension == ".bmp";
+	}
+
+	void AppendBytes(std::vector<unsigned char>& Data, const void* Bytes, size_t Size)
+	{
+		const unsigned char* First = static_cast<const unsigned char*>(Bytes);
+		Data.insert(Data.end(), First, First + Size);
+	}
+
+	// Comprime um mip RGB em blocos BC1, repetindo os texels da borda nos
+	// blocos que passam do tamanho da imagem
+	void CompressBC1(const unsigned char* Pixels, int Width, int Height, std::vector<unsigned char>& Data)
+	{
+		unsigned char Block[4 * 4 * 4];
+		unsigned char CompressedBlock[8];
+		for (int BlockY = 0; BlockY < Height; BlockY += 4)
+		{
+			for (int BlockX = 0; BlockX < Width; BlockX += 4)
+			{
+				for (int Y = 0; Y < 4; ++Y)
+				{
+					for (int X = 0; X < 4; ++X)
+					{
+						const int SourceX = std::min(BlockX + X, Width - 1);
+						const int SourceY = std::min(BlockY + Y, Height - 1);
+						std::memcpy(&Block[(Y * 4 + X) * 4], &Pixels[(static_cast<size_t>(SourceY) * Width + SourceX) * 3], 3);
+						Block[(Y * 4 + X) * 4 + 3] = 255;
+					}
+				}
+				stb_compress_dxt_block(CompressedBlock, Block, 0, STB_DXT_HIGHQUAL);
+				AppendBytes(Data, CompressedBlock, sizeof(CompressedBlock));
+			}
+		}
+	}
+
+	bool PackImage(const std::string& FilePath, bool bCompress, PackedAsset& Asset)
+	{
+		int Width = 0;
+		int Height = 0;
+		int NumComponents = 0;
+		unsigned char* Pixels = stbi_load(FilePath.c_str(), &Width, &Height, &NumComponents, 3);
+		if (!Pixels)
+		{
+			return false;
+		}
+
+		Asset.Entry.Type = EAssetType::Texture;
+		Asset.Entry.Dimensions[0] = Width;
+		Asset.Entry.Dimensions[1] = Height;
+
+		if (!bCompress)
+		{
+			Asset.Entry.Format = ETextureFormat::RGB8;
+			Asset.Entry.Dimensions[2] = 1;
+			AppendBytes(Asset.Data, Pixels, static_cast<size_t>(Width) * Height * 3);
+			stbi_image_free(Pixels);
+			return true;
+		}
+
+		// Os mips são gerados aqui porque o glGenerateMipmap não funciona com
+		// texturas comprimidas
+		Asset.Entry.Format = ETextureFormat::BC1;
+		Asset.Entry.Dimensions[2] = 0;
+
+		std::vector<unsigned char> Level(Pixels, Pixels + static_cast<size_t>(Width) * Height * 3);
+		stbi_image_free(Pixels);
+
+		for (;;)
+		{
+			CompressBC1(Level.data(), Width, Height, Asset.Data);
+			Asset.Entry.Dimensions[2]++;
+
+			if (Width == 1 && Height == 1)
+			{
+				break;
+			}
+
+			const int NextWidth = std::max(Width / 2, 1);
+			const int NextHeight = std::max(Height / 2, 1);
+			std::vector<unsigned char> NextLevel(static_cast<size_t>(NextWidth) * NextHeight * 3);
+			stbir_resize_uint8(Level.data(), Width, Height, 0, NextLevel.data(), NextWidth, NextHeight, 0, 3);
+
+			Level.swap(NextLevel);
+			Width = NextWidth;
+			Height = NextHeight;
+		}
+		return true;
+	}
+
+	bool PackRawFile(const std::string& FilePath, PackedAsset& Asset)
+	{
+		std::ifstream File{ FilePath, std::ios::binary };
+		if (!File)
+		{
+			return false;
+		}
+
+		Asset.Entry.Type = EAssetType::Raw;
+		Asset.Data.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	// Os mesmos níveis de detalhe que o main gera quando não há pacote
+	void PackSphereMesh(PackedAsset& Asset)
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<Triangle> Indices;
+		MeshSection Sections[SphereLOD::Count];
+
+		std::vector<Vertex> LODVertices;
+		std::vector<Triangle> LODIndices;
+		for (int LOD = 0; LOD < SphereLOD::Count; ++LOD)
+		{
+			GenerateSphere(SphereLOD::Resolutions[LOD], LODVertices, LODIndices);
+			Sections[LOD] = AppendMesh(LODVertices, LODIndices, Vertices, Indices);
+		}
+
+		Asset.Entry.Type = EAssetType::Mesh;
+		Asset.Entry.Dimensions[0] = static_cast<uint32_t>(Vertices.size());
+		Asset.Entry.Dimensions[1] = static_cast<uint32_t>(Indices.size());
+		Asset.Entry.Dimensions[2] = SphereLOD::Count;
+
+		AppendBytes(Asset.Data, Sections, sizeof(Sections));
+		AppendBytes(Asset.Data, Vertices.data(), Vertices.size() * sizeof(Vertex));
+		AppendBytes(Asset.Data, Indices.data(), Indices.size() * sizeof(Triangle));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "Uso: BuildAssetPack <saida.bmpak> [--bc1] <arquivos>..." << std::endl;
+		return 1;
+	}
+
+	std::vector<PackedAsset> Assets;
+	bool bCompress = false;
+
+	for (int ArgIndex = 2; ArgIndex < argc; ++ArgIndex)
+	{
+		const std::string FilePath = argv[ArgIndex];
+		if (FilePath == "--bc1")
+		{
+			bCompress = true;
+			continue;
+		}
+
+		if (FilePath.size() >= AssetPackFormat::MaxNameLength)
+		{
+			std::cout << "Caminho muito longo: " << FilePath << std::endl;
+			return 1;
+		}
+
+		PackedAsset Asset = {};
+		std::strncpy(Asset.Entry.Name, FilePath.c_str(), AssetPackFormat::MaxNameLength - 1);
+
+		const bool bPacked = IsImageFile(FilePath) ? PackImage(FilePath, bCompress, Asset) : PackRawFile(FilePath, Asset);
+		if (!bPacked)
+		{
+			std::cout << "Erro ao ler " << FilePath << std::endl;
+			return 1;
+		}
+
+		std::cout << FilePath << ": " << Asset.Data.size() << " bytes" << std::endl;
+		Assets.push_back(std::move(Asset));
+	}
+
+	PackedAsset SphereMesh = {};
+	std::strncpy(SphereMesh.Entry.Name, AssetPackFormat::SphereMeshName, AssetPackFormat::MaxNameLength - 1);
+	PackSphereMesh(SphereMesh);
+	Assets.push_back(std::move(SphereMesh));
+
+	// O AssetPack faz busca binária pelo nome
+	std::sort(Assets.begin(), Assets.end(), [](const PackedAsset& A, const PackedAsset& B) { return std::strcmp(A.Entry.Name, B.Entry.Name) < 0; });
+	for (size_t AssetIndex = 1; AssetIndex < Assets.size(); ++AssetIndex)
+	{
+		if (std::strcmp(Assets[AssetIndex - 1].Entry.Name, Assets[AssetIndex].Entry.Name) == 0)
+		{
+			std::cout << "Arquivo repetido: " << Assets[AssetIndex].Entry.Name << std::endl;
+			return 1;
+		}
+	}
+
+	auto Align = [](uint64_t Offset) { return (Offset + AssetPackFormat::BlobAlignment - 1) / AssetPackFormat::BlobAlignment * AssetPackFormat::BlobAlignment; };
+
+	uint64_t Offset = sizeof(AssetPackHeader) + Assets.size() * sizeof(AssetEntry);
+	for (PackedAsset& Asset : Assets)
+	{
+		Offset = Align(Offset);
+		Asset.Entry.Offset = Offset;
+		Asset.Entry.Size = Asset.Data.size();
+		Offset += Asset.Data.size();
+	}
+
+	std::FILE* Output = std::fopen(argv[1], "wb");
+	if (!Output)
+	{
+		std::cout << "Erro ao criar " << argv[1] << std::endl;
+		return 1;
+	}
+
+	AssetPackHeader Header = {};
+	std::memcpy(Header.Magic, AssetPackFormat::Magic, sizeof(Header.Magic));
+	Header.Version = AssetPackFormat::Version;
+	Header.NumEntries = static_cast<uint32_t>(Assets.size());
+	std::fwrite(&Header, sizeof(Header), 1, Output);
+
+	for (const PackedAsset& Asset : Assets)
+	{
+		std::fwrite(&Asset.Entry, sizeof(Asset.Entry), 1, Output);
+	}
+
+	const unsigned char Padding[AssetPackFormat::BlobAlignment] = {};
+	uint64_t Written = sizeof(AssetPackHeader) + Assets.size() * sizeof(AssetEntry);
+	for (const PackedAsset& Asset : Assets)
+	{
+		std::fwrite(Padding, 1, Asset.Entry.Offset - Written, Output);
+		std::fwrite(Asset.Data.data(), 1, Asset.Data.size(), Output);
+		Written = Asset.Entry.Offset + Asset.Data.size();
+	}
+
+	const bool bWriteFailed = std::ferror(Output) != 0;
+	std::fclose(Output);
+	if (bWriteFailed)
+	{
+		std::cout << "Erro ao escrever " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::cout << "Pacote salvo em " << argv[1] << " com " << Assets.size() << " arquivos, " << Written << " bytes" << std::endl;
+	return 0;
+}
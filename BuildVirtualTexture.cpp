@@ -0,0 +1,450 @@
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "deps/stb/stb_image.h"
+
+#include "VirtualTextureFormat.h"
+
+// Divide o mapa de um planeta (projeção equirretangular) nos tiles da
+// pirâmide de mips de uma textura virtual, num único pacote lido pelo
+// VirtualTextureCache. A imagem é ajustada para dimensões potência de 2 e a
+// borda dos tiles dá a volta na longitude, como o mapa na esfera.
+//
+// O stb_image recusa imagens com largura * altura * 4 a partir de 2 GB, o
+// que deixa de fora mapas de 32k x 16k em diante. Esses mapas entram como
+// uma grade de imagens do mesmo tamanho, em ordem de linhas a partir do canto
+// de cima à esquerda, cada uma abaixo do limite. O mapa nunca fica inteiro
+// na memória: as linhas são lidas de cima para baixo, uma linha da grade por
+// vez, e cada nível da pirâmide só guarda as linhas de uma linha de tiles.
+//
+// Uso: BuildVirtualTexture terra_16k.jpg textures/terra.bmvt
+//      BuildVirtualTexture --grade 4x2 terra_a1.png ... terra_d2.png textures/terra.bmvt
+
+namespace
+{
+	int NearestPowerOfTwo(int Value)
+	{
+		int Power = VirtualTextureFormat::TileSize;
+		while (Power * 3 / 2 < Value)
+		{
+			Power *= 2;
+		}
+		return Power;
+	}
+
+	// Offsets de pacotes de mais de 2 GB
+	bool SeekTo(std::FILE* File, uint64_t Offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(File, static_cast<__int64>(Offset), SEEK_SET) == 0;
+#else
+		return fseeko(File, static_cast<off_t>(Offset), SEEK_SET) == 0;
+#endif
+	}
+
+	// Grade de imagens lidas como um mapa só. Só a linha da grade que contém
+	// a linha pedida fica carregada.
+	class SourceGrid
+	{
+	public:
+		~SourceGrid() { FreeImages(); }
+
+		bool Open(int InColumns, int InRows, std::vector<std::string> InFiles)
+		{
+			Columns = InColumns;
+			Rows = InRows;
+			Files = std::move(InFiles);
+
+			for (const std::string& File : Files)
+			{
+				int FileWidth = 0;
+				int FileHeight = 0;
+				int NumComponents = 0;
+				if (!stbi_info(File.c_str(), &FileWidth, &FileHeight, &NumComponents))
+				{
+					std::cout << "Erro ao carregar " << File << std::endl;
+					return false;
+				}
+
+				if (static_cast<int64_t>(FileWidth) * FileHeight * 4 >= INT_MAX)
+				{
+					std::cout << File << " tem " << FileWidth << "x" << FileHeight << ", acima do limite de 2 GB em RGBA por imagem: divida o mapa com --grade" << std::endl;
+					return false;
+				}
+
+				if (&File == &Files.front())
+				{
+					ImageWidth = FileWidth;
+					ImageHeight = FileHeight;
+				}
+				else if (FileWidth != ImageWidth || FileHeight != ImageHeight)
+				{
+					std::cout << "As imagens da grade precisam ter o mesmo tamanho: " << File << " tem " << FileWidth << "x" << FileHeight << std::endl;
+					return false;
+				}
+			}
+
+			Images.resize(Columns, nullptr);
+			return true;
+		}
+
+		int GetWidth() const { return Columns * ImageWidth; }
+		int GetHeight() const { return Rows * ImageHeight; }
+
+		// Copia a linha Y do mapa inteiro, em RGBA. Voltar para uma linha da
+		// grade anterior carrega as imagens de novo, então Y deve crescer.
+		bool CopyRow(int Y, unsigned char* Destination)
+		{
+			const int GridRow = Y / ImageHeight;
+			if (GridRow != LoadedRow && !LoadRow(GridRow))
+			{
+				return false;
+			}
+
+			const size_t ImageRowBytes = static_cast<size_t>(ImageWidth) * 4;
+			for (int Column = 0; Column < Columns; ++Column)
+			{
+				std::memcpy(Destination + Column * ImageRowBytes, Images[Column] + static_cast<size_t>(Y % ImageHeight) * ImageRowBytes, ImageRowBytes);
+			}
+			return true;
+		}
+
+	private:
+		bool LoadRow(int GridRow)
+		{
+			FreeImages();
+			for (int Column = 0; Column < Columns; ++Column)
+			{
+				const std::string& File = Files[static_cast<size_t>(GridRow) * Columns + Column];
+				int FileWidth = 0;
+				int FileHeight = 0;
+				int NumComponents = 0;
+				Images[Column] = stbi_load(File.c_str(), &FileWidth, &FileHeight, &NumComponents, 4);
+				if (!Images[Column])
+				{
+					std::cout << "Erro ao carregar " << File << ": " << stbi_failure_reason() << std::endl;
+					return false;
+				}
+			}
+			LoadedRow = GridRow;
+			return true;
+		}
+
+		void FreeImages()
+		{
+			for (unsigned char*& Image : Images)
+			{
+				stbi_image_free(Image);
+				Image = nullptr;
+			}
+			LoadedRow = -1;
+		}
+
+		int Columns = 0;
+		int Rows = 0;
+		int ImageWidth = 0;
+		int ImageHeight = 0;
+		std::vector<std::string> Files;
+		std::vector<unsigned char*> Images;
+		int LoadedRow = -1;
+	};
+
+	// Linhas do mapa no tamanho potência de 2, com interpolação bilinear
+	// quando o tamanho muda. Guarda as duas últimas linhas lidas, que são as
+	// usadas pela linha seguinte.
+	class RowResampler
+	{
+	public:
+		RowResampler(SourceGrid& InSource, int InWidth, int InHeight)
+			: Source(InSource)
+			, Width(InWidth)
+			, Height(InHeight)
+			, SourceWidth(InSource.GetWidth())
+			, SourceHeight(InSource.GetHeight())
+		{
+			for (int Index = 0; Index < 2; ++Index)
+			{
+				CachedRows[Index].resize(static_cast<size_t>(SourceWidth) * 4);
+			}
+		}
+
+		bool GetRow(int Y, unsigned char* Destination)
+		{
+			if (Width == SourceWidth && Height == SourceHeight)
+			{
+				return Source.CopyRow(Y, Destination);
+			}
+
+			const float SourceY = glm::clamp((Y + 0.5f) * SourceHeight / Height - 0.5f, 0.0f, static_cast<float>(SourceHeight - 1));
+			const int Y0 = static_cast<int>(SourceY);
+			const int Y1 = glm::min(Y0 + 1, SourceHeight - 1);
+			const float FractionY = SourceY - Y0;
+
+			const unsigned char* Row0 = GetSourceRow(Y0);
+			const unsigned char* Row1 = GetSourceRow(Y1);
+			if (!Row0 || !Row1)
+			{
+				return false;
+			}
+
+			for (int X = 0; X < Width; ++X)
+			{
+				// Na horizontal o mapa dá a volta na longitude
+				const float SourceX = (X + 0.5f) * SourceWidth / Width - 0.5f;
+				const int X0 = static_cast<int>(glm::floor(SourceX));
+				const float FractionX = SourceX - X0;
+				const size_t Left = static_cast<size_t>((X0 + SourceWidth) % SourceWidth) * 4;
+				const size_t Right = static_cast<size_t>((X0 + 1) % SourceWidth) * 4;
+
+				for (int Channel = 0; Channel < 4; ++Channel)
+				{
+					const float Top = glm::mix(static_cast<float>(Row0[Left + Channel]), static_cast<float>(Row0[Right + Channel]), FractionX);
+					const float Bottom = glm::mix(static_cast<float>(Row1[Left + Channel]), static_cast<float>(Row1[Right + Channel]), FractionX);
+					Destination[static_cast<size_t>(X) * 4 + Channel] = static_cast<unsigned char>(glm::mix(Top, Bottom, FractionY) + 0.5f);
+				}
+			}
+			return true;
+		}
+
+	private:
+		const unsigned char* GetSourceRow(int Y)
+		{
+			for (int Index = 0; Index < 2; ++Index)
+			{
+				if (CachedRowIndex[Index] == Y)
+				{
+					return CachedRows[Index].data();
+				}
+			}
+
+			// Substitui a linha mais antiga
+			const int Index = CachedRowIndex[0] < CachedRowIndex[1] ? 0 : 1;
+			if (!Source.CopyRow(Y, CachedRows[Index].data()))
+			{
+				return nullptr;
+			}
+			CachedRowIndex[Index] = Y;
+			return CachedRows[Index].data();
+		}
+
+		SourceGrid& Source;
+		int Width;
+		int Height;
+		int SourceWidth;
+		int SourceHeight;
+		std::vector<unsigned char> CachedRows[2];
+		int CachedRowIndex[2] = { -1, -1 };
+	};
+
+	// Um nível da pirâmide montado por faixas. As linhas chegam de cima para
+	// baixo num anel com as PaddedTileSize últimas, que são as que uma linha de
+	// tiles lê com as bordas. Cada linha de tiles é gravada assim que a última
+	// linha dela chega, e cada par de linhas vira, com a média de 2x2 texels,
+	// uma linha do nível seguinte.
+	class LevelBuilder
+	{
+	public:
+		LevelBuilder(const VirtualTextureHeader& Header, int InLevel, int InWidth, int InHeight, std::FILE* InOutput, LevelBuilder* InNextLevel)
+			: Width(InWidth)
+			, Height(InHeight)
+			, Tiles(GetVirtualLevelTiles(Header, InLevel))
+			, FirstTile(GetVirtualLevelFirstTile(Header, InLevel))
+			, Output(InOutput)
+			, NextLevel(InNextLevel)
+			, Ring(static_cast<size_t>(VirtualTextureFormat::PaddedTileSize) * InWidth * 4)
+			, Tile(VirtualTextureFormat::TileBytes)
+		{
+		}
+
+		int GetWidth() const { return Width; }
+		int GetHeight() const { return Height; }
+
+		unsigned char* GetRingRow(int Y) { return &Ring[static_cast<size_t>(Y % VirtualTextureFormat::PaddedTileSize) * Width * 4]; }
+
+		// A linha Y já foi escrita em GetRingRow(Y)
+		bool AddRow(int Y)
+		{
+			using namespace VirtualTextureFormat;
+
+			if (NextLevel && Y % 2 == 1)
+			{
+				const unsigned char* Row0 = GetRingRow(Y - 1);
+				const unsigned char* Row1 = GetRingRow(Y);
+				unsigned char* Destination = NextLevel->GetRingRow(Y / 2);
+				for (int X = 0; X < Width / 2; ++X)
+				{
+					for (int Channel = 0; Channel < 4; ++Channel)
+					{
+						const size_t Left = static_cast<size_t>(2 * X) * 4 + Channel;
+						const int Sum = Row0[Left] + Row0[Left + 4] + Row1[Left] + Row1[Left + 4];
+						Destination[static_cast<size_t>(X) * 4 + Channel] = static_cast<unsigned char>((Sum + 2) / 4);
+					}
+				}
+				if (!NextLevel->AddRow(Y / 2))
+				{
+					return false;
+				}
+			}
+
+			// A linha de tiles TileY vai até a linha TileY * TileSize +
+			// PaddedTileSize - TileBorder - 1, com a borda de baixo, ou até o
+			// fim do nível na última linha de tiles
+			if (Y == Height - 1)
+			{
+				return WriteTileRow(Tiles.y - 1);
+			}
+
+			const int RowsAfterBorder = Y + 1 + TileBorder - PaddedTileSize;
+			if (RowsAfterBorder >= 0 && RowsAfterBorder % TileSize == 0)
+			{
+				return WriteTileRow(RowsAfterBorder / TileSize);
+			}
+			return true;
+		}
+
+	private:
+		bool WriteTileRow(int TileY)
+		{
+			using namespace VirtualTextureFormat;
+
+			if (!SeekTo(Output, GetVirtualTileOffset(FirstTile + static_cast<uint32_t>(TileY * Tiles.x))))
+			{
+				return false;
+			}
+
+			for (int TileX = 0; TileX < Tiles.x; ++TileX)
+			{
+				for (int Y = 0; Y < PaddedTileSize; ++Y)
+				{
+					// A borda repete o texel da ponta nos polos e dá a volta na longitude
+					const int SourceY = glm::clamp(TileY * TileSize + Y - TileBorder, 0, Height - 1);
+					const unsigned char* Row = GetRingRow(SourceY);
+					for (int X = 0; X < PaddedTileSize; ++X)
+					{
+						const int SourceX = (TileX * TileSize + X - TileBorder + Width) % Width;
+						std::memcpy(&Tile[(static_cast<size_t>(Y) * PaddedTileSize + X) * 4], &Row[static_cast<size_t>(SourceX) * 4], 4);
+					}
+				}
+
+				if (std::fwrite(Tile.data(), Tile.size(), 1, Output) != 1)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		int Width;
+		int Height;
+		glm::ivec2 Tiles;
+		uint32_t FirstTile;
+		std::FILE* Output;
+		LevelBuilder* NextLevel;
+		std::vector<unsigned char> Ring;
+		std::vector<unsigned char> Tile;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	using namespace VirtualTextureFormat;
+
+	// Uma imagem é uma grade de 1x1
+	int Columns = 1;
+	int Rows = 1;
+	int FirstFile = 1;
+	if (argc >= 2 && std::strcmp(argv[1], "--grade") == 0)
+	{
+		if (argc < 3 || std::sscanf(argv[2], "%dx%d", &Columns, &Rows) != 2 || Columns < 1 || Rows < 1)
+		{
+			std::cout << "A grade precisa ser <colunas>x<linhas>, como 4x2" << std::endl;
+			return 1;
+		}
+		FirstFile = 3;
+	}
+
+	if (argc != FirstFile + Columns * Rows + 1)
+	{
+		std::cout << "Uso: BuildVirtualTexture <mapa> <saida.bmvt>" << std::endl;
+		std::cout << "     BuildVirtualTexture --grade <colunas>x<linhas> <imagens em ordem de linhas> <saida.bmvt>" << std::endl;
+		return 1;
+	}
+	const char* OutputFile = argv[argc - 1];
+
+	SourceGrid Source;
+	if (!Source.Open(Columns, Rows, std::vector<std::string>(argv + FirstFile, argv + argc - 1)))
+	{
+		return 1;
+	}
+
+	const int SourceWidth = Source.GetWidth();
+	const int SourceHeight = Source.GetHeight();
+	const int Width = NearestPowerOfTwo(SourceWidth);
+	const int Height = NearestPowerOfTwo(SourceHeight);
+	if (Width != SourceWidth || Height != SourceHeight)
+	{
+		std::cout << "Redimensionando de " << SourceWidth << "x" << SourceHeight << " para " << Width << "x" << Height << std::endl;
+	}
+
+	VirtualTextureHeader Header = {};
+	std::memcpy(Header.Magic, Magic, sizeof(Magic));
+	Header.Version = Version;
+	Header.TilesX = Width / TileSize;
+	Header.TilesY = Height / TileSize;
+
+	// O último nível tem um tile na menor dimensão
+	Header.NumLevels = 1;
+	while ((glm::min(Width, Height) >> Header.NumLevels) >= TileSize)
+	{
+		Header.NumLevels++;
+	}
+
+	std::FILE* Output = std::fopen(OutputFile, "wb");
+	if (!Output)
+	{
+		std::cout << "Erro ao criar " << OutputFile << std::endl;
+		return 1;
+	}
+	std::fwrite(&Header, sizeof(Header), 1, Output);
+
+	// Do último nível para o primeiro, porque cada um aponta para o seguinte
+	std::vector<std::unique_ptr<LevelBuilder>> Levels(Header.NumLevels);
+	for (int LevelIndex = static_cast<int>(Header.NumLevels) - 1; LevelIndex >= 0; --LevelIndex)
+	{
+		LevelBuilder* NextLevel = LevelIndex + 1 < static_cast<int>(Header.NumLevels) ? Levels[LevelIndex + 1].get() : nullptr;
+		Levels[LevelIndex] = std::make_unique<LevelBuilder>(Header, LevelIndex, Width >> LevelIndex, Height >> LevelIndex, Output, NextLevel);
+	}
+
+	for (uint32_t LevelIndex = 0; LevelIndex < Header.NumLevels; ++LevelIndex)
+	{
+		const glm::ivec2 Tiles = GetVirtualLevelTiles(Header, LevelIndex);
+		std::cout << "Nivel " << LevelIndex << ": " << Levels[LevelIndex]->GetWidth() << "x" << Levels[LevelIndex]->GetHeight() << ", " << Tiles.x << "x" << Tiles.y << " tiles" << std::endl;
+	}
+
+	RowResampler Resampler{ Source, Width, Height };
+	bool bFailed = false;
+	for (int Y = 0; Y < Height && !bFailed; ++Y)
+	{
+		bFailed = !Resampler.GetRow(Y, Levels[0]->GetRingRow(Y)) || !Levels[0]->AddRow(Y);
+	}
+
+	const bool bWriteFailed = bFailed || std::ferror(Output) != 0;
+	std::fclose(Output);
+	if (bWriteFailed)
+	{
+		std::cout << "Erro ao escrever " << OutputFile << std::endl;
+		return 1;
+	}
+
+	std::cout << "Textura virtual salva em " << OutputFile << std::endl;
+	return 0;
+}
@@ -20,17 +20,16 @@ void SimpleCamera::MouseMove(float X, float Y)
 		glm::vec2 CurrentCursor{ X, Y };
 		glm::vec2 Delta = (CurrentCursor - PreviousCursor) / 10.0f;
 
-		if (glm::length(Delta) < 5.0f)
-		{
-			glm::vec3 Right = glm::cross(Direction, Up);
+		// Sem limite para o salto: os movimentos de um frame chegam somados,
+		// e o PreviousCursor começa na posição do clique
+		glm::vec3 Right = glm::cross(Direction, Up);
 
-			glm::mat4 RotationRight = glm::rotate(glm::identity<glm::mat4>(), glm::radians(-Delta.y), Right);
-			glm::mat4 RotationUp = glm::rotate(glm::identity<glm::mat4>(), glm::radians(-Delta.x), Up);
-			glm::mat4 Rotation = RotationRight * RotationUp;
+		glm::mat4 RotationRight = glm::rotate(glm::identity<glm::mat4>(), glm::radians(-Delta.y), Right);
+		glm::mat4 RotationUp = glm::rotate(glm::identity<glm::mat4>(), glm::radians(-Delta.x), Up);
+		glm::mat4 Rotation = RotationRight * RotationUp;
 
-			Up = Rotation * glm::vec4{ Up, 0.0f };
-			Direction = Rotation * glm::vec4{ Direction, 0.0f };
-		}
+		Up = Rotation * glm::vec4{ Up, 0.0f };
+		Direction = Rotation * glm::vec4{ Direction, 0.0f };
 
 		PreviousCursor = CurrentCursor;
 	}
@@ -54,4 +53,12 @@ glm::mat4 SimpleCamera::GetViewProjection()
 	glm::mat4 View = GetView();
 	glm::mat4 Projection = glm::perspective(FieldOfView, AspectRatio, Near, Far);
 	return Projection * View;
-}
\ No newline at end of file
+}
+
+glm::mat4 SimpleCamera::GetTileProjection(const glm::vec2& Min, const glm::vec2& Max) const
+{
+	// Metade da altura e da largura da imagem inteira no plano near
+	const float Top = Near * glm::tan(FieldOfView * 0.5f);
+	const float Right = Top * AspectRatio;
+	return glm::frustum(Min.x * Right, Max.x * Right, Min.y * Top, Max.y * Top, Near, Far);
+}
@@ -12,6 +12,10 @@ public:
 	glm::mat4 GetView();
 	glm::mat4 GetViewProjection();
 
+	// Frustum descentralizado que cobre só um pedaço da imagem. Min e Max são
+	// coordenadas normalizadas (de -1 a 1) da imagem inteira.
+	glm::mat4 GetTileProjection(const glm::vec2& Min, const glm::vec2& Max) const;
+
 	bool bEnableMouseMovement = false;
 	glm::vec2 PreviousCursor{ 0.0f };
 	float ForwardScale = 0.0f;
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "StarCatalogFormat.h"
+
+// Converte um CSV com as colunas ra,dec,mag,bv (ascensão reta e declinação
+// em graus, magnitude visual e índice de cor B-V), como os exportados dos
+// catálogos Hipparcos e Gaia, para o formato binário lido pelo StarCatalog.
+//
+// Uso: ConvertStarCatalog estrelas.csv catalogs/stars.bin
+
+int16_t Quantize(float Value, float Scale)
+{
+	return static_cast<int16_t>(glm::clamp(std::lround(Value * Scale), -32767l, 32767l));
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::cout << "Uso: ConvertStarCatalog <entrada.csv> <saida.bin>" << std::endl;
+		return 1;
+	}
+
+	std::ifstream Input{ argv[1] };
+	if (!Input)
+	{
+		std::cout << "Erro ao abrir " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::vector<StarRecord> Records;
+	std::string Line;
+	size_t NumSkipped = 0;
+
+	while (std::getline(Input, Line))
+	{
+		std::replace(Line.begin(), Line.end(), ',', ' ');
+		std::istringstream Fields{ Line };
+
+		float RightAscension, Declination, Magnitude, ColorIndex;
+		if (!(Fields >> RightAscension >> Declination >> Magnitude))
+		{
+			// Cabeçalho ou linha incompleta
+			NumSkipped++;
+			continue;
+		}
+
+		// Sem índice de cor a estrela é tratada como branca
+		if (!(Fields >> ColorIndex))
+		{
+			ColorIndex = 0.3f;
+		}
+
+		// O polo celeste fica no eixo Z, perpendicular ao plano das órbitas
+		const float Alpha = glm::radians(RightAscension);
+		const float Delta = glm::radians(Declination);
+		const glm::vec3 Direction{ glm::cos(Delta) * glm::cos(Alpha), glm::cos(Delta) * glm::sin(Alpha), glm::sin(Delta) };
+
+		const glm::vec2 Encoded = EncodeOctahedral(Direction);
+
+		StarRecord Record;
+		Record.Direction[0] = Quantize(Encoded.x, 32767.0f);
+		Record.Direction[1] = Quantize(Encoded.y, 32767.0f);
+		Record.Magnitude = Quantize(Magnitude, StarCatalogFormat::ValueScale);
+		Record.ColorIndex = Quantize(ColorIndex, StarCatalogFormat::ValueScale);
+		Records.push_back(Record);
+	}
+
+	// Da mais brilhante para a mais fraca: o limite de magnitude vira um prefixo
+	std::stable_sort(Records.begin(), Records.end(), [](const StarRecord& A, const StarRecord& B) { return A.Magnitude < B.Magnitude; });
+
+	StarCatalogHeader Header = {};
+	std::copy(std::begin(StarCatalogFormat::Magic), std::end(StarCatalogFormat::Magic), Header.Magic);
+	Header.Version = StarCatalogFormat::Version;
+	Header.NumStars = static_cast<uint32_t>(Records.size());
+
+	std::ofstream Output{ argv[2], std::ios::binary };
+	if (!Output)
+	{
+		std::cout << "Erro ao criar " << argv[2] << std::endl;
+		return 1;
+	}
+	Output.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+	Output.write(reinterpret_cast<const char*>(Records.data()), Records.size() * sizeof(StarRecord));
+
+	std::cout << Records.size() << " estrelas convertidas, " << NumSkipped << " linhas ignoradas" << std::endl;
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include "Culling.h"
+
+#include <iostream>
+#include <string>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "DepthPyramid.h"
+#include "IndirectDraw.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "ShaderData.h"
+
+Frustum ExtractFrustum(const glm::mat4& ViewProjection)
+{
+	// Linhas da matriz (a glm guarda as colunas)
+	const glm::vec4 Row0{ ViewProjection[0][0], ViewProjection[1][0], ViewProjection[2][0], ViewProjection[3][0] };
+	const glm::vec4 Row1{ ViewProjection[0][1], ViewProjection[1][1], ViewProjection[2][1], ViewProjection[3][1] };
+	const glm::vec4 Row2{ ViewProjection[0][2], ViewProjection[1][2], ViewProjection[2][2], ViewProjection[3][2] };
+	const glm::vec4 Row3{ ViewProjection[0][3], ViewProjection[1][3], ViewProjection[2][3], ViewProjection[3][3] };
+
+	Frustum ViewFrustum;
+	ViewFrustum.Planes[0] = Row3 + Row0; // Esquerda
+	ViewFrustum.Planes[1] = Row3 - Row0; // Direita
+	ViewFrustum.Planes[2] = Row3 + Row1; // Baixo
+	ViewFrustum.Planes[3] = Row3 - Row1; // Cima
+	ViewFrustum.Planes[4] = Row3 + Row2; // Perto
+	ViewFrustum.Planes[5] = Row3 - Row2; // Longe
+
+	// Normaliza para que a distância ao plano fique na mesma unidade do raio
+	for (glm::vec4& Plane : ViewFrustum.Planes)
+	{
+		Plane /= glm::length(glm::vec3(Plane));
+	}
+
+	return ViewFrustum;
+}
+
+bool IsSphereVisible(const Frustum& ViewFrustum, const glm::vec3& Center, float Radius)
+{
+	for (const glm::vec4& Plane : ViewFrustum.Planes)
+	{
+		if (glm::dot(glm::vec3(Plane), Center) + Plane.w < -Radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GpuCulling::IsSupported()
+{
+	return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object && SupportsMultiDrawIndirect();
+}
+
+void GpuCulling::Create(GLuint InMaxInstances)
+{
+	if (!IsSupported())
+	{
+		std::cout << "Culling na CPU: compute shader nao suportado" << std::endl;
+		return;
+	}
+
+	const std::string Defines = "#define LOD_COUNT " + std::to_string(SphereLOD::Count) + "\n";
+	ProgramId = LoadComputeShader("shaders/cull_comp.glsl", Defines);
+	if (ProgramId == 0)
+	{
+		std::cout << "Culling na CPU: erro no compute shader" << std::endl;
+		return;
+	}
+
+	MaxInstances = InMaxInstances;
+
+	glGenBuffers(1, &CulledInstanceBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, CulledInstanceBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, MaxInstances * sizeof(InstanceData), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GpuCulling::Release()
+{
+	glDeleteBuffers(1, &CulledInstanceBuffer);
+	glDeleteProgram(ProgramId);
+
+	CulledInstanceBuffer = 0;
+	ProgramId = 0;
+}
+
+void GpuCulling::Dispatch(GLuint SourceBuffer, GLintptr InstancesOffset, GLintptr InputsOffset, GLintptr CommandsOffset, GLsizeiptr CommandsSize, GLuint NumInstances,
+                          const Frustum& ViewFrustum, const glm::vec3& CameraPosition, float PixelsPerUnit, const DepthPyramid& Pyramid)
+{
+	if (NumInstances == 0)
+	{
+		return;
+	}
+
+	glUseProgram(ProgramId);
+
+	glUniform4fv(glGetUniformLocation(ProgramId, "FrustumPlanes"), 6, glm::value_ptr(ViewFrustum.Planes[0]));
+	glUniform3fv(glGetUniformLocation(ProgramId, "CameraPosition"), 1, glm::value_ptr(CameraPosition));
+	glUniform1f(glGetUniformLocation(ProgramId, "PixelsPerUnit"), PixelsPerUnit);
+	glUniform1fv(glGetUniformLocation(ProgramId, "LODMinScreenRadius"), SphereLOD::Count, SphereLOD::MinScreenRadius);
+	glUniform1ui(glGetUniformLocation(ProgramId, "NumInstances"), NumInstances);
+
+	// A pirâmide fica na unidade 1 para não trocar a texture array da unidade 0
+	glUniform1i(glGetUniformLocation(ProgramId, "bOcclusionCulling"), Pyramid.IsValid());
+	glUniform1i(glGetUniformLocation(ProgramId, "DepthPyramid"), 1);
+	glUniform1i(glGetUniformLocation(ProgramId, "DepthPyramidLevels"), Pyramid.GetNumLevels());
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "OcclusionViewProjection"), 1, GL_FALSE, glm::value_ptr(Pyramid.GetViewProjection()));
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, Pyramid.GetTexture());
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, SourceBuffer, InstancesOffset, NumInstances * sizeof(InstanceData));
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, SourceBuffer, InputsOffset, NumInstances * sizeof(CullInput));
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, SourceBuffer, CommandsOffset, CommandsSize);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, CulledInstanceBuffer);
+
+	glDispatchCompute((NumInstances + 63) / 64, 1, 1);
+
+	// Os draws indiretos e os atributos por instância leem o que o shader escreveu
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class DepthPyramid;
+
+// Planos do frustum no espaço do mundo, com as normais apontando para dentro
+struct Frustum
+{
+	glm::vec4 Planes[6];
+};
+
+Frustum ExtractFrustum(const glm::mat4& ViewProjection);
+
+bool IsSphereVisible(const Frustum& ViewFrustum, const glm::vec3& Center, float Radius);
+
+// Culling e escolha de nível de detalhe feitos por um compute shader. Para
+// cada corpo visível o shader incrementa o InstanceCount do comando do seu
+// nível de detalhe e copia o InstanceData para a posição reservada daquele
+// comando, assim a CPU envia sempre o mesmo número de draws indiretos.
+//
+// Precisa de OpenGL 4.3 (compute shader, SSBO e multi draw indirect). Sem
+// isso IsEnabled() é falso e o culling fica na CPU.
+class GpuCulling
+{
+public:
+	static bool IsSupported();
+
+	void Create(GLuint MaxInstances);
+	void Release();
+
+	bool IsEnabled() const { return ProgramId != 0; }
+	GLuint GetCulledInstanceBuffer() const { return CulledInstanceBuffer; }
+
+	// Os InstanceData, os CullInput e os comandos (com InstanceCount zerado)
+	// precisam estar em SourceBuffer nos offsets informados. O teste de
+	// oclusão só é feito se a pirâmide de profundidade for válida.
+	void Dispatch(GLuint SourceBuffer, GLintptr InstancesOffset, GLintptr InputsOffset, GLintptr CommandsOffset, GLsizeiptr CommandsSize, GLuint NumInstances,
+	              const Frustum& ViewFrustum, const glm::vec3& CameraPosition, float PixelsPerUnit, const DepthPyramid& Pyramid);
+
+private:
+	GLuint ProgramId = 0;
+	GLuint CulledInstanceBuffer = 0;
+	GLuint MaxInstances = 0;
+};
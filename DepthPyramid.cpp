@@ -0,0 +1,303 @@
+#include "DepthPyramid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Shader.h"
+
+namespace
+{
+	glm::ivec2 GetLevelSize(int Width, int Height, int Level)
+	{
+		return glm::max(glm::ivec2{ Width >> Level, Height >> Level }, glm::ivec2{ 1 });
+	}
+}
+
+bool ProjectSphereBounds(const glm::mat4& ViewProjection, const glm::vec3& Center, float Radius, glm::vec2& OutMinUV, glm::vec2& OutMaxUV, float& OutNearestDepth)
+{
+	OutMinUV = glm::vec2{ 1.0f };
+	OutMaxUV = glm::vec2{ 0.0f };
+	OutNearestDepth = 1.0f;
+
+	for (int Corner = 0; Corner < 8; ++Corner)
+	{
+		const glm::vec3 Offset{ (Corner & 1) ? Radius : -Radius, (Corner & 2) ? Radius : -Radius, (Corner & 4) ? Radius : -Radius };
+		const glm::vec4 Clip = ViewProjection * glm::vec4{ Center + Offset, 1.0f };
+		if (Clip.w <= 0.0f)
+		{
+			return false;
+		}
+
+		const glm::vec3 Ndc = glm::vec3(Clip) / Clip.w;
+		const glm::vec2 UV = glm::vec2(Ndc) * 0.5f + 0.5f;
+		OutMinUV = glm::min(OutMinUV, UV);
+		OutMaxUV = glm::max(OutMaxUV, UV);
+		OutNearestDepth = glm::min(OutNearestDepth, Ndc.z * 0.5f + 0.5f);
+	}
+
+	OutMinUV = glm::clamp(OutMinUV, 0.0f, 1.0f);
+	OutMaxUV = glm::clamp(OutMaxUV, 0.0f, 1.0f);
+	return true;
+}
+
+void DepthPyramid::Create(int InWidth, int InHeight, bool bInReadback)
+{
+	bReadback = bInReadback;
+
+	ProgramId = LoadShaders("shaders/hiz_vert.glsl", "shaders/hiz_frag.glsl");
+	if (ProgramId == 0)
+	{
+		std::cout << "Erro ao criar a piramide de profundidade, occlusion culling desabilitado" << std::endl;
+		return;
+	}
+
+	// O triângulo que cobre a tela é gerado no vertex shader a partir de gl_VertexID
+	glGenVertexArrays(1, &VertexArrayId);
+
+	glGenFramebuffers(1, &FramebufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferId);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (bReadback)
+	{
+		glGenBuffers(NumReadbackBuffers, ReadbackBuffers);
+	}
+
+	Width = InWidth;
+	Height = InHeight;
+	CreateTextures();
+}
+
+void DepthPyramid::Release()
+{
+	ReleaseTextures();
+
+	glDeleteBuffers(NumReadbackBuffers, ReadbackBuffers);
+	glDeleteFramebuffers(1, &FramebufferId);
+	glDeleteVertexArrays(1, &VertexArrayId);
+	glDeleteProgram(ProgramId);
+
+	std::fill(std::begin(ReadbackBuffers), std::end(ReadbackBuffers), 0);
+	FramebufferId = 0;
+	VertexArrayId = 0;
+	ProgramId = 0;
+}
+
+void DepthPyramid::Resize(int InWidth, int InHeight)
+{
+	if (ProgramId == 0 || (InWidth == Width && InHeight == Height))
+	{
+		return;
+	}
+
+	ReleaseTextures();
+	Width = InWidth;
+	Height = InHeight;
+	CreateTextures();
+}
+
+void DepthPyramid::CreateTextures()
+{
+	bValid = false;
+
+	if (Width <= 0 || Height <= 0)
+	{
+		return;
+	}
+
+	NumLevels = 1;
+	while ((Width >> NumLevels) > 0 || (Height >> NumLevels) > 0)
+	{
+		NumLevels++;
+	}
+
+	glGenTextures(1, &TextureId);
+	glBindTexture(GL_TEXTURE_2D, TextureId);
+	for (int Level = 0; Level < NumLevels; ++Level)
+	{
+		const glm::ivec2 LevelSize = GetLevelSize(Width, Height, Level);
+		glTexImage2D(GL_TEXTURE_2D, Level, GL_DEPTH_COMPONENT32F, LevelSize.x, LevelSize.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, NumLevels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (bReadback)
+	{
+		// O menor nível com até 128 texels de largura basta para o teste na CPU
+		ReadbackLevelIndex = 0;
+		while (ReadbackLevelIndex < NumLevels - 1 && GetLevelSize(Width, Height, ReadbackLevelIndex).x > 128)
+		{
+			ReadbackLevelIndex++;
+		}
+		ReadbackSize = GetLevelSize(Width, Height, ReadbackLevelIndex);
+
+		for (GLuint Buffer : ReadbackBuffers)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, Buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, ReadbackSize.x * ReadbackSize.y * sizeof(float), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
+
+void DepthPyramid::ReleaseTextures()
+{
+	for (GLsync& Fence : ReadbackFences)
+	{
+		if (Fence)
+		{
+			glDeleteSync(Fence);
+			Fence = nullptr;
+		}
+	}
+	CpuDepth.clear();
+
+	glDeleteTextures(1, &TextureId);
+	TextureId = 0;
+	bValid = false;
+}
+
+void DepthPyramid::Build(const glm::mat4& ViewProjection, GLuint SceneFramebuffer)
+{
+	if (ProgramId == 0 || TextureId == 0)
+	{
+		return;
+	}
+
+	// Nível 0: cópia do depth buffer da cena
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, SceneFramebuffer);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, TextureId);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, Width, Height);
+
+	// Os outros níveis são desenhados como profundidade, cada um lendo só o
+	// nível anterior para não ler e escrever o mesmo nível ao mesmo tempo
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferId);
+	glBindVertexArray(VertexArrayId);
+	glUseProgram(ProgramId);
+	glUniform1i(glGetUniformLocation(ProgramId, "Depth"), 0);
+	const GLint SourceSizeLoc = glGetUniformLocation(ProgramId, "SourceSize");
+
+	glDepthFunc(GL_ALWAYS);
+
+	for (int Level = 1; Level < NumLevels; ++Level)
+	{
+		const glm::ivec2 SourceSize = GetLevelSize(Width, Height, Level - 1);
+		const glm::ivec2 LevelSize = GetLevelSize(Width, Height, Level);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, Level - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, Level - 1);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, TextureId, Level);
+
+		glViewport(0, 0, LevelSize.x, LevelSize.y);
+		glUniform2i(SourceSizeLoc, SourceSize.x, SourceSize.y);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, NumLevels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glDepthFunc(GL_LESS);
+	glViewport(0, 0, Width, Height);
+	glBindVertexArray(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	BuildViewProjection = ViewProjection;
+	bValid = true;
+
+	if (bReadback)
+	{
+		ReadbackLevel();
+	}
+}
+
+void DepthPyramid::ReadbackLevel()
+{
+	// Recolhe as cópias que a GPU já terminou, da mais antiga para a mais nova
+	for (int Index = 0; Index < NumReadbackBuffers; ++Index)
+	{
+		const int Buffer = (NextReadbackBuffer + Index) % NumReadbackBuffers;
+		GLsync& Fence = ReadbackFences[Buffer];
+		if (!Fence)
+		{
+			continue;
+		}
+
+		const GLenum WaitResult = glClientWaitSync(Fence, 0, 0);
+		if (WaitResult != GL_ALREADY_SIGNALED && WaitResult != GL_CONDITION_SATISFIED)
+		{
+			continue;
+		}
+
+		glDeleteSync(Fence);
+		Fence = nullptr;
+
+		CpuDepth.resize(ReadbackSize.x * ReadbackSize.y);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, ReadbackBuffers[Buffer]);
+		if (const void* Data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, CpuDepth.size() * sizeof(float), GL_MAP_READ_BIT))
+		{
+			std::memcpy(CpuDepth.data(), Data, CpuDepth.size() * sizeof(float));
+			CpuViewProjection = ReadbackViewProjections[Buffer];
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	// Se a GPU ainda não terminou a cópia anterior nesse buffer, pula este frame
+	if (!ReadbackFences[NextReadbackBuffer])
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, ReadbackBuffers[NextReadbackBuffer]);
+		glBindTexture(GL_TEXTURE_2D, TextureId);
+		glGetTexImage(GL_TEXTURE_2D, ReadbackLevelIndex, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		ReadbackFences[NextReadbackBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		ReadbackViewProjections[NextReadbackBuffer] = BuildViewProjection;
+		NextReadbackBuffer = (NextReadbackBuffer + 1) % NumReadbackBuffers;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool DepthPyramid::IsSphereOccluded(const glm::vec3& Center, float Radius) const
+{
+	if (CpuDepth.empty())
+	{
+		return false;
+	}
+
+	glm::vec2 MinUV, MaxUV;
+	float NearestDepth;
+	if (!ProjectSphereBounds(CpuViewProjection, Center, Radius, MinUV, MaxUV, NearestDepth))
+	{
+		return false;
+	}
+
+	// As coordenadas são calculadas no nível 0 e depois reduzidas, porque o
+	// último texel de cada nível também cobre a sobra das dimensões ímpares
+	const glm::ivec2 LastPixel{ Width - 1, Height - 1 };
+	const glm::ivec2 MinTexel = glm::min(glm::min(glm::ivec2(MinUV * glm::vec2(Width, Height)), LastPixel) >> ReadbackLevelIndex, ReadbackSize - 1);
+	const glm::ivec2 MaxTexel = glm::min(glm::min(glm::ivec2(MaxUV * glm::vec2(Width, Height)), LastPixel) >> ReadbackLevelIndex, ReadbackSize - 1);
+
+	for (int Y = MinTexel.y; Y <= MaxTexel.y; ++Y)
+	{
+		for (int X = MinTexel.x; X <= MaxTexel.x; ++X)
+		{
+			if (NearestDepth <= CpuDepth[Y * ReadbackSize.x + X])
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Pirâmide de profundidade (Hi-Z) construída com o depth buffer do frame
+// anterior. Cada nível guarda a maior profundidade (a mais distante) dos
+// texels que cobre no nível de baixo, então uma esfera cujo ponto mais
+// próximo está atrás desse valor em toda a área que ocupa na tela está
+// escondida atrás do que já foi desenhado.
+//
+// O teste usa a ViewProjection do frame em que a pirâmide foi construída,
+// assim o movimento da câmera entre os frames não esconde corpos visíveis.
+class DepthPyramid
+{
+public:
+	// Com bReadback um nível pequeno da pirâmide é copiado de volta para a
+	// CPU de forma assíncrona, para o culling feito na CPU
+	void Create(int Width, int Height, bool bReadback);
+	void Release();
+
+	// Copia o depth buffer do framebuffer da cena (0 é a janela) e gera os
+	// outros níveis. Precisa ser chamado depois dos draws e antes de trocar
+	// os buffers da janela.
+	void Build(const glm::mat4& ViewProjection, GLuint SceneFramebuffer = 0);
+
+	// Descarta a pirâmide atual e muda o tamanho do nível 0
+	void Resize(int Width, int Height);
+
+	// Desliga o teste até o próximo Build
+	void Invalidate() { bValid = false; }
+
+	bool IsValid() const { return bValid; }
+	GLuint GetTexture() const { return TextureId; }
+	int GetNumLevels() const { return NumLevels; }
+	glm::ivec2 GetSize() const { return { Width, Height }; }
+	const glm::mat4& GetViewProjection() const { return BuildViewProjection; }
+
+	// Teste na CPU com o nível copiado de volta. Retorna false enquanto a
+	// cópia não chegou, ou seja, na dúvida o corpo é desenhado.
+	bool IsSphereOccluded(const glm::vec3& Center, float Radius) const;
+
+private:
+	void CreateTextures();
+	void ReleaseTextures();
+	void ReadbackLevel();
+
+	int Width = 0;
+	int Height = 0;
+	int NumLevels = 0;
+	bool bValid = false;
+	glm::mat4 BuildViewProjection{ 1.0f };
+
+	GLuint TextureId = 0;
+	GLuint FramebufferId = 0;
+	GLuint VertexArrayId = 0;
+	GLuint ProgramId = 0;
+
+	static constexpr int NumReadbackBuffers = 2;
+	bool bReadback = false;
+	int ReadbackLevelIndex = 0;
+	glm::ivec2 ReadbackSize{ 0 };
+	GLuint ReadbackBuffers[NumReadbackBuffers] = {};
+	GLsync ReadbackFences[NumReadbackBuffers] = {};
+	glm::mat4 ReadbackViewProjections[NumReadbackBuffers];
+	int NextReadbackBuffer = 0;
+
+	std::vector<float> CpuDepth;
+	glm::mat4 CpuViewProjection{ 1.0f };
+};
+
+// Retângulo na tela (em UV, de 0 a 1) e profundidade mais próxima da caixa
+// que envolve a esfera. Retorna false se a esfera cruza o plano da câmera,
+// caso em que ela não pode ser testada.
+bool ProjectSphereBounds(const glm::mat4& ViewProjection, const glm::vec3& Center, float Radius, glm::vec2& OutMinUV, glm::vec2& OutMaxUV, float& OutNearestDepth);
@@ -0,0 +1,76 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(const char* InDirectory)
+	: Directory(InDirectory)
+{
+#ifdef __linux__
+	NotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	// IN_MOVED_TO cobre os editores que salvam num arquivo temporário e renomeiam
+	if (NotifyFd < 0 || inotify_add_watch(NotifyFd, InDirectory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		std::cout << "Nao foi possivel observar o diretorio " << InDirectory << std::endl;
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (NotifyFd >= 0)
+	{
+		close(NotifyFd);
+	}
+#endif
+}
+
+bool FileWatcher::Poll(std::vector<std::string>& ChangedFiles)
+{
+	bool bChanged = false;
+
+#ifdef __linux__
+	if (NotifyFd < 0)
+	{
+		return false;
+	}
+
+	alignas(inotify_event) char Buffer[4096];
+
+	for (;;)
+	{
+		ssize_t Length = read(NotifyFd, Buffer, sizeof(Buffer));
+		if (Length <= 0)
+		{
+			break;
+		}
+
+		for (ssize_t Offset = 0; Offset < Length;)
+		{
+			const inotify_event* Event = reinterpret_cast<const inotify_event*>(Buffer + Offset);
+			Offset += sizeof(inotify_event) + Event->len;
+
+			if (Event->len == 0)
+			{
+				continue;
+			}
+
+			std::string FilePath = Directory + "/" + Event->name;
+			if (std::find(ChangedFiles.begin(), ChangedFiles.end(), FilePath) == ChangedFiles.end())
+			{
+				ChangedFiles.push_back(FilePath);
+			}
+			bChanged = true;
+		}
+	}
+#endif
+
+	return bChanged;
+}
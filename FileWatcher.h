@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Observa os arquivos de um diretório sem bloquear o frame. No Linux usa
+// inotify; nas outras plataformas nenhuma mudança é reportada.
+class FileWatcher
+{
+public:
+	explicit FileWatcher(const char* Directory);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Adiciona em ChangedFiles o caminho ("Diretorio/arquivo") de cada arquivo
+	// escrito desde a última chamada. Retorna true se algo mudou.
+	bool Poll(std::vector<std::string>& ChangedFiles);
+
+private:
+	std::string Directory;
+	int NotifyFd = -1;
+};
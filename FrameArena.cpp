@@ -0,0 +1,80 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+// Cabe as tabelas de páginas de uma textura virtual de 64k x 64k
+constexpr size_t DefaultFrameArenaCapacity = 4 * 1024 * 1024;
+
+namespace
+{
+	void* AlignPointer(void* Pointer, size_t Alignment)
+	{
+		const uintptr_t Address = reinterpret_cast<uintptr_t>(Pointer);
+		return reinterpret_cast<void*>((Address + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1));
+	}
+}
+
+LinearArena::LinearArena(size_t InitialCapacity)
+	: Block(static_cast<unsigned char*>(::operator new(InitialCapacity)))
+	, Capacity(InitialCapacity)
+{
+}
+
+LinearArena::~LinearArena()
+{
+	for (void* Overflow : OverflowBlocks)
+	{
+		::operator delete(Overflow);
+	}
+	::operator delete(Block);
+}
+
+void* LinearArena::Allocate(size_t Size, size_t Alignment)
+{
+	unsigned char* Aligned = static_cast<unsigned char*>(AlignPointer(Block + Offset, Alignment));
+	const size_t NewOffset = static_cast<size_t>(Aligned - Block) + Size;
+	if (NewOffset <= Capacity)
+	{
+		Used += NewOffset - Offset;
+		Offset = NewOffset;
+		Peak = std::max(Peak, Used);
+		return Aligned;
+	}
+
+	// Não cabe: vai para o heap só neste frame
+	void* Overflow = ::operator new(Size + Alignment);
+	OverflowBlocks.push_back(Overflow);
+	NumOverflows++;
+	Used += Size + Alignment;
+	Peak = std::max(Peak, Used);
+	return AlignPointer(Overflow, Alignment);
+}
+
+void LinearArena::Reset()
+{
+	if (!OverflowBlocks.empty())
+	{
+		for (void* Overflow : OverflowBlocks)
+		{
+			::operator delete(Overflow);
+		}
+		OverflowBlocks.clear();
+
+		// Folga de 50% sobre o pico, para o frame seguinte que pedir um pouco
+		// mais não estourar de novo
+		::operator delete(Block);
+		Capacity = std::max(Capacity * 2, Peak + Peak / 2);
+		Block = static_cast<unsigned char*>(::operator new(Capacity));
+	}
+
+	Offset = 0;
+	Used = 0;
+}
+
+LinearArena& GetFrameArena()
+{
+	thread_local LinearArena Arena{ DefaultFrameArenaCapacity };
+	return Arena;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Memória dos dados que só vivem um frame: listas de culling, tabelas de
+// páginas montadas na CPU e outros temporários. Allocate só avança um
+// ponteiro dentro de um bloco e Reset libera tudo de uma vez no começo do
+// frame seguinte.
+//
+// Se um frame pede mais que a capacidade, o que não cabe vai para o heap e o
+// bloco cresce no próximo Reset para caber o pico, então depois do primeiro
+// frame de cada situação não há mais alocações.
+class LinearArena
+{
+public:
+	explicit LinearArena(size_t InitialCapacity);
+	~LinearArena();
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	// Alignment precisa ser potência de 2
+	void* Allocate(size_t Size, size_t Alignment = alignof(std::max_align_t));
+
+	// Sem construtores nem destrutores: o conteúdo começa indefinido
+	template<typename T>
+	T* AllocateArray(size_t Count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "A arena nunca chama destrutores");
+		return static_cast<T*>(Allocate(Count * sizeof(T), alignof(T)));
+	}
+
+	// Invalida tudo que foi alocado desde o último Reset
+	void Reset();
+
+	size_t GetUsed() const { return Used; }
+	size_t GetCapacity() const { return Capacity; }
+	size_t GetPeak() const { return Peak; }
+
+	// Alocações que não couberam no bloco desde a criação da arena
+	size_t GetNumOverflows() const { return NumOverflows; }
+
+private:
+	unsigned char* Block = nullptr;
+	size_t Capacity = 0;
+	size_t Offset = 0;
+
+	// Inclui o que foi para o heap, para saber quanto o bloco precisa crescer
+	size_t Used = 0;
+	size_t Peak = 0;
+	size_t NumOverflows = 0;
+	std::vector<void*> OverflowBlocks;
+};
+
+// Arena da thread que chama. Cada thread que monta dados por frame tem a
+// sua e a zera no começo do seu frame; um ponteiro da arena não pode passar
+// para outra thread.
+LinearArena& GetFrameArena();
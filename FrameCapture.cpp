@@ -0,0 +1,289 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "deps/stb/stb_image_write.h"
+
+// O "b" só existe no _popen do Windows: o popen da glibc recusa o modo com EINVAL
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+constexpr const char* EncoderPipeMode = "wb";
+#else
+constexpr const char* EncoderPipeMode = "w";
+#endif
+
+bool FrameCapture::Start(int InWidth, int InHeight, const std::string& InOutputDirectory, const std::string& EncoderCommand)
+{
+	if (IsCapturing())
+	{
+		return true;
+	}
+
+	Width = InWidth;
+	Height = InHeight;
+	OutputDirectory = InOutputDirectory;
+	NextFrameIndex = 0;
+	StalledFrames = 0;
+	bStopping = false;
+
+	if (!EncoderCommand.empty())
+	{
+#ifndef _WIN32
+		// Se o encoder fechar antes da hora a escrita falha em vez de encerrar o programa
+		std::signal(SIGPIPE, SIG_IGN);
+#endif
+		EncoderPipe = popen(EncoderCommand.c_str(), EncoderPipeMode);
+		if (!EncoderPipe)
+		{
+			std::cout << "Erro ao iniciar o encoder: " << EncoderCommand << " (" << std::strerror(errno) << ")" << std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		std::error_code Error;
+		std::filesystem::create_directories(OutputDirectory, Error);
+		if (Error)
+		{
+			std::cout << "Erro ao criar a pasta " << OutputDirectory << std::endl;
+			return false;
+		}
+
+		// O OpenGL guarda as linhas de baixo para cima
+		stbi_flip_vertically_on_write(1);
+	}
+
+	// Com o pós-processamento desligado a cena é desenhada aqui direto, então
+	// precisa de profundidade
+	glGenRenderbuffers(1, &ColorRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, ColorRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, Width, Height);
+
+	glGenRenderbuffers(1, &DepthRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &FramebufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorRenderbufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthRenderbufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	const GLsizeiptr FrameSize = static_cast<GLsizeiptr>(Width) * Height * 4;
+	glGenBuffers(NumReadbackBuffers, ReadbackBuffers);
+	for (GLuint ReadbackBuffer : ReadbackBuffers)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, ReadbackBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, FrameSize, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Os PNGs são independentes e comprimidos em paralelo. O pipe precisa
+	// dos frames em ordem, então tem uma thread só.
+	const unsigned NumWorkers = EncoderPipe ? 1u : std::max(1u, std::thread::hardware_concurrency() / 2);
+	for (unsigned WorkerIndex = 0; WorkerIndex < NumWorkers; ++WorkerIndex)
+	{
+		Workers.emplace_back(&FrameCapture::WorkerLoop, this);
+	}
+
+	std::cout << "Capturando frames em " << Width << "x" << Height << std::endl;
+	return true;
+}
+
+void FrameCapture::Stop()
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	CollectReadbacks(true);
+
+	{
+		std::lock_guard<std::mutex> Lock{ QueueMutex };
+		bStopping = true;
+	}
+	QueueCondition.notify_all();
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	Workers.clear();
+	FreeBuffers.clear();
+
+	if (EncoderPipe)
+	{
+		pclose(EncoderPipe);
+		EncoderPipe = nullptr;
+	}
+
+	glDeleteBuffers(NumReadbackBuffers, ReadbackBuffers);
+	glDeleteFramebuffers(1, &FramebufferId);
+	glDeleteRenderbuffers(1, &ColorRenderbufferId);
+	glDeleteRenderbuffers(1, &DepthRenderbufferId);
+
+	std::fill(std::begin(ReadbackBuffers), std::end(ReadbackBuffers), 0);
+	FramebufferId = 0;
+	ColorRenderbufferId = 0;
+	DepthRenderbufferId = 0;
+
+	std::cout << "Captura encerrada: " << NextFrameIndex << " frames, " << StalledFrames << " esperaram o encoder" << std::endl;
+}
+
+void FrameCapture::CaptureFrame(int WindowWidth, int WindowHeight)
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	CollectReadbacks(false);
+
+	// Com a troca de buffers limitando a CPU a poucos frames na frente da
+	// GPU, o buffer mais antigo do anel praticamente sempre já está livre
+	const int Buffer = NextReadbackBuffer;
+	if (ReadbackFences[Buffer])
+	{
+		CollectReadbacks(true);
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FramebufferId);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ReadbackBuffers[Buffer]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, Width, Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// A janela mostra o frame inteiro, centralizado e com a proporção do vídeo
+	const float Scale = std::min(static_cast<float>(WindowWidth) / Width, static_cast<float>(WindowHeight) / Height);
+	const int ViewWidth = static_cast<int>(Width * Scale);
+	const int ViewHeight = static_cast<int>(Height * Scale);
+	const int ViewX = (WindowWidth - ViewWidth) / 2;
+	const int ViewY = (WindowHeight - ViewHeight) / 2;
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glViewport(0, 0, WindowWidth, WindowHeight);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBlitFramebuffer(0, 0, Width, Height, ViewX, ViewY, ViewX + ViewWidth, ViewY + ViewHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	ReadbackFences[Buffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ReadbackFrameIndex[Buffer] = NextFrameIndex++;
+	NextReadbackBuffer = (Buffer + 1) % NumReadbackBuffers;
+}
+
+void FrameCapture::CollectReadbacks(bool bWait)
+{
+	const size_t FrameSize = static_cast<size_t>(Width) * Height * 4;
+
+	// Da leitura mais antiga para a mais nova, para manter a ordem dos frames
+	for (int Index = 0; Index < NumReadbackBuffers; ++Index)
+	{
+		const int Buffer = (NextReadbackBuffer + Index) % NumReadbackBuffers;
+		GLsync& Fence = ReadbackFences[Buffer];
+		if (!Fence)
+		{
+			continue;
+		}
+
+		const GLenum WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, bWait ? GL_TIMEOUT_IGNORED : 0);
+		if (WaitResult != GL_ALREADY_SIGNALED && WaitResult != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		glDeleteSync(Fence);
+		Fence = nullptr;
+
+		PendingFrame Frame;
+		Frame.Index = ReadbackFrameIndex[Buffer];
+		{
+			std::unique_lock<std::mutex> Lock{ QueueMutex };
+			if (FramesInFlight >= MaxPendingFrames)
+			{
+				if (StalledFrames++ == 0)
+				{
+					std::cout << "A compressao nao acompanha a captura, o frame " << Frame.Index << " vai esperar o encoder" << std::endl;
+				}
+				FreeCondition.wait(Lock, [this]() { return FramesInFlight < MaxPendingFrames; });
+			}
+
+			++FramesInFlight;
+			if (!FreeBuffers.empty())
+			{
+				Frame.Pixels = std::move(FreeBuffers.back());
+				FreeBuffers.pop_back();
+			}
+		}
+		Frame.Pixels.resize(FrameSize);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, ReadbackBuffers[Buffer]);
+		if (const void* Pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, FrameSize, GL_MAP_READ_BIT))
+		{
+			std::memcpy(Frame.Pixels.data(), Pixels, FrameSize);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		{
+			std::lock_guard<std::mutex> Lock{ QueueMutex };
+			Queue.push_back(std::move(Frame));
+		}
+		QueueCondition.notify_one();
+	}
+}
+
+void FrameCapture::WorkerLoop()
+{
+	for (;;)
+	{
+		PendingFrame Frame;
+		{
+			std::unique_lock<std::mutex> Lock{ QueueMutex };
+			QueueCondition.wait(Lock, [this]() { return bStopping || !Queue.empty(); });
+			if (Queue.empty())
+			{
+				return;
+			}
+
+			Frame = std::move(Queue.front());
+			Queue.pop_front();
+		}
+
+		if (EncoderPipe)
+		{
+			if (std::fwrite(Frame.Pixels.data(), 1, Frame.Pixels.size(), EncoderPipe) != Frame.Pixels.size())
+			{
+				std::cout << "Erro ao enviar o frame " << Frame.Index << " para o encoder" << std::endl;
+			}
+		}
+		else
+		{
+			char FileName[32];
+			std::snprintf(FileName, sizeof(FileName), "frame_%06llu.png", static_cast<unsigned long long>(Frame.Index));
+			const std::string Path = (std::filesystem::path{ OutputDirectory } / FileName).string();
+			if (!stbi_write_png(Path.c_str(), Width, Height, 4, Frame.Pixels.data(), Width * 4))
+			{
+				std::cout << "Erro ao salvar " << Path << std::endl;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock{ QueueMutex };
+			FreeBuffers.push_back(std::move(Frame.Pixels));
+			--FramesInFlight;
+		}
+		FreeCondition.notify_one();
+	}
+}
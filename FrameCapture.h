@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Captura dos frames para gerar vídeos. Durante a captura a cena é
+// desenhada direto no framebuffer da captura, no tamanho e na proporção do
+// vídeo, e copiada para a janela com faixas pretas onde as proporções não
+// batem. O frame é lido para um anel de pixel buffer objects com fences: o
+// glReadPixels só agenda a cópia e o buffer é mapeado alguns frames depois,
+// quando a GPU já terminou, então o frame nunca fica esperando a leitura.
+//
+// A compressão é feita em threads de trabalho: PNGs numerados com
+// stb_image_write, ou os pixels crus (RGBA, de baixo para cima) escritos na
+// entrada padrão de um encoder externo, por exemplo
+//   ffmpeg -f rawvideo -pix_fmt rgba -s 1920x1080 -r 60 -i - -vf vflip video.mp4
+class FrameCapture
+{
+public:
+	static constexpr int NumReadbackBuffers = 3;
+
+	// Frames lidos esperando compressão. Passando disso o loop de renderização
+	// espera as threads de trabalho liberarem um frame: um frame a menos
+	// estraga o vídeo, então a captura fica lenta em vez de pular frames.
+	static constexpr size_t MaxPendingFrames = 8;
+
+	// Com EncoderCommand vazio os frames viram PNGs em OutputDirectory
+	bool Start(int Width, int Height, const std::string& OutputDirectory, const std::string& EncoderCommand);
+
+	// Espera as leituras pendentes e as threads terminarem
+	void Stop();
+
+	bool IsCapturing() const { return FramebufferId != 0; }
+
+	// Destino do frame enquanto captura, com cor e profundidade
+	GLuint GetFramebuffer() const { return FramebufferId; }
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+	float GetAspectRatio() const { return static_cast<float>(Width) / Height; }
+
+	// Chamado depois de desenhar o frame no framebuffer da captura e antes de
+	// trocar os buffers: lê o frame e mostra na janela
+	void CaptureFrame(int WindowWidth, int WindowHeight);
+
+private:
+	struct PendingFrame
+	{
+		uint64_t Index;
+		std::vector<unsigned char> Pixels;
+	};
+
+	void CollectReadbacks(bool bWait);
+	void WorkerLoop();
+
+	int Width = 0;
+	int Height = 0;
+	std::string OutputDirectory;
+
+	GLuint FramebufferId = 0;
+	GLuint ColorRenderbufferId = 0;
+	GLuint DepthRenderbufferId = 0;
+	GLuint ReadbackBuffers[NumReadbackBuffers] = {};
+	GLsync ReadbackFences[NumReadbackBuffers] = {};
+	uint64_t ReadbackFrameIndex[NumReadbackBuffers] = {};
+	int NextReadbackBuffer = 0;
+
+	uint64_t NextFrameIndex = 0;
+	uint64_t StalledFrames = 0;
+
+	FILE* EncoderPipe = nullptr;
+
+	// Fila para as threads de trabalho e buffers já alocados para reuso
+	std::mutex QueueMutex;
+	std::condition_variable QueueCondition;
+	std::condition_variable FreeCondition;
+	std::deque<PendingFrame> Queue;
+	std::vector<std::vector<unsigned char>> FreeBuffers;
+	size_t FramesInFlight = 0;
+	bool bStopping = false;
+	std::vector<std::thread> Workers;
+};
@@ -0,0 +1,36 @@
+#include "IndirectDraw.h"
+
+bool SupportsMultiDrawIndirect()
+{
+	return GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+}
+
+void MultiDrawElementsIndirect(const DrawElementsIndirectCommand* Commands, GLsizei CommandCount, GLintptr IndirectOffset, SetBaseInstanceFunction SetBaseInstance)
+{
+	if (SupportsMultiDrawIndirect())
+	{
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(IndirectOffset), CommandCount, sizeof(DrawElementsIndirectCommand));
+		return;
+	}
+
+	for (GLsizei CommandIndex = 0; CommandIndex < CommandCount; ++CommandIndex)
+	{
+		const DrawElementsIndirectCommand& Command = Commands[CommandIndex];
+		if (Command.InstanceCount == 0)
+		{
+			continue;
+		}
+
+		const void* Indices = reinterpret_cast<const void*>(Command.FirstIndex * sizeof(GLuint));
+
+		if (GLEW_ARB_base_instance)
+		{
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, Command.Count, GL_UNSIGNED_INT, Indices, Command.InstanceCount, Command.BaseVertex, Command.BaseInstance);
+		}
+		else
+		{
+			SetBaseInstance(Command.BaseInstance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, Command.Count, GL_UNSIGNED_INT, Indices, Command.InstanceCount, Command.BaseVertex);
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Mesmo layout que glMultiDrawElementsIndirect lê do GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint Count;
+	GLuint InstanceCount;
+	GLuint FirstIndex;
+	GLint BaseVertex;
+	GLuint BaseInstance;
+};
+
+// Chamado no caminho sem base instance para reapontar os atributos por
+// instância antes de cada draw
+using SetBaseInstanceFunction = void (*)(GLuint BaseInstance);
+
+bool SupportsMultiDrawIndirect();
+
+// Desenha os comandos que já estão no GL_DRAW_INDIRECT_BUFFER ligado, a
+// partir de IndirectOffset. Sem GL_ARB_multi_draw_indirect (contextos 3.3)
+// os mesmos comandos são enviados num loop usando a cópia em Commands.
+void MultiDrawElementsIndirect(const DrawElementsIndirectCommand* Commands, GLsizei CommandCount, GLintptr IndirectOffset, SetBaseInstanceFunction SetBaseInstance);
@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* FilePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE File = CreateFileA(FilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* View = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!View)
+	{
+		if (Mapping)
+		{
+			CloseHandle(Mapping);
+		}
+		CloseHandle(File);
+		return false;
+	}
+
+	FileHandle = File;
+	MappingHandle = Mapping;
+	Data = static_cast<const unsigned char*>(View);
+	Size = static_cast<size_t>(FileSize.QuadPart);
+#else
+	const int FileDescriptor = open(FilePath, O_RDONLY | O_CLOEXEC);
+	if (FileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+	if (fstat(FileDescriptor, &FileStat) != 0 || FileStat.st_size == 0)
+	{
+		close(FileDescriptor);
+		return false;
+	}
+
+	void* View = mmap(nullptr, static_cast<size_t>(FileStat.st_size), PROT_READ, MAP_PRIVATE, FileDescriptor, 0);
+
+	// O mapeamento continua válido depois que o descritor é fechado
+	close(FileDescriptor);
+
+	if (View == MAP_FAILED)
+	{
+		return false;
+	}
+
+	madvise(View, static_cast<size_t>(FileStat.st_size), MADV_SEQUENTIAL);
+
+	Data = static_cast<const unsigned char*>(View);
+	Size = static_cast<size_t>(FileStat.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!Data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(Data);
+	CloseHandle(MappingHandle);
+	CloseHandle(FileHandle);
+	MappingHandle = nullptr;
+	FileHandle = nullptr;
+#else
+	munmap(const_cast<unsigned char*>(Data), Size);
+#endif
+
+	Data = nullptr;
+	Size = 0;
+}
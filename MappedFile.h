@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+// Arquivo mapeado na memória só para leitura. As páginas são lidas do disco
+// sob demanda, então abrir um arquivo grande não custa nada até ele ser lido.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* FilePath);
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+	const unsigned char* GetData() const { return Data; }
+	size_t GetSize() const { return Size; }
+
+private:
+	const unsigned char* Data = nullptr;
+	size_t Size = 0;
+
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+};
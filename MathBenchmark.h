@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "SimdMath.h"
+
+// Medição usada pelos benchmarks do Vetores e do Matrizes. Cada kernel
+// processa um lote de BenchmarkBatchSize corpos por chamada e é repetido até
+// passar de BenchmarkMinSeconds; de BenchmarkRounds rodadas fica a mais
+// rápida, que é a menos afetada por interrupções. Tudo roda numa thread, então
+// a vazão é por núcleo.
+
+// Perto do número de instâncias de um frame, e cabe na L2 junto com as saídas
+constexpr size_t BenchmarkBatchSize = 1024;
+constexpr int BenchmarkRounds = 5;
+constexpr double BenchmarkMinSeconds = 0.05;
+
+struct BenchmarkResult
+{
+	double NanosecondsPerOp = 0.0;
+	double MillionOpsPerSecond = 0.0;
+};
+
+// Faz o compilador considerar que a memória apontada foi lida, assim o
+// kernel não é descartado por ninguém usar a saída
+inline void KeepMemory(const void* Pointer)
+{
+#if defined(_MSC_VER)
+	static const void* volatile Sink;
+	Sink = Pointer;
+#else
+	asm volatile("" : : "r"(Pointer) : "memory");
+#endif
+}
+
+// Kernel() processa o lote inteiro e retorna o ponteiro para a saída
+template<typename KernelType>
+BenchmarkResult RunBenchmark(KernelType&& Kernel)
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Aquece caches e a previsão de desvios antes de medir
+	KeepMemory(Kernel());
+
+	double BestNanosecondsPerOp = 0.0;
+	for (int Round = 0; Round < BenchmarkRounds; ++Round)
+	{
+		size_t NumBatches = 0;
+		double ElapsedSeconds = 0.0;
+		const Clock::time_point Start = Clock::now();
+		do
+		{
+			for (int Batch = 0; Batch < 16; ++Batch)
+			{
+				KeepMemory(Kernel());
+			}
+			NumBatches += 16;
+			ElapsedSeconds = std::chrono::duration<double>(Clock::now() - Start).count();
+		} while (ElapsedSeconds < BenchmarkMinSeconds);
+
+		const double NanosecondsPerOp = ElapsedSeconds * 1e9 / (static_cast<double>(NumBatches) * BenchmarkBatchSize);
+		if (Round == 0 || NanosecondsPerOp < BestNanosecondsPerOp)
+		{
+			BestNanosecondsPerOp = NanosecondsPerOp;
+		}
+	}
+
+	BenchmarkResult Result;
+	Result.NanosecondsPerOp = BestNanosecondsPerOp;
+	Result.MillionOpsPerSecond = 1e3 / BestNanosecondsPerOp;
+	return Result;
+}
+
+// Maior diferença entre Values e Reference, relativa ao tamanho do valor de
+// referência quando ele passa de 1
+inline float GetMaxError(const float* Values, const float* Reference, size_t NumValues)
+{
+	float MaxError = 0.0f;
+	for (size_t Index = 0; Index < NumValues; ++Index)
+	{
+		const float Error = std::abs(Values[Index] - Reference[Index]) / std::max(1.0f, std::abs(Reference[Index]));
+		MaxError = std::max(MaxError, Error);
+	}
+	return MaxError;
+}
+
+inline void PrintBenchmarkHeader(const char* Title)
+{
+	std::cout << std::endl << Title << std::endl;
+	std::cout << std::left << std::setw(24) << "  caminho" << std::right
+	          << std::setw(10) << "ns/op"
+	          << std::setw(22) << "Mops/s por nucleo"
+	          << std::setw(12) << "vs glm"
+	          << std::setw(12) << "erro max" << std::endl;
+}
+
+// Baseline é o resultado da glm escalar
+inline void PrintBenchmarkResult(const std::string& Path, const BenchmarkResult& Result, const BenchmarkResult& Baseline, float MaxError)
+{
+	std::cout << std::left << std::setw(24) << ("  " + Path) << std::right << std::fixed
+	          << std::setw(10) << std::setprecision(2) << Result.NanosecondsPerOp
+	          << std::setw(22) << std::setprecision(1) << Result.MillionOpsPerSecond
+	          << std::setw(11) << std::setprecision(2) << Baseline.NanosecondsPerOp / Result.NanosecondsPerOp << "x"
+	          << std::setw(12) << std::scientific << std::setprecision(1) << MaxError << std::defaultfloat << std::endl;
+}
+
+// Mede a glm escalar, a glm com SIMD e o SimdMath no mesmo trabalho e imprime
+// a comparação. Cada kernel retorna as FloatsPerOp saídas de cada item do
+// lote, que são comparadas com as da glm escalar. Retorna a medida da glm
+// escalar, para comparar outras variantes com ela.
+template<typename GlmKernelType, typename AlignedKernelType, typename SimdKernelType>
+BenchmarkResult CompareMathPaths(const char* Title, size_t FloatsPerOp, GlmKernelType&& GlmKernel, AlignedKernelType&& AlignedKernel, SimdKernelType&& SimdKernel)
+{
+	const BenchmarkResult Glm = RunBenchmark(GlmKernel);
+	const BenchmarkResult Aligned = RunBenchmark(AlignedKernel);
+	const BenchmarkResult Simd = RunBenchmark(SimdKernel);
+
+	const size_t NumFloats = FloatsPerOp * BenchmarkBatchSize;
+	const float* Reference = GlmKernel();
+
+	PrintBenchmarkHeader(Title);
+	PrintBenchmarkResult("glm", Glm, Glm, 0.0f);
+	PrintBenchmarkResult("glm SIMD", Aligned, Glm, GetMaxError(AlignedKernel(), Reference, NumFloats));
+	PrintBenchmarkResult(std::string{ "SimdMath " } + GetSimdMathPath(), Simd, Glm, GetMaxError(SimdKernel(), Reference, NumFloats));
+	return Glm;
+}
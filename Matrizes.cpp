@@ -1,9 +1,23 @@
+#include <cstring>
 #include <iostream>
 #include <iomanip>
-
+#include <random>
+#include <vector>
+
+// As duas verses da glm ficam no mesmo executvel: glm::mat4 usa o cdigo
+// genrico da glm, o mesmo do GLM_FORCE_PURE, e glm::aligned_mat4 usa as
+// especializaes SSE/AVX, que a glm s tem para os tipos alinhados. O
+// GLM_FORCE_INTRINSICS vem do CMake, porque o BodyTransforms.cpp tambm entra
+// no executvel e os tipos da glm precisam ser iguais nos dois.
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_aligned.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "BodyTransforms.h"
+#include "MathBenchmark.h"
+
 void PrintMatrix(const glm::mat4& M)
 {	
 	for (int i = 0; i < 4; ++i)
@@ -149,7 +163,7 @@ void ModelViewProjection()
 	std::cout << "View: " << std::endl;
 	PrintMatrix(View);
 
-	constexpr float FoV = glm::radians(45.0f);
+	const float FoV = glm::radians(45.0f);
 	const float AspectRatio = 800.0f / 600.0f;
 	const float Near = 0.001f;
 	const float Far = 1000.0f;
@@ -164,13 +178,395 @@ void ModelViewProjection()
 	PrintMatrix(ModelViewProjection);
 }
 
-int main()
-{		
-	TranslationMatrix();
-	RotationMatrix();
-	ScaleMatrix();
-	ComposedMatrix();
-	ModelViewProjection();
+// Corpos com rbitas e escalas sorteadas, iguais para os trs caminhos. As
+// cpias alinhadas so feitas antes para a converso no entrar na medida.
+struct BenchmarkBodies
+{
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Axes;
+	std::vector<float> Angles;
+	std::vector<float> Scales;
+	std::vector<glm::vec3> Eyes;
+	std::vector<glm::mat4> Models;
+	std::vector<glm::mat4> ModelViews;
+
+	std::vector<glm::aligned_vec3> AlignedPositions;
+	std::vector<glm::aligned_vec3> AlignedAxes;
+	std::vector<glm::aligned_vec3> AlignedEyes;
+	std::vector<glm::aligned_mat4> AlignedModels;
+	std::vector<glm::aligned_mat4> AlignedModelViews;
+
+	glm::mat4 View;
+	glm::mat4 ViewProjection;
+	glm::aligned_mat4 AlignedView;
+	glm::aligned_mat4 AlignedViewProjection;
+};
+
+BenchmarkBodies CreateBenchmarkBodies()
+{
+	std::mt19937 Random{ 42 };
+	std::uniform_real_distribution<float> Coordinate{ -100.0f, 100.0f };
+	std::uniform_real_distribution<float> Angle{ 0.0f, glm::two_pi<float>() };
+	std::uniform_real_distribution<float> Scale{ 0.1f, 10.0f };
+
+	BenchmarkBodies Bodies;
+	Bodies.View = glm::lookAt(glm::vec3{ 0.0f, 50.0f, 300.0f }, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+	Bodies.ViewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 10000.0f) * Bodies.View;
+	Bodies.AlignedView = glm::aligned_mat4{ Bodies.View };
+	Bodies.AlignedViewProjection = glm::aligned_mat4{ Bodies.ViewProjection };
+
+	for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+	{
+		const glm::vec3 Position{ Coordinate(Random), Coordinate(Random), Coordinate(Random) };
+		const glm::vec3 Axis = glm::normalize(glm::vec3{ Coordinate(Random), Coordinate(Random), Coordinate(Random) });
+		const float BodyAngle = Angle(Random);
+		const float BodyScale = Scale(Random);
+		const glm::mat4 Model = glm::scale(glm::rotate(glm::translate(glm::mat4{ 1.0f }, Position), BodyAngle, Axis), glm::vec3{ BodyScale });
+
+		Bodies.Positions.push_back(Position);
+		Bodies.Axes.push_back(Axis);
+		Bodies.Angles.push_back(BodyAngle);
+		Bodies.Scales.push_back(BodyScale);
+		Bodies.Eyes.push_back(glm::vec3{ Coordinate(Random), Coordinate(Random), Coordinate(Random) } * 10.0f);
+		Bodies.Models.push_back(Model);
+		Bodies.ModelViews.push_back(Bodies.View * Model);
+
+		Bodies.AlignedPositions.push_back(glm::aligned_vec3{ Position });
+		Bodies.AlignedAxes.push_back(glm::aligned_vec3{ Axis });
+		Bodies.AlignedEyes.push_back(glm::aligned_vec3{ Bodies.Eyes.back() });
+		Bodies.AlignedModels.push_back(glm::aligned_mat4{ Model });
+		Bodies.AlignedModelViews.push_back(glm::aligned_mat4{ Bodies.ModelViews.back() });
+	}
+	return Bodies;
+}
+
+// Mesmo layout das matrizes do InstanceData do ShaderData.h
+struct InstanceMatrices
+{
+	glm::mat4 ModelViewMatrix;
+	glm::mat4 ModelViewProjection;
+	glm::vec4 NormalMatrix[3];
+};
+
+struct NormalMatrixColumns
+{
+	glm::vec4 Columns[3];
+};
 
+void BenchmarkMatrixProduct(const BenchmarkBodies& Bodies)
+{
+	std::vector<glm::mat4> GlmResults(BenchmarkBatchSize);
+	std::vector<glm::aligned_mat4> AlignedResults(BenchmarkBatchSize);
+	std::vector<glm::mat4> SimdResults(BenchmarkBatchSize);
+
+	CompareMathPaths("mat4 x mat4 (View * Model)", 16,
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				GlmResults[BodyIndex] = Bodies.View * Bodies.Models[BodyIndex];
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				AlignedResults[BodyIndex] = Bodies.AlignedView * Bodies.AlignedModels[BodyIndex];
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				MultiplyMatrices(glm::value_ptr(Bodies.View), glm::value_ptr(Bodies.Models[BodyIndex]), glm::value_ptr(SimdResults[BodyIndex]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+}
+
+void BenchmarkTransformChain(const BenchmarkBodies& Bodies)
+{
+	std::vector<glm::mat4> GlmResults(BenchmarkBatchSize);
+	std::vector<glm::aligned_mat4> AlignedResults(BenchmarkBatchSize);
+	std::vector<glm::mat4> SimdResults(BenchmarkBatchSize);
+
+	CompareMathPaths("translate * rotate * scale", 16,
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				const glm::mat4 Translation = glm::translate(glm::mat4{ 1.0f }, Bodies.Positions[BodyIndex]);
+				const glm::mat4 Rotation = glm::rotate(Translation, Bodies.Angles[BodyIndex], Bodies.Axes[BodyIndex]);
+				GlmResults[BodyIndex] = glm::scale(Rotation, glm::vec3{ Bodies.Scales[BodyIndex] });
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				const glm::aligned_mat4 Translation = glm::translate(glm::aligned_mat4{ 1.0f }, Bodies.AlignedPositions[BodyIndex]);
+				const glm::aligned_mat4 Rotation = glm::rotate(Translation, Bodies.Angles[BodyIndex], Bodies.AlignedAxes[BodyIndex]);
+				AlignedResults[BodyIndex] = glm::scale(Rotation, glm::aligned_vec3{ Bodies.Scales[BodyIndex] });
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				ComposeTransform(glm::value_ptr(Bodies.Positions[BodyIndex]), glm::value_ptr(Bodies.Axes[BodyIndex]), Bodies.Angles[BodyIndex], Bodies.Scales[BodyIndex], glm::value_ptr(SimdResults[BodyIndex]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+}
+
+void BenchmarkNormalMatrix(const BenchmarkBodies& Bodies)
+{
+	std::vector<NormalMatrixColumns> GlmResults(BenchmarkBatchSize);
+	std::vector<NormalMatrixColumns> AlignedResults(BenchmarkBatchSize);
+	std::vector<NormalMatrixColumns> SimdResults(BenchmarkBatchSize);
+	std::vector<NormalMatrixColumns> UniformScaleResults(BenchmarkBatchSize);
+
+	auto GlmKernel = [&]()
+	{
+		for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+		{
+			const glm::mat3 NormalMatrix = glm::transpose(glm::inverse(glm::mat3{ Bodies.ModelViews[BodyIndex] }));
+			for (int Column = 0; Column < 3; ++Column)
+			{
+				GlmResults[BodyIndex].Columns[Column] = glm::vec4{ NormalMatrix[Column], 0.0f };
+			}
+		}
+		return glm::value_ptr(GlmResults[0].Columns[0]);
+	};
+
+	// A glm s tem a inversa com SIMD para mat4. Com a ltima linha (0, 0, 0, 1)
+	// a parte 3x3 da inversa  a inversa da parte 3x3.
+	auto AlignedKernel = [&]()
+	{
+		for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+		{
+			const glm::aligned_mat4 NormalMatrix = glm::transpose(glm::inverse(Bodies.AlignedModelViews[BodyIndex]));
+			for (int Column = 0; Column < 3; ++Column)
+			{
+				AlignedResults[BodyIndex].Columns[Column] = glm::vec4{ glm::vec3{ NormalMatrix[Column] }, 0.0f };
+			}
+		}
+		return glm::value_ptr(AlignedResults[0].Columns[0]);
+	};
+
+	auto SimdKernel = [&]()
+	{
+		for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+		{
+			ComputeNormalMatrix(glm::value_ptr(Bodies.ModelViews[BodyIndex]), glm::value_ptr(SimdResults[BodyIndex].Columns[0]));
+		}
+		return glm::value_ptr(SimdResults[0].Columns[0]);
+	};
+
+	const BenchmarkResult Glm = CompareMathPaths("inversa transposta (NormalMatrix)", 12, GlmKernel, AlignedKernel, SimdKernel);
+
+	// Todos os corpos da cena tm escala uniforme
+	auto UniformScaleKernel = [&]()
+	{
+		for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+		{
+			ComputeNormalMatrixUniformScale(glm::value_ptr(Bodies.ModelViews[BodyIndex]), glm::value_ptr(UniformScaleResults[BodyIndex].Columns[0]));
+		}
+		return glm::value_ptr(UniformScaleResults[0].Columns[0]);
+	};
+
+	const BenchmarkResult UniformScale = RunBenchmark(UniformScaleKernel);
+	PrintBenchmarkResult(std::string{ "escala uniforme " } + GetSimdMathPath(), UniformScale, Glm, GetMaxError(UniformScaleKernel(), GlmKernel(), 12 * BenchmarkBatchSize));
+}
+
+void BenchmarkViewProjection(const BenchmarkBodies& Bodies)
+{
+	const float FoV = glm::radians(45.0f);
+	const float AspectRatio = 16.0f / 9.0f;
+	const float Near = 0.1f;
+	const float Far = 10000.0f;
+	const glm::vec3 Center{ 0.0f };
+	const glm::vec3 Up{ 0.0f, 1.0f, 0.0f };
+	const glm::aligned_vec3 AlignedCenter{ Center };
+	const glm::aligned_vec3 AlignedUp{ Up };
+
+	std::vector<glm::mat4> GlmResults(BenchmarkBatchSize);
+	std::vector<glm::aligned_mat4> AlignedResults(BenchmarkBatchSize);
+	std::vector<glm::mat4> SimdResults(BenchmarkBatchSize);
+
+	CompareMathPaths("lookAt + perspective", 16,
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				GlmResults[BodyIndex] = glm::perspective(FoV, AspectRatio, Near, Far) * glm::lookAt(Bodies.Eyes[BodyIndex], Center, Up);
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			// A glm::perspective sempre retorna o tipo sem alinhamento
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				const glm::aligned_mat4 Projection{ glm::perspective(FoV, AspectRatio, Near, Far) };
+				AlignedResults[BodyIndex] = Projection * glm::lookAt(Bodies.AlignedEyes[BodyIndex], AlignedCenter, AlignedUp);
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				ComputeViewProjection(glm::value_ptr(Bodies.Eyes[BodyIndex]), glm::value_ptr(Center), glm::value_ptr(Up), FoV, AspectRatio, Near, Far, glm::value_ptr(SimdResults[BodyIndex]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+}
+
+// Tudo o que o InstanceData de um corpo precisa, com a inversa geral da glm
+void BenchmarkInstanceData(const BenchmarkBodies& Bodies)
+{
+	std::vector<InstanceMatrices> GlmResults(BenchmarkBatchSize);
+	std::vector<InstanceMatrices> AlignedResults(BenchmarkBatchSize);
+	std::vector<InstanceMatrices> SimdResults(BenchmarkBatchSize);
+	constexpr size_t FloatsPerInstance = sizeof(InstanceMatrices) / sizeof(float);
+
+	CompareMathPaths("InstanceData (ModelView, MVP e NormalMatrix)", FloatsPerInstance,
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				InstanceMatrices& Instance = GlmResults[BodyIndex];
+				const glm::mat4& ModelMatrix = Bodies.Models[BodyIndex];
+				const glm::mat4 ModelViewMatrix = Bodies.View * ModelMatrix;
+				const glm::mat3 NormalMatrix = glm::transpose(glm::inverse(glm::mat3(ModelViewMatrix)));
+
+				Instance.ModelViewMatrix = ModelViewMatrix;
+				Instance.ModelViewProjection = Bodies.ViewProjection * ModelMatrix;
+				Instance.NormalMatrix[0] = glm::vec4{ NormalMatrix[0], 0.0f };
+				Instance.NormalMatrix[1] = glm::vec4{ NormalMatrix[1], 0.0f };
+				Instance.NormalMatrix[2] = glm::vec4{ NormalMatrix[2], 0.0f };
+			}
+			return glm::value_ptr(GlmResults[0].ModelViewMatrix);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				InstanceMatrices& Instance = AlignedResults[BodyIndex];
+				const glm::aligned_mat4& ModelMatrix = Bodies.AlignedModels[BodyIndex];
+				const glm::aligned_mat4 ModelViewMatrix = Bodies.AlignedView * ModelMatrix;
+				const glm::aligned_mat4 NormalMatrix = glm::transpose(glm::inverse(ModelViewMatrix));
+
+				Instance.ModelViewMatrix = glm::mat4{ ModelViewMatrix };
+				Instance.ModelViewProjection = glm::mat4{ Bodies.AlignedViewProjection * ModelMatrix };
+				Instance.NormalMatrix[0] = glm::vec4{ glm::vec3{ NormalMatrix[0] }, 0.0f };
+				Instance.NormalMatrix[1] = glm::vec4{ glm::vec3{ NormalMatrix[1] }, 0.0f };
+				Instance.NormalMatrix[2] = glm::vec4{ glm::vec3{ NormalMatrix[2] }, 0.0f };
+			}
+			return glm::value_ptr(AlignedResults[0].ModelViewMatrix);
+		},
+		[&]()
+		{
+			for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+			{
+				InstanceMatrices& Instance = SimdResults[BodyIndex];
+				const float* ModelMatrix = glm::value_ptr(Bodies.Models[BodyIndex]);
+				MultiplyMatrices(glm::value_ptr(Bodies.View), ModelMatrix, glm::value_ptr(Instance.ModelViewMatrix));
+				MultiplyMatrices(glm::value_ptr(Bodies.ViewProjection), ModelMatrix, glm::value_ptr(Instance.ModelViewProjection));
+				ComputeNormalMatrix(glm::value_ptr(Instance.ModelViewMatrix), glm::value_ptr(Instance.NormalMatrix[0]));
+			}
+			return glm::value_ptr(SimdResults[0].ModelViewMatrix);
+		});
+}
+
+// A passada do BodyTransforms contra o que o loop de renderizao fazia antes
+// para cada corpo: a cadeia translate * rotate * scale da glm e o
+// InstanceData com a inversa geral. Os resultados no so iguais aos da glm,
+// porque a rotao sai do quaternion em vez do glm::rotate e a NormalMatrix
+// usa a escala uniforme no lugar da inversa: o erro fica entre 5e-6 e 3e-5
+// conforme a CPU e os corpos, ento comparaes precisam de tolerncia 1e-4.
+void BenchmarkBodyTransforms(const BenchmarkBodies& Bodies)
+{
+	BodyTransforms Transforms;
+	Transforms.Resize(BenchmarkBatchSize);
+	for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+	{
+		Transforms.SetTransform(BodyIndex, Bodies.Positions[BodyIndex], glm::angleAxis(Bodies.Angles[BodyIndex], Bodies.Axes[BodyIndex]), Bodies.Scales[BodyIndex]);
+	}
+
+	const std::vector<glm::vec4> TextureLayers(BenchmarkBatchSize, glm::vec4{ 0.0f });
+	std::vector<InstanceData> GlmResults(BenchmarkBatchSize);
+	std::vector<InstanceData> BatchResults(BenchmarkBatchSize);
+	constexpr size_t FloatsPerInstance = sizeof(InstanceData) / sizeof(float);
+
+	auto GlmKernel = [&]()
+	{
+		for (size_t BodyIndex = 0; BodyIndex < BenchmarkBatchSize; ++BodyIndex)
+		{
+			const glm::mat4 Translation = glm::translate(glm::mat4{ 1.0f }, Bodies.Positions[BodyIndex]);
+			const glm::mat4 Rotation = glm::rotate(Translation, Bodies.Angles[BodyIndex], Bodies.Axes[BodyIndex]);
+			const glm::mat4 ModelMatrix = glm::scale(Rotation, glm::vec3{ Bodies.Scales[BodyIndex] });
+			const glm::mat4 ModelViewMatrix = Bodies.View * ModelMatrix;
+			const glm::mat3 NormalMatrix = glm::transpose(glm::inverse(glm::mat3(ModelViewMatrix)));
+
+			InstanceData& Instance = GlmResults[BodyIndex];
+			Instance.ModelViewMatrix = ModelViewMatrix;
+			Instance.ModelViewProjection = Bodies.ViewProjection * ModelMatrix;
+			Instance.NormalMatrix[0] = glm::vec4{ NormalMatrix[0], 0.0f };
+			Instance.NormalMatrix[1] = glm::vec4{ NormalMatrix[1], 0.0f };
+			Instance.NormalMatrix[2] = glm::vec4{ NormalMatrix[2], 0.0f };
+			Instance.TextureLayers = TextureLayers[BodyIndex];
+		}
+		return glm::value_ptr(GlmResults[0].ModelViewMatrix);
+	};
+
+	auto BatchKernel = [&]()
+	{
+		Transforms.Update(Bodies.View, Bodies.ViewProjection, TextureLayers.data(), BatchResults.data());
+		return glm::value_ptr(BatchResults[0].ModelViewMatrix);
+	};
+
+	const BenchmarkResult Glm = RunBenchmark(GlmKernel);
+	const BenchmarkResult Batch = RunBenchmark(BatchKernel);
+
+	PrintBenchmarkHeader("BodyTransforms::Update (modelo e InstanceData)");
+	PrintBenchmarkResult("glm por corpo", Glm, Glm, 0.0f);
+	PrintBenchmarkResult(std::string{ "BodyTransforms " } + GetSimdMathPath(), Batch, Glm, GetMaxError(BatchKernel(), GlmKernel(), FloatsPerInstance * BenchmarkBatchSize));
+}
+
+// Compara os caminhos de matemtica que o loop de renderizao usa por corpo
+void RunMatrixBenchmarks()
+{
+	std::cout << "Lotes de " << BenchmarkBatchSize << " corpos, melhor de " << BenchmarkRounds << " rodadas, uma thread" << std::endl;
+	std::cout << "glm SIMD usa glm::aligned_mat4; SimdMath compilado com " << GetSimdMathPath() << std::endl;
+
+	const BenchmarkBodies Bodies = CreateBenchmarkBodies();
+	BenchmarkMatrixProduct(Bodies);
+	BenchmarkTransformChain(Bodies);
+	BenchmarkNormalMatrix(Bodies);
+	BenchmarkViewProjection(Bodies);
+	BenchmarkInstanceData(Bodies);
+	BenchmarkBodyTransforms(Bodies);
+}
+
+int main(int argc, char** argv)
+{
+	// Os exemplos de antes continuam com --exemplos
+	if (argc > 1 && std::strcmp(argv[1], "--exemplos") == 0)
+	{
+		TranslationMatrix();
+		RotationMatrix();
+		ScaleMatrix();
+		ComposedMatrix();
+		ModelViewProjection();
+		return 0;
+	}
+
+	RunMatrixBenchmarks();
 	return 0;
-}
\ No newline at end of file
+}
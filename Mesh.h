@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+struct Vertex
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec3 Color;
+	glm::vec2 UV;
+};
+
+struct Triangle
+{
+	GLuint V0;
+	GLuint V1;
+	GLuint V2;
+};
+
+// Trecho de um par de buffers compartilhado por várias malhas, nos mesmos
+// termos que um DrawElementsIndirectCommand usa
+struct MeshSection
+{
+	GLuint IndexCount;
+	GLuint FirstIndex;
+	GLint BaseVertex;
+};
+
+// Níveis de detalhe da esfera, do mais detalhado (0) ao mais simples
+namespace SphereLOD
+{
+	constexpr int Count = 3;
+	constexpr GLuint Resolutions[Count] = { 100, 40, 16 };
+
+	// Raio mínimo, em pixels na tela, para usar cada nível
+	constexpr float MinScreenRadius[Count] = { 100.0f, 25.0f, 0.0f };
+
+	int Select(float ScreenRadius);
+}
+
+void GenerateSphere(GLuint Resolution, std::vector<Vertex>& Vertices, std::vector<Triangle>& Indices);
+
+// Adiciona a malha no fim de Vertices/Indices e retorna onde ela ficou
+MeshSection AppendMesh(const std::vector<Vertex>& MeshVertices, const std::vector<Triangle>& MeshIndices, std::vector<Vertex>& Vertices, std::vector<Triangle>& Indices);
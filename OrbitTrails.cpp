@@ -0,0 +1,172 @@
+#include "OrbitTrails.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+void OrbitTrails::Create(GLsizei InNumBodies, double InSampleInterval)
+{
+	NumBodies = std::max<GLsizei>(InNumBodies, 1);
+	SampleInterval = InSampleInterval;
+	Clear();
+
+	// A texture buffer também tem um limite de texels, que pode ser menor
+	GLint MaxTextureBufferSize = 65536;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &MaxTextureBufferSize);
+	const GLsizeiptr TotalSamples = std::min<GLsizeiptr>(MaxTotalSamples, MaxTextureBufferSize);
+	SamplesPerBody = static_cast<GLsizei>(std::clamp<GLsizeiptr>(TotalSamples / NumBodies, 2, MaxSamplesPerBody));
+	if (SamplesPerBody < MaxSamplesPerBody)
+	{
+		std::cout << "Rastro das orbitas com " << SamplesPerBody << " amostras por corpo para " << NumBodies << " corpos" << std::endl;
+	}
+
+	Firsts.resize(NumBodies);
+	Counts.resize(NumBodies);
+	Samples.resize(NumBodies);
+
+	glGenBuffers(1, &PositionBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, PositionBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(SamplesPerBody) * NumBodies * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &PositionTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, PositionTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, PositionBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	// Os elementos das órbitas previstas são enviados a cada draw
+	glGenBuffers(1, &ElementsBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, ElementsBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, NumBodies * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &ElementsTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, ElementsTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ElementsBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	// Os vértices são gerados a partir de gl_VertexID
+	glGenVertexArrays(1, &VertexArrayId);
+}
+
+void OrbitTrails::Release()
+{
+	glDeleteVertexArrays(1, &VertexArrayId);
+	glDeleteTextures(1, &PositionTexture);
+	glDeleteBuffers(1, &PositionBuffer);
+	glDeleteTextures(1, &ElementsTexture);
+	glDeleteBuffers(1, &ElementsBuffer);
+
+	VertexArrayId = 0;
+	PositionTexture = 0;
+	PositionBuffer = 0;
+	ElementsTexture = 0;
+	ElementsBuffer = 0;
+}
+
+void OrbitTrails::Clear()
+{
+	NumSamples = 0;
+	Head = -1;
+}
+
+void OrbitTrails::Update(double Time, const std::vector<glm::mat4>& ModelMatrices)
+{
+	if (NumSamples > 0 && Time - LastSampleTime < SampleInterval)
+	{
+		return;
+	}
+	LastSampleTime = Time;
+
+	for (GLsizei Body = 0; Body < NumBodies; ++Body)
+	{
+		Samples[Body] = ModelMatrices[Body][3];
+	}
+
+	Head = (Head + 1) % SamplesPerBody;
+	NumSamples = std::min(NumSamples + 1, SamplesPerBody);
+
+	const GLsizeiptr SampleSize = NumBodies * sizeof(glm::vec4);
+	glBindBuffer(GL_TEXTURE_BUFFER, PositionBuffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, Head * SampleSize, SampleSize, Samples.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void OrbitTrails::DrawTrails(GLuint ProgramId)
+{
+	if (ProgramId == 0 || NumSamples < 2)
+	{
+		return;
+	}
+
+	// Cada corpo tem SamplesPerBody índices de vértice; só as últimas
+	// NumSamples amostras são desenhadas
+	for (GLsizei Body = 0; Body < NumBodies; ++Body)
+	{
+		Firsts[Body] = Body * SamplesPerBody + (SamplesPerBody - NumSamples);
+		Counts[Body] = NumSamples;
+	}
+
+	glUseProgram(ProgramId);
+	glUniform1i(glGetUniformLocation(ProgramId, "TrailPositions"), 0);
+	glUniform1i(glGetUniformLocation(ProgramId, "NumBodies"), NumBodies);
+	glUniform1i(glGetUniformLocation(ProgramId, "Capacity"), SamplesPerBody);
+	glUniform1i(glGetUniformLocation(ProgramId, "Head"), Head);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, PositionTexture);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glDepthMask(GL_FALSE);
+
+	glBindVertexArray(VertexArrayId);
+	glMultiDrawArrays(GL_LINE_STRIP, Firsts.data(), Counts.data(), NumBodies);
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void OrbitTrails::DrawPredictedOrbits(GLuint ProgramId, const std::vector<glm::vec4>& OrbitElements, const glm::mat4& OrbitMatrix)
+{
+	if (ProgramId == 0)
+	{
+		return;
+	}
+
+	// Um vértice a mais por órbita para fechar o GL_LINE_STRIP
+	for (GLsizei Body = 0; Body < NumBodies; ++Body)
+	{
+		Firsts[Body] = Body * (NumOrbitSegments + 1);
+		Counts[Body] = OrbitElements[Body].w != 0.0f ? NumOrbitSegments + 1 : 0;
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, ElementsBuffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, NumBodies * sizeof(glm::vec4), OrbitElements.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glUseProgram(ProgramId);
+	glUniform1i(glGetUniformLocation(ProgramId, "OrbitElements"), 0);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "OrbitMatrix"), 1, GL_FALSE, glm::value_ptr(OrbitMatrix));
+	glUniform1i(glGetUniformLocation(ProgramId, "NumSegments"), NumOrbitSegments);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, ElementsTexture);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glDepthMask(GL_FALSE);
+
+	glBindVertexArray(VertexArrayId);
+	glMultiDrawArrays(GL_LINE_STRIP, Firsts.data(), Counts.data(), NumBodies);
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
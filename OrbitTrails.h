@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Rastro das órbitas de todos os corpos num único buffer circular na GPU.
+// Cada amostra guarda a posição de todos os corpos lado a lado, então gravar
+// uma amostra é um único glBufferSubData. O vertex shader lê as posições de
+// uma texture buffer a partir de gl_VertexID, e todos os rastros saem de um
+// único glMultiDrawArrays de GL_LINE_STRIP.
+//
+// As órbitas previstas usam o mesmo draw, mas os pontos são calculados no
+// vertex shader a partir dos elementos da órbita, lidos de outra texture
+// buffer, sem nenhum vértice.
+//
+// Todos os corpos da cena têm rastro. Com muitos corpos o rastro de cada um
+// fica mais curto, para o buffer não passar de MaxTotalSamples amostras.
+class OrbitTrails
+{
+public:
+	// Amostras guardadas por corpo em cenas pequenas
+	static constexpr GLsizei MaxSamplesPerBody = 512;
+
+	// 16 MB de posições
+	static constexpr GLsizeiptr MaxTotalSamples = 1 << 20;
+
+	// Segmentos de cada órbita prevista
+	static constexpr GLsizei NumOrbitSegments = 256;
+
+	void Create(GLsizei NumBodies, double SampleInterval);
+	void Release();
+
+	// Descarta as amostras, para quando os índices dos corpos mudam
+	void Clear();
+
+	// Grava a posição (coluna 3 da matriz de modelo) de todos os corpos se
+	// já passou SampleInterval desde a última amostra
+	void Update(double Time, const std::vector<glm::mat4>& ModelMatrices);
+
+	void DrawTrails(GLuint ProgramId);
+
+	// OrbitElements: xyz é o raio da órbita como em CelestialBody e w é 0
+	// para os corpos que não orbitam. OrbitMatrix leva o plano das órbitas
+	// para o espaço do mundo.
+	void DrawPredictedOrbits(GLuint ProgramId, const std::vector<glm::vec4>& OrbitElements, const glm::mat4& OrbitMatrix);
+
+private:
+	GLsizei NumBodies = 0;
+	GLsizei SamplesPerBody = 0;
+	double SampleInterval = 0.0;
+	double LastSampleTime = 0.0;
+	GLsizei NumSamples = 0;
+	GLint Head = -1;
+
+	GLuint VertexArrayId = 0;
+	GLuint PositionBuffer = 0;
+	GLuint PositionTexture = 0;
+	GLuint ElementsBuffer = 0;
+	GLuint ElementsTexture = 0;
+
+	// Preenchidos a cada draw sem realocar
+	std::vector<GLint> Firsts;
+	std::vector<GLsizei> Counts;
+	std::vector<glm::vec4> Samples;
+};
@@ -0,0 +1,174 @@
+#include "PlanetRings.h"
+
+#include <vector>
+
+#include <glm/ext.hpp>
+
+#include "deps/stb/stb_perlin.h"
+
+namespace
+{
+	constexpr GLuint RingSegments = 256;
+	constexpr GLuint RingRadialSteps = 4;
+	constexpr GLsizei RadialTextureSize = 512;
+
+	// Perfil radial dos anéis de Saturno, em raios do planeta
+	struct RingBand
+	{
+		float Start;
+		float End;
+		float Density;
+		float Brightness;
+	};
+
+	constexpr RingBand SaturnBands[] =
+	{
+		{ 1.24f, 1.53f, 0.2f, 0.6f },  // Anel C
+		{ 1.53f, 1.95f, 0.9f, 1.0f },  // Anel B
+		{ 1.95f, 2.03f, 0.05f, 0.5f }, // Divisão de Cassini
+		{ 2.03f, 2.21f, 0.65f, 0.9f }, // Anel A
+		{ 2.21f, 2.22f, 0.05f, 0.5f }, // Divisão de Encke
+		{ 2.22f, 2.27f, 0.55f, 0.85f },
+	};
+
+	GLuint CreateRadialTexture(float InnerRadius, float OuterRadius)
+	{
+		const glm::vec3 RingColor{ 0.82f, 0.74f, 0.6f };
+
+		std::vector<glm::u8vec4> Texels(RadialTextureSize);
+		for (GLsizei Texel = 0; Texel < RadialTextureSize; ++Texel)
+		{
+			const float Radius = glm::mix(InnerRadius, OuterRadius, (Texel + 0.5f) / RadialTextureSize);
+
+			float Density = 0.0f;
+			float Brightness = 0.0f;
+			for (const RingBand& Band : SaturnBands)
+			{
+				if (Radius >= Band.Start && Radius < Band.End)
+				{
+					Density = Band.Density;
+					Brightness = Band.Brightness;
+					break;
+				}
+			}
+
+			// Ruído em alta frequência cria as faixas finas dentro de cada anel
+			const float Noise = stb_perlin_fbm_noise3(Radius * 40.0f, 0.5f, 0.5f, 2.0f, 0.5f, 4);
+			Density = glm::clamp(Density * (1.0f + 0.3f * Noise), 0.0f, 1.0f);
+			Brightness = glm::clamp(Brightness * (1.0f + 0.15f * Noise), 0.0f, 1.0f);
+
+			Texels[Texel] = glm::u8vec4{ glm::vec4{ RingColor * Brightness, Density } * 255.0f };
+		}
+
+		GLuint TextureId;
+		glGenTextures(1, &TextureId);
+		glBindTexture(GL_TEXTURE_1D, TextureId);
+		glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, RadialTextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, Texels.data());
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glGenerateMipmap(GL_TEXTURE_1D);
+		glBindTexture(GL_TEXTURE_1D, 0);
+
+		return TextureId;
+	}
+}
+
+void PlanetRings::Create(float InInnerRadius, float InOuterRadius)
+{
+	InnerRadius = InInnerRadius;
+	OuterRadius = InOuterRadius;
+
+	// Coroa circular no plano XY do planeta, perpendicular aos polos (eixo Z)
+	std::vector<glm::vec2> Vertices;
+	std::vector<GLuint> Indices;
+	for (GLuint Step = 0; Step <= RingRadialSteps; ++Step)
+	{
+		const float Radius = glm::mix(InnerRadius, OuterRadius, static_cast<float>(Step) / RingRadialSteps);
+		for (GLuint Segment = 0; Segment < RingSegments; ++Segment)
+		{
+			const float Angle = glm::two_pi<float>() * Segment / RingSegments;
+			Vertices.push_back(glm::vec2{ glm::cos(Angle), glm::sin(Angle) } * Radius);
+		}
+	}
+
+	for (GLuint Step = 0; Step < RingRadialSteps; ++Step)
+	{
+		for (GLuint Segment = 0; Segment < RingSegments; ++Segment)
+		{
+			const GLuint Next = (Segment + 1) % RingSegments;
+			const GLuint P0 = Step * RingSegments + Segment;
+			const GLuint P1 = Step * RingSegments + Next;
+			const GLuint P2 = (Step + 1) * RingSegments + Segment;
+			const GLuint P3 = (Step + 1) * RingSegments + Next;
+
+			Indices.insert(Indices.end(), { P0, P1, P3, P0, P3, P2 });
+		}
+	}
+	IndexCount = static_cast<GLsizei>(Indices.size());
+
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenBuffers(1, &VertexBuffer);
+	glGenBuffers(1, &ElementBuffer);
+
+	glBindVertexArray(VertexArrayId);
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(glm::vec2), Vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(GLuint), Indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	RadialTextureId = CreateRadialTexture(InnerRadius, OuterRadius);
+}
+
+void PlanetRings::Release()
+{
+	glDeleteTextures(1, &RadialTextureId);
+	glDeleteBuffers(1, &ElementBuffer);
+	glDeleteBuffers(1, &VertexBuffer);
+	glDeleteVertexArrays(1, &VertexArrayId);
+
+	RadialTextureId = 0;
+	ElementBuffer = 0;
+	VertexBuffer = 0;
+	VertexArrayId = 0;
+}
+
+void PlanetRings::Draw(GLuint ProgramId, const glm::mat4& PlanetModelMatrix, float PlanetRadius, float Tilt) const
+{
+	if (ProgramId == 0)
+	{
+		return;
+	}
+
+	const glm::mat4 ModelMatrix = glm::rotate(PlanetModelMatrix, Tilt, glm::vec3{ 1.0f, 0.0f, 0.0f });
+
+	glUseProgram(ProgramId);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "ModelMatrix"), 1, GL_FALSE, glm::value_ptr(ModelMatrix));
+	glUniform4fv(glGetUniformLocation(ProgramId, "PlanetSphere"), 1, glm::value_ptr(glm::vec4{ glm::vec3(PlanetModelMatrix[3]), PlanetRadius }));
+	glUniform2f(glGetUniformLocation(ProgramId, "RingRadii"), InnerRadius, OuterRadius);
+	glUniform1i(glGetUniformLocation(ProgramId, "RadialTexture"), 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_1D, RadialTextureId);
+
+	// Visível dos dois lados e sem escrever profundidade, para não esconder
+	// o que estiver atrás das partes transparentes
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_CULL_FACE);
+
+	glBindVertexArray(VertexArrayId);
+	glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, nullptr);
+	glBindVertexArray(0);
+
+	glEnable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_1D, 0);
+}
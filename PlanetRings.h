@@ -0,0 +1,30 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Anéis desenhados como uma única coroa circular no plano do equador do
+// planeta. A densidade e a cor vêm de uma textura 1D indexada pela distância
+// ao centro, e a sombra do planeta é calculada analiticamente no shader.
+class PlanetRings
+{
+public:
+	// Raios em unidades do raio do planeta
+	void Create(float InnerRadius, float OuterRadius);
+	void Release();
+
+	// Precisa ser desenhado depois dos objetos opacos. O anel é plano e não se
+	// sobrepõe, então o teste de profundidade contra o planeta já resolve a
+	// ordem: a metade de trás fica escondida e a da frente é misturada por cima.
+	void Draw(GLuint ProgramId, const glm::mat4& PlanetModelMatrix, float PlanetRadius, float Tilt) const;
+
+private:
+	GLuint VertexArrayId = 0;
+	GLuint VertexBuffer = 0;
+	GLuint ElementBuffer = 0;
+	GLuint RadialTextureId = 0;
+	GLsizei IndexCount = 0;
+
+	float InnerRadius = 0.0f;
+	float OuterRadius = 0.0f;
+};
@@ -0,0 +1,453 @@
+#include "PlanetTerrain.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <glm/ext.hpp>
+
+#include "deps/stb/stb_image.h"
+#include "deps/stb/stb_perlin.h"
+
+namespace
+{
+	constexpr int VerticesPerPatch = PlanetTerrain::PatchResolution * PlanetTerrain::PatchResolution + 4 * PlanetTerrain::PatchResolution;
+
+	// Oitavas e frequência do ruído usado quando não há mapa de altura
+	constexpr int NoiseOctaves = 10;
+	constexpr float NoiseFrequency = 4.0f;
+
+	// Normal, direita e cima de cada face do cubo, com Direita x Cima = Normal
+	// para os triângulos da grade ficarem no sentido anti-horário vistos de fora
+	const glm::vec3 FaceAxes[6][3] =
+	{
+		{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } },
+		{ { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } },
+		{ { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+		{ { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+	};
+
+	// Mesmo mapeamento equirretangular do GenerateSphere, com o polo em Z
+	glm::vec2 GetSphereUV(const glm::vec3& Direction)
+	{
+		const float Theta = glm::atan(Direction.y, Direction.x);
+		const float Phi = glm::acos(glm::clamp(Direction.z, -1.0f, 1.0f));
+		return { 1.0f - Theta / glm::two_pi<float>(), 1.0f - Phi / glm::pi<float>() };
+	}
+}
+
+void PlanetTerrain::Create()
+{
+	constexpr int R = PatchResolution;
+
+	std::vector<Triangle> Indices;
+	for (int Y = 0; Y < R - 1; ++Y)
+	{
+		for (int X = 0; X < R - 1; ++X)
+		{
+			const GLuint P0 = Y * R + X;
+			const GLuint P1 = P0 + 1;
+			const GLuint P2 = P0 + R + 1;
+			const GLuint P3 = P0 + R;
+			Indices.push_back({ P0, P1, P2 });
+			Indices.push_back({ P0, P2, P3 });
+		}
+	}
+
+	// Saias das quatro bordas, nas duas faces porque a orientação muda de uma
+	// borda para outra. Os vértices da saia vêm depois da grade, uma borda de
+	// cada vez: baixo, cima, esquerda e direita.
+	for (int Edge = 0; Edge < 4; ++Edge)
+	{
+		for (int Index = 0; Index < R - 1; ++Index)
+		{
+			auto EdgeVertex = [&](int K) -> GLuint
+			{
+				switch (Edge)
+				{
+					case 0: return K;
+					case 1: return (R - 1) * R + K;
+					case 2: return K * R;
+					default: return K * R + R - 1;
+				}
+			};
+
+			const GLuint Top0 = EdgeVertex(Index);
+			const GLuint Top1 = EdgeVertex(Index + 1);
+			const GLuint Bottom0 = R * R + Edge * R + Index;
+			const GLuint Bottom1 = Bottom0 + 1;
+			Indices.push_back({ Top0, Bottom0, Bottom1 });
+			Indices.push_back({ Top0, Bottom1, Top1 });
+			Indices.push_back({ Top0, Bottom1, Bottom0 });
+			Indices.push_back({ Top0, Top1, Bottom1 });
+		}
+	}
+	IndexCount = static_cast<GLsizei>(Indices.size() * 3);
+
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenBuffers(1, &VertexBufferId);
+	glGenBuffers(1, &ElementBufferId);
+
+	glBindVertexArray(VertexArrayId);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBufferId);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(MaxCachedPatches) * VerticesPerPatch * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ElementBufferId);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(Triangle), Indices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Normal)));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Color)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, UV)));
+
+	glBindVertexArray(0);
+
+	// Nunca passam do tamanho do cache, então os frames não realocam
+	SlotByKey.reserve(MaxCachedPatches);
+	DrawBaseVertices.reserve(MaxCachedPatches);
+	DrawCounts.reserve(MaxCachedPatches);
+	DrawIndices.reserve(MaxCachedPatches);
+
+	ClearCache();
+}
+
+void PlanetTerrain::Release()
+{
+	glDeleteBuffers(1, &ElementBufferId);
+	glDeleteBuffers(1, &VertexBufferId);
+	glDeleteVertexArrays(1, &VertexArrayId);
+
+	ElementBufferId = 0;
+	VertexBufferId = 0;
+	VertexArrayId = 0;
+	BodyIndex = -1;
+	Heightmap.clear();
+	Slots.clear();
+	SlotByKey.clear();
+}
+
+void PlanetTerrain::SetBody(int InBodyIndex, const TerrainDesc& InDesc)
+{
+	if (InBodyIndex == BodyIndex)
+	{
+		return;
+	}
+
+	ClearCache();
+	BodyIndex = InBodyIndex;
+	Heightmap.clear();
+	HeightmapWidth = 0;
+	HeightmapHeight = 0;
+
+	if (BodyIndex < 0)
+	{
+		return;
+	}
+
+	Desc = InDesc;
+
+	if (!Desc.HeightmapFile.empty())
+	{
+		int NumComponents = 0;
+		if (unsigned char* HeightData = stbi_load(Desc.HeightmapFile.c_str(), &HeightmapWidth, &HeightmapHeight, &NumComponents, 1))
+		{
+			std::cout << "Carregando relevo " << Desc.HeightmapFile << std::endl;
+			Heightmap.resize(static_cast<size_t>(HeightmapWidth) * HeightmapHeight);
+			for (size_t Texel = 0; Texel < Heightmap.size(); ++Texel)
+			{
+				Heightmap[Texel] = HeightData[Texel] / 255.0f;
+			}
+			stbi_image_free(HeightData);
+		}
+		else
+		{
+			std::cout << "Relevo " << Desc.HeightmapFile << " nao encontrado, usando ruido" << std::endl;
+		}
+	}
+
+	// As seis raízes ficam sempre no cache, então sempre há o que desenhar
+	for (int Face = 0; Face < 6; ++Face)
+	{
+		const int Slot = AllocateSlot();
+		BuildPatch({ Face, 0, 0, 0 }, Slot);
+		Slots[Slot].bPinned = true;
+	}
+}
+
+void PlanetTerrain::Update(const glm::vec3& LocalCamera, const Frustum& LocalFrustum, float PixelsPerUnit)
+{
+	if (BodyIndex < 0)
+	{
+		return;
+	}
+
+	++FrameIndex;
+	DrawBaseVertices.clear();
+	MissingNodes.clear();
+
+	// Ângulo, a partir do centro do planeta, além do qual nada aparece: o
+	// horizonte da câmera mais o quanto o relevo mais alto enxerga além dele
+	const float CameraDistance = glm::length(LocalCamera);
+	const float HorizonAngle = CameraDistance > 1.0f ? glm::acos(1.0f / CameraDistance) + glm::acos(1.0f / (1.0f + Desc.HeightScale)) : glm::pi<float>();
+
+	for (int Face = 0; Face < 6; ++Face)
+	{
+		Select({ Face, 0, 0, 0 }, LocalCamera, LocalFrustum, PixelsPerUnit, HorizonAngle);
+	}
+
+	// Os patches menos detalhados primeiro, para os buracos fecharem rápido
+	std::sort(MissingNodes.begin(), MissingNodes.end(), [](const Node& A, const Node& B) { return A.Depth < B.Depth; });
+
+	int NumBuilds = 0;
+	for (const Node& MissingNode : MissingNodes)
+	{
+		if (NumBuilds == MaxBuildsPerFrame)
+		{
+			break;
+		}
+
+		const int Slot = AllocateSlot();
+		if (Slot < 0)
+		{
+			break;
+		}
+		BuildPatch(MissingNode, Slot);
+		++NumBuilds;
+	}
+
+	DrawCounts.assign(DrawBaseVertices.size(), IndexCount);
+	DrawIndices.assign(DrawBaseVertices.size(), nullptr);
+}
+
+void PlanetTerrain::Draw()
+{
+	if (BodyIndex < 0 || DrawBaseVertices.empty())
+	{
+		return;
+	}
+
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, DrawCounts.data(), GL_UNSIGNED_INT, DrawIndices.data(), static_cast<GLsizei>(DrawBaseVertices.size()), DrawBaseVertices.data());
+}
+
+uint64_t PlanetTerrain::GetNodeKey(const Node& TerrainNode)
+{
+	return (static_cast<uint64_t>(TerrainNode.Face) << 61) | (static_cast<uint64_t>(TerrainNode.Depth) << 56) |
+	       (static_cast<uint64_t>(TerrainNode.X) << 28) | static_cast<uint64_t>(TerrainNode.Y);
+}
+
+glm::vec3 PlanetTerrain::GetNodeDirection(const Node& TerrainNode, float S, float T)
+{
+	// Coordenadas na face, de -1 a 1. A tangente deixa os patches com
+	// tamanhos parecidos na esfera, em vez de menores perto das arestas.
+	const float NodeSize = 2.0f / static_cast<float>(1 << TerrainNode.Depth);
+	const float U = glm::tan(glm::quarter_pi<float>() * (-1.0f + (TerrainNode.X + S) * NodeSize));
+	const float V = glm::tan(glm::quarter_pi<float>() * (-1.0f + (TerrainNode.Y + T) * NodeSize));
+
+	const glm::vec3* Axes = FaceAxes[TerrainNode.Face];
+	return glm::normalize(Axes[0] + U * Axes[1] + V * Axes[2]);
+}
+
+float PlanetTerrain::SampleHeight(const glm::vec3& Direction) const
+{
+	if (!Heightmap.empty())
+	{
+		// Bilinear, dando a volta na longitude
+		const glm::vec2 UV = GetSphereUV(Direction);
+		const float X = (UV.x - glm::floor(UV.x)) * HeightmapWidth - 0.5f;
+		const float Y = glm::clamp(UV.y * HeightmapHeight - 0.5f, 0.0f, static_cast<float>(HeightmapHeight - 1));
+
+		const int X0 = static_cast<int>(glm::floor(X));
+		const int Y0 = static_cast<int>(Y);
+		const float FracX = X - X0;
+		const float FracY = Y - Y0;
+
+		auto Texel = [&](int TexelX, int TexelY)
+		{
+			TexelX = (TexelX % HeightmapWidth + HeightmapWidth) % HeightmapWidth;
+			TexelY = glm::min(TexelY, HeightmapHeight - 1);
+			return Heightmap[static_cast<size_t>(TexelY) * HeightmapWidth + TexelX];
+		};
+
+		const float Top = glm::mix(Texel(X0, Y0), Texel(X0 + 1, Y0), FracX);
+		const float Bottom = glm::mix(Texel(X0, Y0 + 1), Texel(X0 + 1, Y0 + 1), FracX);
+		return glm::mix(Top, Bottom, FracY) * Desc.HeightScale;
+	}
+
+	const glm::vec3 NoisePosition = Direction * NoiseFrequency + glm::vec3{ Desc.NoiseSeed * 31.7f };
+	const float Noise = stb_perlin_fbm_noise3(NoisePosition.x, NoisePosition.y, NoisePosition.z, 2.0f, 0.5f, NoiseOctaves);
+	return glm::clamp(Noise * 0.5f + 0.5f, 0.0f, 1.0f) * Desc.HeightScale;
+}
+
+void PlanetTerrain::Select(const Node& TerrainNode, const glm::vec3& LocalCamera, const Frustum& LocalFrustum, float PixelsPerUnit, float HorizonAngle)
+{
+	// Esfera envolvente a partir dos cantos na superfície, mais o relevo
+	const glm::vec3 CenterDirection = GetNodeDirection(TerrainNode, 0.5f, 0.5f);
+	float Radius = 0.0f;
+	for (int Corner = 0; Corner < 4; ++Corner)
+	{
+		Radius = glm::max(Radius, glm::distance(CenterDirection, GetNodeDirection(TerrainNode, static_cast<float>(Corner & 1), static_cast<float>(Corner >> 1))));
+	}
+	Radius += Desc.HeightScale;
+	const glm::vec3 Center = CenterDirection * (1.0f + 0.5f * Desc.HeightScale);
+
+	// Na esfera unitária a corda é próxima do ângulo, então o raio também
+	// serve de raio angular para o teste do horizonte
+	const float CameraAngle = glm::acos(glm::clamp(glm::dot(CenterDirection, glm::normalize(LocalCamera)), -1.0f, 1.0f));
+	if (CameraAngle > HorizonAngle + Radius || !IsSphereVisible(LocalFrustum, Center, Radius))
+	{
+		return;
+	}
+
+	// Quem chama garante que o nó está no cache
+	const int Slot = FindSlot(TerrainNode);
+	Slots[Slot].LastUsedFrame = FrameIndex;
+
+	// Erro de um triângulo: o tamanho de uma célula da grade, que encolhe pela
+	// metade a cada nível, projetado na tela a partir do ponto mais próximo
+	const float CellSize = glm::half_pi<float>() / static_cast<float>((1 << TerrainNode.Depth) * (PatchResolution - 1));
+	const float Distance = glm::max(glm::distance(LocalCamera, Center) - Radius, 1e-6f);
+	const float ScreenError = CellSize / Distance * PixelsPerUnit;
+
+	if (TerrainNode.Depth < MaxDepth && ScreenError > MaxScreenError)
+	{
+		Node Children[4];
+		bool bChildrenReady = true;
+		for (int Child = 0; Child < 4; ++Child)
+		{
+			Children[Child] = { TerrainNode.Face, TerrainNode.Depth + 1, TerrainNode.X * 2 + (Child & 1), TerrainNode.Y * 2 + (Child >> 1) };
+			if (FindSlot(Children[Child]) < 0)
+			{
+				MissingNodes.push_back(Children[Child]);
+				bChildrenReady = false;
+			}
+		}
+
+		if (bChildrenReady)
+		{
+			for (const Node& Child : Children)
+			{
+				Select(Child, LocalCamera, LocalFrustum, PixelsPerUnit, HorizonAngle);
+			}
+			return;
+		}
+	}
+
+	DrawBaseVertices.push_back(Slot * VerticesPerPatch);
+}
+
+int PlanetTerrain::FindSlot(const Node& TerrainNode) const
+{
+	const auto It = SlotByKey.find(GetNodeKey(TerrainNode));
+	return It != SlotByKey.end() ? It->second : -1;
+}
+
+int PlanetTerrain::AllocateSlot()
+{
+	// Um slot livre, ou o usado há mais tempo entre os que não foram
+	// desenhados neste frame
+	int Oldest = -1;
+	for (int SlotIndex = 0; SlotIndex < static_cast<int>(Slots.size()); ++SlotIndex)
+	{
+		const CacheSlot& Slot = Slots[SlotIndex];
+		if (!Slot.bUsed)
+		{
+			return SlotIndex;
+		}
+
+		if (!Slot.bPinned && Slot.LastUsedFrame < FrameIndex && (Oldest < 0 || Slot.LastUsedFrame < Slots[Oldest].LastUsedFrame))
+		{
+			Oldest = SlotIndex;
+		}
+	}
+
+	if (Oldest >= 0)
+	{
+		SlotByKey.erase(Slots[Oldest].Key);
+		Slots[Oldest] = CacheSlot{};
+	}
+
+	return Oldest;
+}
+
+void PlanetTerrain::BuildPatch(const Node& TerrainNode, int Slot)
+{
+	constexpr int R = PatchResolution;
+
+	// Grade com uma linha extra em volta, usada só para as normais
+	constexpr int Border = R + 2;
+	glm::vec3 Positions[Border * Border];
+	for (int Y = 0; Y < Border; ++Y)
+	{
+		for (int X = 0; X < Border; ++X)
+		{
+			const glm::vec3 Direction = GetNodeDirection(TerrainNode, (X - 1) / static_cast<float>(R - 1), (Y - 1) / static_cast<float>(R - 1));
+			Positions[Y * Border + X] = Direction * (1.0f + SampleHeight(Direction));
+		}
+	}
+
+	// A longitude é desenrolada em volta do centro do patch para não dar a
+	// volta no meio de um triângulo
+	const float CenterU = GetSphereUV(GetNodeDirection(TerrainNode, 0.5f, 0.5f)).x;
+
+	Vertex PatchVertices[VerticesPerPatch];
+	for (int Y = 0; Y < R; ++Y)
+	{
+		for (int X = 0; X < R; ++X)
+		{
+			const glm::vec3* P = &Positions[(Y + 1) * Border + X + 1];
+			const glm::vec3 Direction = glm::normalize(*P);
+
+			glm::vec3 Normal = glm::normalize(glm::cross(P[1] - P[-1], P[Border] - P[-Border]));
+			if (glm::dot(Normal, Direction) < 0.0f)
+			{
+				Normal = -Normal;
+			}
+
+			glm::vec2 UV = GetSphereUV(Direction);
+			UV.x += glm::round(CenterU - UV.x);
+
+			PatchVertices[Y * R + X] = Vertex{ *P, Normal, glm::vec3{ 1.0f, 1.0f, 1.0f }, UV };
+		}
+	}
+
+	// A saia desce o bastante para cobrir a diferença entre um patch e o
+	// vizinho de um nível acima
+	const float PatchAngle = glm::half_pi<float>() / static_cast<float>(1 << TerrainNode.Depth);
+	const float SkirtDepth = glm::min(0.25f * PatchAngle, 2.0f * Desc.HeightScale) + PatchAngle / (R - 1);
+	for (int Edge = 0; Edge < 4; ++Edge)
+	{
+		for (int Index = 0; Index < R; ++Index)
+		{
+			const int EdgeVertex = Edge == 0 ? Index : Edge == 1 ? (R - 1) * R + Index : Edge == 2 ? Index * R : Index * R + R - 1;
+			Vertex SkirtVertex = PatchVertices[EdgeVertex];
+			SkirtVertex.Position -= glm::normalize(SkirtVertex.Position) * SkirtDepth;
+			PatchVertices[R * R + Edge * R + Index] = SkirtVertex;
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBufferId);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(Slot) * VerticesPerPatch * sizeof(Vertex), sizeof(PatchVertices), PatchVertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	CacheSlot& NewSlot = Slots[Slot];
+	NewSlot.Key = GetNodeKey(TerrainNode);
+	NewSlot.LastUsedFrame = FrameIndex;
+	NewSlot.bUsed = true;
+	NewSlot.bPinned = false;
+	SlotByKey[NewSlot.Key] = Slot;
+}
+
+void PlanetTerrain::ClearCache()
+{
+	Slots.assign(MaxCachedPatches, CacheSlot{});
+	SlotByKey.clear();
+	DrawBaseVertices.clear();
+	DrawCounts.clear();
+	DrawIndices.clear();
+	MissingNodes.clear();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+#include "Mesh.h"
+#include "PoolAllocator.h"
+
+// Relevo de um planeta, em unidades do raio
+struct TerrainDesc
+{
+	// Mapa de altura equirretangular em tons de cinza, com o mesmo
+	// mapeamento da textura do planeta. Sem o arquivo o relevo é ruído de Perlin.
+	std::string HeightmapFile;
+	float HeightScale;
+	int NoiseSeed;
+};
+
+// Terreno para a aproximação da superfície de um planeta. A esfera é um cubo
+// projetado, com uma quadtree em cada face: um patch se divide em quatro
+// quando o erro de um triângulo dele, projetado na tela, passa de
+// MaxScreenError pixels. Todo patch tem a mesma grade, então o número de
+// patches desenhados depende da resolução da tela, e não da distância da
+// câmera.
+//
+// Os patches ficam num cache de tamanho fixo, num único vertex buffer
+// dividido em slots, e são gerados na CPU, no máximo MaxBuildsPerFrame por
+// frame. Enquanto os quatro filhos não estão no cache o pai continua sendo
+// desenhado. Cada patch tem uma saia que desce em direção ao centro do
+// planeta nas bordas, o que cobre as frestas entre patches de níveis
+// diferentes.
+//
+// Só um planeta usa o terreno por vez: trocar de planeta esvazia o cache.
+class PlanetTerrain
+{
+public:
+	// Vértices por lado da grade de um patch
+	static constexpr int PatchResolution = 33;
+	static constexpr int MaxDepth = 16;
+	static constexpr int MaxCachedPatches = 512;
+	static constexpr int MaxBuildsPerFrame = 4;
+	static constexpr float MaxScreenError = 4.0f;
+
+	void Create();
+	void Release();
+
+	// Troca o planeta do terreno. BodyIndex -1 desliga o terreno.
+	void SetBody(int InBodyIndex, const TerrainDesc& InDesc);
+	int GetBody() const { return BodyIndex; }
+
+	// Escolhe os patches do frame e gera os que faltam. A câmera e o frustum
+	// estão no espaço do planeta, onde o raio é 1.
+	void Update(const glm::vec3& LocalCamera, const Frustum& LocalFrustum, float PixelsPerUnit);
+
+	// O VAO já tem os atributos 0 a 3 apontados para os patches; os
+	// atributos por instância ficam por conta de quem desenha
+	GLuint GetVertexArray() const { return VertexArrayId; }
+
+	// Desenha os patches escolhidos com o programa e o VAO já ligados
+	void Draw();
+
+	PoolCounters GetNodeCounters() const { return NodePool.GetCounters(); }
+
+private:
+	struct Node
+	{
+		int Face;
+		int Depth;
+		int X;
+		int Y;
+	};
+
+	struct CacheSlot
+	{
+		uint64_t Key = 0;
+		uint64_t LastUsedFrame = 0;
+		bool bUsed = false;
+		bool bPinned = false;
+	};
+
+	static uint64_t GetNodeKey(const Node& TerrainNode);
+	static glm::vec3 GetNodeDirection(const Node& TerrainNode, float S, float T);
+
+	float SampleHeight(const glm::vec3& Direction) const;
+	void Select(const Node& TerrainNode, const glm::vec3& LocalCamera, const Frustum& LocalFrustum, float PixelsPerUnit, float HorizonAngle);
+	int FindSlot(const Node& TerrainNode) const;
+	int AllocateSlot();
+	void BuildPatch(const Node& TerrainNode, int Slot);
+	void ClearCache();
+
+	int BodyIndex = -1;
+	TerrainDesc Desc;
+
+	// Alturas de 0 a 1 do mapa de altura, vazio quando o relevo é ruído
+	std::vector<float> Heightmap;
+	int HeightmapWidth = 0;
+	int HeightmapHeight = 0;
+
+	GLuint VertexArrayId = 0;
+	GLuint VertexBufferId = 0;
+	GLuint ElementBufferId = 0;
+	GLsizei IndexCount = 0;
+
+	// Os nós do mapa vêm de um pool do tamanho do cache, então gerar e
+	// descartar patches durante o voo não aloca. O bloco tem folga para os
+	// ponteiros e o hash que cada biblioteca padrão guarda junto do par.
+	using SlotMapValue = std::pair<const uint64_t, int>;
+	static constexpr size_t SlotNodeSize = sizeof(SlotMapValue) + 2 * sizeof(void*);
+
+	std::vector<CacheSlot> Slots;
+	PoolAllocator NodePool{ SlotNodeSize, MaxCachedPatches };
+	std::unordered_map<uint64_t, int, std::hash<uint64_t>, std::equal_to<uint64_t>, PoolStlAllocator<SlotMapValue>> SlotByKey{ 0, std::hash<uint64_t>{}, std::equal_to<uint64_t>{}, PoolStlAllocator<SlotMapValue>{ &NodePool } };
+	uint64_t FrameIndex = 0;
+
+	// Preenchidos por Update: um draw por patch, todos num único glMultiDrawElementsBaseVertex
+	std::vector<GLint> DrawBaseVertices;
+	std::vector<GLsizei> DrawCounts;
+	std::vector<void*> DrawIndices;
+	std::vector<Node> MissingNodes;
+};
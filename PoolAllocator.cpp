@@ -0,0 +1,58 @@
+#include "PoolAllocator.h"
+
+#include <algorithm>
+
+PoolAllocator::PoolAllocator(size_t InBlockSize, size_t InBlocksPerChunk)
+	: BlockSize((std::max(InBlockSize, sizeof(FreeBlock)) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t))
+	, BlocksPerChunk(std::max<size_t>(InBlocksPerChunk, 1))
+{
+}
+
+void* PoolAllocator::Allocate()
+{
+	if (!FirstFree)
+	{
+		AddChunk();
+	}
+
+	FreeBlock* Block = FirstFree;
+	FirstFree = Block->Next;
+	NumAllocated++;
+	return Block;
+}
+
+void PoolAllocator::Free(void* Pointer)
+{
+	if (!Pointer)
+	{
+		return;
+	}
+
+	FreeBlock* Block = static_cast<FreeBlock*>(Pointer);
+	Block->Next = FirstFree;
+	FirstFree = Block;
+	NumAllocated--;
+}
+
+PoolCounters PoolAllocator::GetCounters() const
+{
+	PoolCounters Counters;
+	Counters.NumAllocated = NumAllocated;
+	Counters.Capacity = Chunks.size() * BlocksPerChunk;
+	Counters.NumChunks = Chunks.size();
+	return Counters;
+}
+
+void PoolAllocator::AddChunk()
+{
+	Chunks.emplace_back(new unsigned char[BlockSize * BlocksPerChunk]);
+	unsigned char* Chunk = Chunks.back().get();
+
+	// Encadeados na ordem da memória, assim os primeiros blocos entregues são vizinhos
+	for (size_t BlockIndex = BlocksPerChunk; BlockIndex-- > 0;)
+	{
+		FreeBlock* Block = reinterpret_cast<FreeBlock*>(Chunk + BlockIndex * BlockSize);
+		Block->Next = FirstFree;
+		FirstFree = Block;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+struct PoolCounters
+{
+	size_t NumAllocated = 0;
+	size_t Capacity = 0;
+	size_t NumChunks = 0;
+};
+
+// Blocos de tamanho fixo para objetos que vivem vários frames e são criados
+// e destruídos aos poucos, como os nós do cache do terreno e os tiles em
+// carregamento. Os blocos livres formam uma lista encadeada dentro deles
+// mesmos e a memória vem em chunks de BlocksPerChunk blocos, que só são
+// devolvidos na destrução: depois que o pool chega no tamanho de trabalho,
+// criar e destruir não alocam mais.
+//
+// Não é thread-safe.
+class PoolAllocator
+{
+public:
+	PoolAllocator(size_t InBlockSize, size_t InBlocksPerChunk);
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	// Os blocos têm o alinhamento de std::max_align_t
+	void* Allocate();
+	void Free(void* Pointer);
+
+	size_t GetBlockSize() const { return BlockSize; }
+	PoolCounters GetCounters() const;
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+
+	void AddChunk();
+
+	size_t BlockSize;
+	size_t BlocksPerChunk;
+	FreeBlock* FirstFree = nullptr;
+	size_t NumAllocated = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> Chunks;
+};
+
+// Adapta o PoolAllocator para os containers da biblioteca padrão. Só os
+// pedidos de um objeto vão para o pool, que é o que os containers baseados
+// em nós fazem para cada elemento; os arrays de buckets vão para o heap e
+// precisam de reserve() para não crescer durante os frames.
+template<typename T>
+class PoolStlAllocator
+{
+public:
+	using value_type = T;
+
+	explicit PoolStlAllocator(PoolAllocator* InPool) : Pool(InPool) {}
+
+	template<typename U>
+	PoolStlAllocator(const PoolStlAllocator<U>& Other) : Pool(Other.GetPool()) {}
+
+	T* allocate(size_t Count)
+	{
+		if (IsPooled(Count))
+		{
+			return static_cast<T*>(Pool->Allocate());
+		}
+		return static_cast<T*>(::operator new(Count * sizeof(T)));
+	}
+
+	void deallocate(T* Pointer, size_t Count)
+	{
+		if (IsPooled(Count))
+		{
+			Pool->Free(Pointer);
+		}
+		else
+		{
+			::operator delete(Pointer);
+		}
+	}
+
+	PoolAllocator* GetPool() const { return Pool; }
+
+	template<typename U>
+	bool operator==(const PoolStlAllocator<U>& Other) const { return Pool == Other.GetPool(); }
+
+	template<typename U>
+	bool operator!=(const PoolStlAllocator<U>& Other) const { return Pool != Other.GetPool(); }
+
+private:
+	bool IsPooled(size_t Count) const { return Count == 1 && alignof(T) <= alignof(std::max_align_t) && sizeof(T) <= Pool->GetBlockSize(); }
+
+	PoolAllocator* Pool;
+};
@@ -0,0 +1,212 @@
+#include "PostProcess.h"
+
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+	glm::ivec2 GetBloomLevelSize(int Width, int Height, int Level)
+	{
+		return glm::max(glm::ivec2{ Width >> (Level + 1), Height >> (Level + 1) }, glm::ivec2{ 1 });
+	}
+
+	// Amostra só o nível Level da textura, para poder escrever em outro
+	// nível dela ao mesmo tempo
+	void SelectLevel(GLuint TextureId, int Level)
+	{
+		glBindTexture(GL_TEXTURE_2D, TextureId);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, Level);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, Level);
+	}
+}
+
+void PostProcess::Create(int InWidth, int InHeight)
+{
+	// O triângulo que cobre a tela é gerado no vertex shader a partir de gl_VertexID
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenFramebuffers(1, &SceneFramebufferId);
+	glGenFramebuffers(1, &BloomFramebufferId);
+
+	Width = InWidth;
+	Height = InHeight;
+	CreateTargets();
+}
+
+void PostProcess::Release()
+{
+	ReleaseTargets();
+
+	glDeleteFramebuffers(1, &BloomFramebufferId);
+	glDeleteFramebuffers(1, &SceneFramebufferId);
+	glDeleteVertexArrays(1, &VertexArrayId);
+
+	BloomFramebufferId = 0;
+	SceneFramebufferId = 0;
+	VertexArrayId = 0;
+}
+
+void PostProcess::Resize(int InWidth, int InHeight)
+{
+	if (SceneFramebufferId == 0 || (InWidth == Width && InHeight == Height))
+	{
+		return;
+	}
+
+	ReleaseTargets();
+	Width = InWidth;
+	Height = InHeight;
+	CreateTargets();
+}
+
+void PostProcess::CreateTargets()
+{
+	glGenTextures(1, &SceneColorTextureId);
+	glBindTexture(GL_TEXTURE_2D, SceneColorTextureId);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, Width, Height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Mesmo formato da pirâmide de profundidade, que copia deste buffer
+	glGenRenderbuffers(1, &SceneDepthRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, SceneDepthRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, SceneFramebufferId);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, SceneColorTextureId, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, SceneDepthRenderbufferId);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Erro ao criar o framebuffer HDR da cena" << std::endl;
+	}
+
+	// R11G11B10F basta para o bloom e tem metade da banda do RGBA16F
+	NumBloomLevels = 0;
+	while (NumBloomLevels < MaxBloomLevels && glm::all(glm::greaterThan(GetBloomLevelSize(Width, Height, NumBloomLevels), glm::ivec2{ 2 })))
+	{
+		++NumBloomLevels;
+	}
+
+	glGenTextures(1, &BloomTextureId);
+	glBindTexture(GL_TEXTURE_2D, BloomTextureId);
+	for (int Level = 0; Level < NumBloomLevels; ++Level)
+	{
+		const glm::ivec2 LevelSize = GetBloomLevelSize(Width, Height, Level);
+		glTexImage2D(GL_TEXTURE_2D, Level, GL_R11F_G11F_B10F, LevelSize.x, LevelSize.y, 0, GL_RGB, GL_HALF_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PostProcess::ReleaseTargets()
+{
+	glDeleteTextures(1, &BloomTextureId);
+	glDeleteRenderbuffers(1, &SceneDepthRenderbufferId);
+	glDeleteTextures(1, &SceneColorTextureId);
+
+	BloomTextureId = 0;
+	SceneDepthRenderbufferId = 0;
+	SceneColorTextureId = 0;
+	NumBloomLevels = 0;
+}
+
+void PostProcess::BeginScene() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, SceneFramebufferId);
+}
+
+void PostProcess::Resolve(GLuint DownsampleProgram, GLuint UpsampleProgram, GLuint TonemapProgram, GLuint TargetFramebuffer) const
+{
+	if (DownsampleProgram == 0 || UpsampleProgram == 0 || TonemapProgram == 0)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, TargetFramebuffer);
+		return;
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glBindVertexArray(VertexArrayId);
+	glActiveTexture(GL_TEXTURE0);
+
+	// Redução: a cena vai para o nível 0 e cada nível seguinte lê o anterior
+	glBindFramebuffer(GL_FRAMEBUFFER, BloomFramebufferId);
+	glUseProgram(DownsampleProgram);
+	glUniform1i(glGetUniformLocation(DownsampleProgram, "Source"), 0);
+	const GLint DownTexelSizeLoc = glGetUniformLocation(DownsampleProgram, "SourceTexelSize");
+	const GLint FirstPassLoc = glGetUniformLocation(DownsampleProgram, "bFirstPass");
+
+	for (int Level = 0; Level < NumBloomLevels; ++Level)
+	{
+		const glm::ivec2 SourceSize = Level == 0 ? glm::ivec2{ Width, Height } : GetBloomLevelSize(Width, Height, Level - 1);
+		const glm::ivec2 LevelSize = GetBloomLevelSize(Width, Height, Level);
+
+		if (Level == 0)
+		{
+			glBindTexture(GL_TEXTURE_2D, SceneColorTextureId);
+		}
+		else
+		{
+			SelectLevel(BloomTextureId, Level - 1);
+		}
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, BloomTextureId, Level);
+		glViewport(0, 0, LevelSize.x, LevelSize.y);
+		glUniform2f(DownTexelSizeLoc, 1.0f / SourceSize.x, 1.0f / SourceSize.y);
+		glUniform1i(FirstPassLoc, Level == 0);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	// Subida: cada nível é filtrado e somado ao nível maior
+	glUseProgram(UpsampleProgram);
+	glUniform1i(glGetUniformLocation(UpsampleProgram, "Source"), 0);
+	const GLint UpTexelSizeLoc = glGetUniformLocation(UpsampleProgram, "SourceTexelSize");
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	for (int Level = NumBloomLevels - 1; Level > 0; --Level)
+	{
+		const glm::ivec2 SourceSize = GetBloomLevelSize(Width, Height, Level);
+		const glm::ivec2 LevelSize = GetBloomLevelSize(Width, Height, Level - 1);
+
+		SelectLevel(BloomTextureId, Level);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, BloomTextureId, Level - 1);
+		glViewport(0, 0, LevelSize.x, LevelSize.y);
+		glUniform2f(UpTexelSizeLoc, 1.0f / SourceSize.x, 1.0f / SourceSize.y);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	glDisable(GL_BLEND);
+
+	// Tonemapping da cena com o bloom para o destino
+	glBindFramebuffer(GL_FRAMEBUFFER, TargetFramebuffer);
+	glViewport(0, 0, Width, Height);
+
+	glUseProgram(TonemapProgram);
+	glUniform1i(glGetUniformLocation(TonemapProgram, "Scene"), 0);
+	glUniform1i(glGetUniformLocation(TonemapProgram, "Bloom"), 1);
+	glUniform1f(glGetUniformLocation(TonemapProgram, "Exposure"), Exposure);
+	glUniform1f(glGetUniformLocation(TonemapProgram, "BloomStrength"), NumBloomLevels > 0 ? BloomStrength : 0.0f);
+
+	glBindTexture(GL_TEXTURE_2D, SceneColorTextureId);
+	glActiveTexture(GL_TEXTURE1);
+	SelectLevel(BloomTextureId, 0);
+
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Cena desenhada em ponto flutuante (RGBA16F) e resolvida para a janela com
+// bloom e tonemapping. O bloom é uma cadeia de mips em meia resolução: cada
+// nível é reduzido do anterior com um filtro de 13 amostras e depois os
+// níveis são somados de volta, do menor para o maior, com um filtro tenda
+// 3x3. Cada passo lê poucas amostras e o custo cai a cada nível, bem menos
+// que gaussianas separáveis largas.
+class PostProcess
+{
+public:
+	static constexpr int MaxBloomLevels = 6;
+
+	void Create(int Width, int Height);
+	void Release();
+
+	// Recria os alvos se o tamanho mudou
+	void Resize(int Width, int Height);
+
+	// Liga o framebuffer da cena, para onde vão os draws seguintes
+	void BeginScene() const;
+
+	// Gera o bloom e escreve a imagem final em TargetFramebuffer (0 é a janela)
+	void Resolve(GLuint DownsampleProgram, GLuint UpsampleProgram, GLuint TonemapProgram, GLuint TargetFramebuffer = 0) const;
+
+	GLuint GetSceneFramebuffer() const { return SceneFramebufferId; }
+
+	float Exposure = 1.0f;
+	float BloomStrength = 0.04f;
+
+private:
+	void CreateTargets();
+	void ReleaseTargets();
+
+	int Width = 0;
+	int Height = 0;
+	int NumBloomLevels = 0;
+
+	GLuint SceneFramebufferId = 0;
+	GLuint SceneColorTextureId = 0;
+	GLuint SceneDepthRenderbufferId = 0;
+
+	// Uma textura com todos os níveis do bloom, ligados um de cada vez
+	GLuint BloomFramebufferId = 0;
+	GLuint BloomTextureId = 0;
+
+	GLuint VertexArrayId = 0;
+};
@@ -0,0 +1,130 @@
+#include "RingBuffer.h"
+
+#include <iostream>
+
+void PersistentRingBuffer::Create(GLsizeiptr InFrameSize)
+{
+	FrameSize = InFrameSize;
+	FrameIndex = 0;
+	Head = 0;
+	bReportedFull = false;
+
+	const GLsizeiptr TotalSize = FrameSize * FramesInFlight;
+
+	glGenBuffers(1, &BufferId);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, BufferId);
+
+	bPersistent = GLEW_ARB_buffer_storage;
+	if (bPersistent)
+	{
+		const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, TotalSize, nullptr, Flags);
+		PersistentData = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, TotalSize, Flags));
+	}
+	else
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, TotalSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	std::cout << "Ring buffer de " << TotalSize / 1024 << " KB " << (bPersistent ? "(persistente)" : "(mapeado por frame)") << std::endl;
+}
+
+void PersistentRingBuffer::Release()
+{
+	for (GLsync& Fence : Fences)
+	{
+		if (Fence)
+		{
+			glDeleteSync(Fence);
+			Fence = nullptr;
+		}
+	}
+
+	if (bPersistent)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, BufferId);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		PersistentData = nullptr;
+	}
+
+	glDeleteBuffers(1, &BufferId);
+	BufferId = 0;
+}
+
+void PersistentRingBuffer::BeginFrame()
+{
+	FrameIndex = (FrameIndex + 1) % FramesInFlight;
+	Head = 0;
+
+	// Normalmente a fence de três frames atrás já foi sinalizada e isso não espera nada
+	if (GLsync& Fence = Fences[FrameIndex])
+	{
+		GLenum WaitResult = glClientWaitSync(Fence, 0, 0);
+		while (WaitResult != GL_ALREADY_SIGNALED && WaitResult != GL_CONDITION_SATISFIED && WaitResult != GL_WAIT_FAILED)
+		{
+			WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+
+		glDeleteSync(Fence);
+		Fence = nullptr;
+	}
+
+	const GLintptr FrameOffset = FrameIndex * FrameSize;
+
+	if (bPersistent)
+	{
+		FrameData = PersistentData + FrameOffset;
+	}
+	else
+	{
+		// A fence já garantiu que a GPU terminou de ler essa região
+		const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, BufferId);
+		FrameData = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, FrameOffset, FrameSize, Flags));
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+void* PersistentRingBuffer::Allocate(GLsizeiptr Size, GLsizeiptr Alignment, GLintptr& OutOffset)
+{
+
+	// O alinhamento é relativo ao início do buffer, assim o offset também pode
+	// ser usado como índice (Offset / Alignment) de base instance
+	const GLintptr FrameOffset = FrameIndex * FrameSize;
+	GLintptr Offset = FrameOffset + Head;
+	Offset = ((Offset + Alignment - 1) / Alignment) * Alignment;
+
+	if (!FrameData || Offset + Size > FrameOffset + FrameSize)
+	{
+		if (!bReportedFull)
+		{
+			std::cout << "Ring buffer sem espaco para " << Size << " bytes" << std::endl;
+			bReportedFull = true;
+		}
+		return nullptr;
+	}
+
+	Head = Offset + Size - FrameOffset;
+	OutOffset = Offset;
+	return FrameData + (Offset - FrameOffset);
+}
+
+void PersistentRingBuffer::Flush()
+{
+	if (!bPersistent && FrameData)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, BufferId);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	FrameData = nullptr;
+}
+
+void PersistentRingBuffer::EndFrame()
+{
+	Fences[FrameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
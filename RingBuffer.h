@@ -0,0 +1,53 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Buffer dividido em FramesInFlight regiões, uma por frame. A CPU escreve
+// direto na memória mapeada da região do frame atual enquanto a GPU ainda lê
+// as regiões dos frames anteriores, e uma fence por região impede que dados
+// em uso sejam sobrescritos.
+//
+// Com GL_ARB_buffer_storage o buffer fica mapeado o tempo todo
+// (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT). Sem a extensão a região do
+// frame é mapeada com GL_MAP_UNSYNCHRONIZED_BIT em BeginFrame e desmapeada
+// em Flush, o que também evita a sincronização implícita do glBufferSubData.
+class PersistentRingBuffer
+{
+public:
+	static constexpr int FramesInFlight = 3;
+
+	void Create(GLsizeiptr InFrameSize);
+	void Release();
+
+	// Espera a GPU liberar a próxima região e começa a escrever nela
+	void BeginFrame();
+
+	// Reserva Size bytes na região do frame. OutOffset recebe a posição dentro
+	// do buffer, já alinhada a Alignment (que não precisa ser potência de 2).
+	// Retorna nullptr se a região não tem mais espaço ou não está mapeada.
+	void* Allocate(GLsizeiptr Size, GLsizeiptr Alignment, GLintptr& OutOffset);
+
+	// Precisa ser chamado depois das escritas e antes dos draws que leem o buffer
+	void Flush();
+
+	// Marca com uma fence o fim do uso da região pelos comandos do frame
+	void EndFrame();
+
+	GLuint GetBuffer() const { return BufferId; }
+	bool IsPersistent() const { return bPersistent; }
+
+private:
+	GLuint BufferId = 0;
+	GLsizeiptr FrameSize = 0;
+	GLsizeiptr Head = 0;
+	int FrameIndex = 0;
+
+	bool bPersistent = false;
+	unsigned char* PersistentData = nullptr;
+	unsigned char* FrameData = nullptr;
+
+	GLsync Fences[FramesInFlight] = {};
+
+	// A falta de espaço é avisada uma vez, e não a cada frame
+	bool bReportedFull = false;
+};
@@ -0,0 +1,707 @@
+#include "Scene.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include "Shader.h"
+#include "Texture.h"
+
+namespace
+{
+	// Só o necessário para a cena: sem escapes \u e sem distinguir inteiros
+	struct JsonValue
+	{
+		enum EType
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		EType Type = Null;
+
+		// Linha do arquivo onde o valor começa, para as mensagens de erro
+		int Line = 0;
+
+		bool BoolValue = false;
+		double NumberValue = 0.0;
+		std::string StringValue;
+		std::vector<JsonValue> Elements;
+		std::vector<std::pair<std::string, JsonValue>> Members;
+
+		const JsonValue* Find(const char* Key) const
+		{
+			for (const auto& Member : Members)
+			{
+				if (Member.first == Key)
+				{
+					return &Member.second;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(const std::string& Text)
+			: Cursor(Text.c_str())
+			, End(Text.c_str() + Text.size())
+		{
+		}
+
+		bool Parse(JsonValue& Value)
+		{
+			if (!ParseValue(Value))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			return Cursor == End || Fail("texto depois do fim do documento");
+		}
+
+		std::string Error;
+
+	private:
+		const char* Cursor;
+		const char* End;
+		int Line = 1;
+
+		bool Fail(const char* Message)
+		{
+			Error = "linha " + std::to_string(Line) + ": " + Message;
+			return false;
+		}
+
+		void SkipWhitespace()
+		{
+			while (Cursor < End && (*Cursor == ' ' || *Cursor == '\t' || *Cursor == '\r' || *Cursor == '\n'))
+			{
+				Line += *Cursor == '\n';
+				++Cursor;
+			}
+		}
+
+		bool Consume(const char* Literal)
+		{
+			const size_t Length = std::strlen(Literal);
+			if (static_cast<size_t>(End - Cursor) >= Length && std::strncmp(Cursor, Literal, Length) == 0)
+			{
+				Cursor += Length;
+				return true;
+			}
+			return false;
+		}
+
+		bool ParseString(std::string& Value)
+		{
+			++Cursor;
+			Value.clear();
+			while (Cursor < End && *Cursor != '"')
+			{
+				if (*Cursor == '\n')
+				{
+					return Fail("string sem fim");
+				}
+
+				if (*Cursor == '\\' && Cursor + 1 < End)
+				{
+					++Cursor;
+					switch (*Cursor)
+					{
+						case 'n': Value += '\n'; break;
+						case 't': Value += '\t'; break;
+						case '"':
+						case '\\':
+						case '/': Value += *Cursor; break;
+						default: return Fail("escape nao suportado");
+					}
+				}
+				else
+				{
+					Value += *Cursor;
+				}
+				++Cursor;
+			}
+
+			if (Cursor == End)
+			{
+				return Fail("string sem fim");
+			}
+			++Cursor;
+			return true;
+		}
+
+		bool ParseValue(JsonValue& Value)
+		{
+			SkipWhitespace();
+			if (Cursor == End)
+			{
+				return Fail("fim inesperado");
+			}
+			Value.Line = Line;
+
+			if (*Cursor == '{')
+			{
+				Value.Type = JsonValue::Object;
+				++Cursor;
+				SkipWhitespace();
+				if (Cursor < End && *Cursor == '}')
+				{
+					++Cursor;
+					return true;
+				}
+
+				for (;;)
+				{
+					SkipWhitespace();
+					if (Cursor == End || *Cursor != '"')
+					{
+						return Fail("esperava o nome de um campo");
+					}
+
+					std::pair<std::string, JsonValue> Member;
+					if (!ParseString(Member.first))
+					{
+						return false;
+					}
+
+					SkipWhitespace();
+					if (!Consume(":"))
+					{
+						return Fail("esperava ':'");
+					}
+					if (!ParseValue(Member.second))
+					{
+						return false;
+					}
+					Value.Members.push_back(std::move(Member));
+
+					SkipWhitespace();
+					if (Consume("}"))
+					{
+						return true;
+					}
+					if (!Consume(","))
+					{
+						return Fail("esperava ',' ou '}'");
+					}
+				}
+			}
+
+			if (*Cursor == '[')
+			{
+				Value.Type = JsonValue::Array;
+				++Cursor;
+				SkipWhitespace();
+				if (Cursor < End && *Cursor == ']')
+				{
+					++Cursor;
+					return true;
+				}
+
+				for (;;)
+				{
+					Value.Elements.emplace_back();
+					if (!ParseValue(Value.Elements.back()))
+					{
+						return false;
+					}
+
+					SkipWhitespace();
+					if (Consume("]"))
+					{
+						return true;
+					}
+					if (!Consume(","))
+					{
+						return Fail("esperava ',' ou ']'");
+					}
+				}
+			}
+
+			if (*Cursor == '"')
+			{
+				Value.Type = JsonValue::String;
+				return ParseString(Value.StringValue);
+			}
+
+			if (Consume("true") || Consume("false"))
+			{
+				Value.Type = JsonValue::Bool;
+				Value.BoolValue = Cursor[-1] == 'e' && Cursor[-2] == 'u';
+				return true;
+			}
+
+			if (Consume("null"))
+			{
+				Value.Type = JsonValue::Null;
+				return true;
+			}
+
+			char* NumberEnd = nullptr;
+			Value.NumberValue = std::strtod(Cursor, &NumberEnd);
+			if (NumberEnd == Cursor)
+			{
+				return Fail("valor invalido");
+			}
+			Value.Type = JsonValue::Number;
+			Cursor = NumberEnd;
+			return true;
+		}
+	};
+
+	// Leitura dos campos de um objeto. Campos ausentes ficam com o valor
+	// padrão; campos com o tipo errado são erro.
+	class SceneReader
+	{
+	public:
+		std::string Error;
+
+		bool ReadNumber(const JsonValue& Object, const char* Key, float& Value)
+		{
+			const JsonValue* Field = Object.Find(Key);
+			if (!Field)
+			{
+				return true;
+			}
+			if (Field->Type != JsonValue::Number)
+			{
+				return Fail(Object, Key, "deve ser um numero");
+			}
+			Value = static_cast<float>(Field->NumberValue);
+			return true;
+		}
+
+		bool ReadInt(const JsonValue& Object, const char* Key, int& Value)
+		{
+			float Number = static_cast<float>(Value);
+			if (!ReadNumber(Object, Key, Number))
+			{
+				return false;
+			}
+			Value = static_cast<int>(Number);
+			return true;
+		}
+
+		bool ReadString(const JsonValue& Object, const char* Key, std::string& Value)
+		{
+			const JsonValue* Field = Object.Find(Key);
+			if (!Field)
+			{
+				return true;
+			}
+			if (Field->Type != JsonValue::String)
+			{
+				return Fail(Object, Key, "deve ser uma string");
+			}
+			Value = Field->StringValue;
+			return true;
+		}
+
+		bool ReadVec3(const JsonValue& Object, const char* Key, glm::vec3& Value)
+		{
+			const JsonValue* Field = Object.Find(Key);
+			if (!Field)
+			{
+				return true;
+			}
+			if (Field->Type != JsonValue::Array || Field->Elements.size() != 3)
+			{
+				return Fail(Object, Key, "deve ter 3 numeros");
+			}
+			for (int Component = 0; Component < 3; ++Component)
+			{
+				if (Field->Elements[Component].Type != JsonValue::Number)
+				{
+					return Fail(Object, Key, "deve ter 3 numeros");
+				}
+				Value[Component] = static_cast<float>(Field->Elements[Component].NumberValue);
+			}
+			return true;
+		}
+
+		const JsonValue* FindObject(const JsonValue& Object, const char* Key)
+		{
+			const JsonValue* Field = Object.Find(Key);
+			if (Field && Field->Type != JsonValue::Object)
+			{
+				Fail(Object, Key, "deve ser um objeto");
+				return nullptr;
+			}
+			return Field;
+		}
+
+		// O erro aponta a linha do campo, ou a do objeto se o campo não existe
+		bool Fail(const JsonValue& Object, const char* Key, const char* Message)
+		{
+			if (Error.empty())
+			{
+				const JsonValue* Field = Object.Find(Key);
+				Error = "linha " + std::to_string(Field ? Field->Line : Object.Line) + ": campo \"" + Key + "\" " + Message;
+			}
+			return false;
+		}
+
+		// Falha se a imagem não está no pacote de assets nem pode ser lida do disco
+		bool CheckTexture(const JsonValue& Object, const char* Key, const std::string& TextureFile)
+		{
+			return TextureFile.empty() || IsTextureAvailable(TextureFile.c_str()) || Fail(Object, Key, "aponta uma imagem que nao existe ou nao pode ser lida");
+		}
+
+		// Camada da textura, reaproveitando as da cena anterior
+		uint32_t GetTextureLayer(SceneDesc& Scene, const std::string& TextureFile)
+		{
+			auto It = TextureLayers.find(TextureFile);
+			if (It != TextureLayers.end())
+			{
+				bTextureUsed[It->second] = true;
+				return It->second;
+			}
+
+			// Uma camada que nenhum corpo usa mais, ou uma nova no fim
+			uint32_t Layer = 0;
+			while (Layer < bTextureUsed.size() && (bTextureUsed[Layer] || !bFreeLayer[Layer]))
+			{
+				++Layer;
+			}
+			if (Layer == bTextureUsed.size())
+			{
+				Scene.TextureFiles.push_back(TextureFile);
+				bTextureUsed.push_back(true);
+				bFreeLayer.push_back(false);
+			}
+			else
+			{
+				TextureLayers.erase(Scene.TextureFiles[Layer]);
+				Scene.TextureFiles[Layer] = TextureFile;
+				bTextureUsed[Layer] = true;
+				bFreeLayer[Layer] = false;
+			}
+
+			TextureLayers[TextureFile] = Layer;
+			return Layer;
+		}
+
+		// As camadas da cena anterior ficam reservadas para as mesmas texturas
+		// até que todos os corpos tenham sido lidos
+		void BeginTextureLayers(SceneDesc& Scene, const SceneDesc* PreviousScene, const JsonValue& Bodies)
+		{
+			if (!PreviousScene)
+			{
+				return;
+			}
+
+			Scene.TextureFiles = PreviousScene->TextureFiles;
+			bTextureUsed.assign(Scene.TextureFiles.size(), false);
+			bFreeLayer.assign(Scene.TextureFiles.size(), true);
+			for (size_t Layer = 0; Layer < Scene.TextureFiles.size(); ++Layer)
+			{
+				TextureLayers[Scene.TextureFiles[Layer]] = static_cast<uint32_t>(Layer);
+			}
+
+			for (const JsonValue& Body : Bodies.Elements)
+			{
+				for (const char* Key : { "texture", "clouds" })
+				{
+					const JsonValue* Field = Body.Find(Key);
+					if (Field && Field->Type == JsonValue::String)
+					{
+						auto It = TextureLayers.find(Field->StringValue);
+						if (It != TextureLayers.end())
+						{
+							bFreeLayer[It->second] = false;
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		std::unordered_map<std::string, uint32_t> TextureLayers;
+		std::vector<bool> bTextureUsed;
+		std::vector<bool> bFreeLayer;
+	};
+
+	bool ReadAtmosphere(SceneReader& Reader, const JsonValue& Object, AtmosphereParams& Params)
+	{
+		Params = AtmosphereParams{ 1.06f, glm::vec3{ 0.0f }, 0.008f, glm::vec3{ 0.0f }, 0.0012f, 0.8f };
+		return Reader.ReadNumber(Object, "top", Params.TopRadius) && Reader.ReadVec3(Object, "rayleigh", Params.RayleighScattering) &&
+		       Reader.ReadNumber(Object, "rayleighHeight", Params.RayleighScaleHeight) && Reader.ReadVec3(Object, "mie", Params.MieScattering) &&
+		       Reader.ReadNumber(Object, "mieHeight", Params.MieScaleHeight) && Reader.ReadNumber(Object, "mieAnisotropy", Params.MieAnisotropy);
+	}
+
+	bool operator==(const TerrainDesc& A, const TerrainDesc& B)
+	{
+		return A.HeightmapFile == B.HeightmapFile && A.HeightScale == B.HeightScale && A.NoiseSeed == B.NoiseSeed;
+	}
+
+	bool operator==(const AtmosphereParams& A, const AtmosphereParams& B)
+	{
+		return A.TopRadius == B.TopRadius && A.RayleighScattering == B.RayleighScattering && A.RayleighScaleHeight == B.RayleighScaleHeight &&
+		       A.MieScattering == B.MieScattering && A.MieScaleHeight == B.MieScaleHeight && A.MieAnisotropy == B.MieAnisotropy;
+	}
+
+	bool operator==(const RingsDesc& A, const RingsDesc& B)
+	{
+		return A.InnerRadius == B.InnerRadius && A.OuterRadius == B.OuterRadius && A.AxialTilt == B.AxialTilt;
+	}
+
+	// Compara o item opcional (índice -1 quando ausente) de dois corpos
+	template <typename T>
+	bool IsSameOptional(const std::vector<T>& OldDescs, int OldIndex, const std::vector<T>& NewDescs, int NewIndex)
+	{
+		if (OldIndex < 0 || NewIndex < 0)
+		{
+			return OldIndex == NewIndex;
+		}
+		return OldDescs[OldIndex] == NewDescs[NewIndex];
+	}
+}
+
+bool LoadScene(const char* FilePath, SceneDesc& Scene, const SceneDesc* PreviousScene)
+{
+	const std::string Text = ReadFile(FilePath);
+	if (Text.empty())
+	{
+		std::cout << "Erro ao ler a cena " << FilePath << std::endl;
+		return false;
+	}
+
+	JsonValue Root;
+	JsonParser Parser{ Text };
+	if (!Parser.Parse(Root))
+	{
+		std::cout << "Erro na cena " << FilePath << ", " << Parser.Error << std::endl;
+		return false;
+	}
+
+	SceneReader Reader;
+	SceneDesc NewScene;
+
+	const JsonValue* Bodies = Root.Find("bodies");
+	if (Root.Type != JsonValue::Object || !Bodies || Bodies->Type != JsonValue::Array || Bodies->Elements.empty())
+	{
+		std::cout << "Erro na cena " << FilePath << ", \"bodies\" precisa ser uma lista de corpos" << std::endl;
+		return false;
+	}
+
+	Reader.BeginTextureLayers(NewScene, PreviousScene, *Bodies);
+
+	std::unordered_map<std::string, int> BodyIndices;
+	for (const JsonValue& Body : Bodies->Elements)
+	{
+		const int BodyIndex = static_cast<int>(NewScene.GetNumBodies());
+
+		std::string Name;
+		std::string TextureFile;
+		std::string CloudsFile;
+		std::string ParentName;
+		std::string VirtualTextureFile;
+		glm::vec3 OrbitRadius{ 0.0f };
+		float OrbitSpeed = 0.0f;
+		float Scale = 1.0f;
+		bool bValid = Body.Type == JsonValue::Object && Reader.ReadString(Body, "name", Name) && Reader.ReadString(Body, "texture", TextureFile) &&
+		              Reader.ReadString(Body, "clouds", CloudsFile) && Reader.ReadString(Body, "parent", ParentName) &&
+		              Reader.ReadString(Body, "virtualTexture", VirtualTextureFile) && Reader.ReadVec3(Body, "orbit", OrbitRadius) &&
+		              Reader.ReadNumber(Body, "speed", OrbitSpeed) && Reader.ReadNumber(Body, "scale", Scale);
+
+		if (bValid && (Name.empty() || TextureFile.empty()))
+		{
+			bValid = Reader.Fail(Body, Name.empty() ? "name" : "texture", "e obrigatorio");
+		}
+		if (bValid && !(Scale > 0.0f))
+		{
+			// O raio divide a distância do terreno e a NormalMatrix usa 1 / escala²
+			bValid = Reader.Fail(Body, "scale", "deve ser maior que zero");
+		}
+		if (bValid)
+		{
+			bValid = Reader.CheckTexture(Body, "texture", TextureFile) && Reader.CheckTexture(Body, "clouds", CloudsFile);
+		}
+		if (bValid && !BodyIndices.emplace(Name, BodyIndex).second)
+		{
+			bValid = Reader.Fail(Body, "name", "repetido");
+		}
+
+		int Parent = -1;
+		if (bValid && !ParentName.empty())
+		{
+			auto It = BodyIndices.find(ParentName);
+			if (It == BodyIndices.end() || It->second == BodyIndex)
+			{
+				bValid = Reader.Fail(Body, "parent", "precisa ser um corpo declarado antes");
+			}
+			else
+			{
+				Parent = It->second;
+			}
+		}
+
+		uint32_t ShaderFeatures = CloudsFile.empty() ? EShaderFeature::None : EShaderFeature::HasClouds;
+		if (const JsonValue* Features = Body.Find("features"); bValid && Features)
+		{
+			bValid = Features->Type == JsonValue::Array || Reader.Fail(Body, "features", "deve ser uma lista");
+			for (size_t FeatureIndex = 0; bValid && FeatureIndex < Features->Elements.size(); ++FeatureIndex)
+			{
+				const std::string& Feature = Features->Elements[FeatureIndex].StringValue;
+				if (Feature == "emissive")
+				{
+					ShaderFeatures |= EShaderFeature::Emissive;
+				}
+				else if (Feature == "specular")
+				{
+					ShaderFeatures |= EShaderFeature::Specular;
+				}
+				else
+				{
+					bValid = Reader.Fail(Body, "features", "so aceita \"emissive\" e \"specular\"");
+				}
+			}
+		}
+
+		int Terrain = -1;
+		if (const JsonValue* TerrainObject = bValid ? Reader.FindObject(Body, "terrain") : nullptr)
+		{
+			TerrainDesc Desc{ std::string{}, 0.004f, BodyIndex + 1 };
+			bValid = Reader.ReadString(*TerrainObject, "heightmap", Desc.HeightmapFile) && Reader.ReadNumber(*TerrainObject, "height", Desc.HeightScale) &&
+			         Reader.ReadInt(*TerrainObject, "seed", Desc.NoiseSeed);
+
+			// Sem o arquivo o relevo vem do ruído, mas um arquivo que existe e
+			// não é uma imagem é erro de digitação na cena
+			if (bValid && !Desc.HeightmapFile.empty() && std::ifstream{ Desc.HeightmapFile }.good())
+			{
+				bValid = Reader.CheckTexture(*TerrainObject, "heightmap", Desc.HeightmapFile);
+			}
+			Terrain = static_cast<int>(NewScene.TerrainDescs.size());
+			NewScene.TerrainDescs.push_back(Desc);
+		}
+
+		int AtmosphereIndex = -1;
+		if (const JsonValue* AtmosphereObject = bValid ? Reader.FindObject(Body, "atmosphere") : nullptr)
+		{
+			AtmosphereParams Params;
+			bValid = ReadAtmosphere(Reader, *AtmosphereObject, Params);
+			AtmosphereIndex = static_cast<int>(NewScene.AtmosphereDescs.size());
+			NewScene.AtmosphereDescs.push_back(Params);
+		}
+
+		int RingsIndex = -1;
+		if (const JsonValue* RingsObject = bValid ? Reader.FindObject(Body, "rings") : nullptr)
+		{
+			RingsDesc Desc{ 1.2f, 2.2f, 0.0f };
+			bValid = Reader.ReadNumber(*RingsObject, "inner", Desc.InnerRadius) && Reader.ReadNumber(*RingsObject, "outer", Desc.OuterRadius) &&
+			         Reader.ReadNumber(*RingsObject, "tilt", Desc.AxialTilt);
+			Desc.AxialTilt = glm::radians(Desc.AxialTilt);
+			RingsIndex = static_cast<int>(NewScene.RingDescs.size());
+			NewScene.RingDescs.push_back(Desc);
+		}
+
+		if (!bValid || !Reader.Error.empty())
+		{
+			std::cout << "Erro na cena " << FilePath << ", corpo " << BodyIndex << (Name.empty() ? "" : " (" + Name + ")") << ": " << Reader.Error << std::endl;
+			return false;
+		}
+
+		NewScene.Names.push_back(Name);
+		NewScene.Parents.push_back(Parent);
+		NewScene.TextureLayers.push_back(Reader.GetTextureLayer(NewScene, TextureFile));
+		NewScene.CloudsTextureLayers.push_back(CloudsFile.empty() ? 0 : Reader.GetTextureLayer(NewScene, CloudsFile));
+		NewScene.OrbitRadii.push_back(OrbitRadius);
+		NewScene.OrbitSpeeds.push_back(OrbitSpeed);
+		NewScene.Scales.push_back(Scale);
+		NewScene.ShaderFeatures.push_back(ShaderFeatures);
+		NewScene.VirtualTextureFiles.push_back(VirtualTextureFile);
+		NewScene.Terrains.push_back(Terrain);
+		NewScene.Atmospheres.push_back(AtmosphereIndex);
+		NewScene.Rings.push_back(RingsIndex);
+	}
+
+	std::string LightName;
+	if (const JsonValue* Light = Reader.FindObject(Root, "light"))
+	{
+		Reader.ReadString(*Light, "body", LightName);
+		Reader.ReadNumber(*Light, "intensity", NewScene.LightIntensity);
+	}
+
+	auto LightIt = BodyIndices.find(LightName);
+	if (!Reader.Error.empty() || LightIt == BodyIndices.end())
+	{
+		std::cout << "Erro na cena " << FilePath << ", \"light\" precisa ter o nome de um corpo em \"body\"" << std::endl;
+		return false;
+	}
+	NewScene.LightBody = LightIt->second;
+
+	std::cout << "Cena " << FilePath << " com " << NewScene.GetNumBodies() << " corpos e " << NewScene.TextureFiles.size() << " texturas" << std::endl;
+	Scene = std::move(NewScene);
+	return true;
+}
+
+std::vector<SceneBodyChange> DiffScenes(const SceneDesc& OldScene, const SceneDesc& NewScene)
+{
+	std::unordered_map<std::string, int> OldIndices;
+	for (size_t BodyIndex = 0; BodyIndex < OldScene.GetNumBodies(); ++BodyIndex)
+	{
+		OldIndices.emplace(OldScene.Names[BodyIndex], static_cast<int>(BodyIndex));
+	}
+
+	std::vector<SceneBodyChange> Changes(NewScene.GetNumBodies());
+	for (size_t BodyIndex = 0; BodyIndex < NewScene.GetNumBodies(); ++BodyIndex)
+	{
+		auto It = OldIndices.find(NewScene.Names[BodyIndex]);
+		if (It == OldIndices.end())
+		{
+			Changes[BodyIndex] = { -1, ESceneChange::All };
+			continue;
+		}
+
+		const size_t Old = It->second;
+		const size_t New = BodyIndex;
+		uint32_t BodyChanges = ESceneChange::None;
+
+		// O pai é comparado pelo nome, já que os índices podem ter mudado
+		const std::string OldParent = OldScene.Parents[Old] >= 0 ? OldScene.Names[OldScene.Parents[Old]] : std::string{};
+		const std::string NewParent = NewScene.Parents[New] >= 0 ? NewScene.Names[NewScene.Parents[New]] : std::string{};
+		if (OldParent != NewParent || OldScene.OrbitRadii[Old] != NewScene.OrbitRadii[New] || OldScene.OrbitSpeeds[Old] != NewScene.OrbitSpeeds[New] ||
+		    OldScene.Scales[Old] != NewScene.Scales[New])
+		{
+			BodyChanges |= ESceneChange::Orbit;
+		}
+
+		if (OldScene.TextureFiles[OldScene.TextureLayers[Old]] != NewScene.TextureFiles[NewScene.TextureLayers[New]] ||
+		    OldScene.TextureFiles[OldScene.CloudsTextureLayers[Old]] != NewScene.TextureFiles[NewScene.CloudsTextureLayers[New]] ||
+		    OldScene.ShaderFeatures[Old] != NewScene.ShaderFeatures[New])
+		{
+			BodyChanges |= ESceneChange::Appearance;
+		}
+
+		if (OldScene.VirtualTextureFiles[Old] != NewScene.VirtualTextureFiles[New])
+		{
+			BodyChanges |= ESceneChange::VirtualTexture;
+		}
+		if (!IsSameOptional(OldScene.TerrainDescs, OldScene.Terrains[Old], NewScene.TerrainDescs, NewScene.Terrains[New]))
+		{
+			BodyChanges |= ESceneChange::Terrain;
+		}
+		if (!IsSameOptional(OldScene.AtmosphereDescs, OldScene.Atmospheres[Old], NewScene.AtmosphereDescs, NewScene.Atmospheres[New]))
+		{
+			BodyChanges |= ESceneChange::Atmosphere;
+		}
+		if (!IsSameOptional(OldScene.RingDescs, OldScene.Rings[Old], NewScene.RingDescs, NewScene.Rings[New]))
+		{
+			BodyChanges |= ESceneChange::Rings;
+		}
+
+		Changes[BodyIndex] = { static_cast<int>(Old), BodyChanges };
+	}
+	return Changes;
+}
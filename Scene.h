@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Atmosphere.h"
+#include "PlanetTerrain.h"
+
+// Anéis de um corpo, com os raios em unidades do raio do planeta
+struct RingsDesc
+{
+	float InnerRadius;
+	float OuterRadius;
+
+	// Inclinação do eixo do planeta, em radianos
+	float AxialTilt;
+};
+
+// Cena lida de um arquivo JSON (scenes/sistema_solar.json). Cada corpo é um
+// índice: todos os vetores por corpo têm o mesmo tamanho e são percorridos
+// juntos pelo loop de renderização, sem structs intermediárias.
+struct SceneDesc
+{
+	// Texturas da texture array, uma por camada. Camadas de texturas que
+	// deixaram de ser usadas continuam aqui até serem reaproveitadas.
+	std::vector<std::string> TextureFiles;
+
+	// Dados por corpo
+	std::vector<std::string> Names;
+
+	// Corpo em volta do qual a órbita é descrita, sempre declarado antes, ou -1
+	std::vector<int> Parents;
+
+	std::vector<uint32_t> TextureLayers;
+	std::vector<uint32_t> CloudsTextureLayers;
+
+	// Raio da órbita em X e Z, e altura em Y
+	std::vector<glm::vec3> OrbitRadii;
+	std::vector<float> OrbitSpeeds;
+	std::vector<float> Scales;
+
+	// Combinação de EShaderFeature, sem EShaderFeature::VirtualTexture, que
+	// depende de o pacote da textura virtual existir
+	std::vector<uint32_t> ShaderFeatures;
+
+	// Pacote gerado pelo BuildVirtualTexture, ou vazio
+	std::vector<std::string> VirtualTextureFiles;
+
+	// Índices em TerrainDescs, AtmosphereDescs e RingDescs, ou -1
+	std::vector<int> Terrains;
+	std::vector<int> Atmospheres;
+	std::vector<int> Rings;
+
+	std::vector<TerrainDesc> TerrainDescs;
+	std::vector<AtmosphereParams> AtmosphereDescs;
+	std::vector<RingsDesc> RingDescs;
+
+	// A luz pontual fica no centro desse corpo
+	size_t LightBody = 0;
+	float LightIntensity = 1.0f;
+
+	size_t GetNumBodies() const { return Names.size(); }
+};
+
+// O que mudou num corpo entre duas versões da cena
+namespace ESceneChange
+{
+	enum Type : uint32_t
+	{
+		None           = 0,
+
+		// Órbita, pai e escala: só afetam as matrizes calculadas a cada frame
+		Orbit          = 1 << 0,
+
+		// Camadas da textura e features do shader
+		Appearance     = 1 << 1,
+		VirtualTexture = 1 << 2,
+		Terrain        = 1 << 3,
+		Atmosphere     = 1 << 4,
+		Rings          = 1 << 5,
+
+		All            = ~0u
+	};
+}
+
+struct SceneBodyChange
+{
+	// Corpo com o mesmo nome na versão anterior, ou -1 se o corpo é novo
+	int PreviousIndex;
+
+	// Combinação de ESceneChange
+	uint32_t Changes;
+};
+
+// Lê e valida a cena. Com PreviousScene as texturas que continuam na cena
+// mantêm suas camadas, assim só as camadas novas precisam ser enviadas.
+// Em caso de erro Scene não é alterada.
+bool LoadScene(const char* FilePath, SceneDesc& Scene, const SceneDesc* PreviousScene = nullptr);
+
+// Compara os corpos de NewScene com os de mesmo nome em OldScene
+std::vector<SceneBodyChange> DiffScenes(const SceneDesc& OldScene, const SceneDesc& NewScene);
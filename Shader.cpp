@@ -0,0 +1,383 @@
+#include "Shader.h"
+
+#include "AssetPack.h"
+
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+std::string ReadFile(const char* FilePath)
+{
+	std::string FileContents;
+	if (std::ifstream FileStream{ FilePath, std::ios::in })
+	{
+		FileContents.assign((std::istreambuf_iterator<char>(FileStream)), std::istreambuf_iterator<char>());
+	}
+	return FileContents;
+}
+
+// Shaders empacotados são usados sem abrir o arquivo. Depois de um hot
+// reload o arquivo em disco é a versão mais nova e o pacote é ignorado.
+std::string ReadShaderSource(const char* FilePath, bool bFromDisk)
+{
+	if (const AssetEntry* Entry = bFromDisk ? nullptr : AssetPack::Get().Find(FilePath))
+	{
+		const char* Data = reinterpret_cast<const char*>(AssetPack::Get().GetData(*Entry));
+		return std::string(Data, Data + Entry->Size);
+	}
+	return ReadFile(FilePath);
+}
+
+bool CheckShader(GLuint ShaderId)
+{
+	// Verificar se o shader foi compilado
+	GLint Result = GL_TRUE;
+	glGetShaderiv(ShaderId, GL_COMPILE_STATUS, &Result);
+
+	if (Result == GL_FALSE)
+	{
+		// Erro ao compilar o shader, imprimir o log para saber o que est� errado
+		GLint InfoLogLength = 0;
+		glGetShaderiv(ShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+
+		std::cout << "Erro ao compilar o shader: " << std::endl;
+
+		if (InfoLogLength > 0)
+		{
+			std::string ShaderInfoLog(InfoLogLength, '\0');
+			glGetShaderInfoLog(ShaderId, InfoLogLength, nullptr, &ShaderInfoLog[0]);
+
+			std::cout << ShaderInfoLog << std::endl;
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+void PrintProgramInfoLog(GLuint ProgramId)
+{
+	GLint InfoLogLength = 0;
+	glGetProgramiv(ProgramId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+
+	std::cout << "Erro ao linkar programa" << std::endl;
+
+	if (InfoLogLength > 0)
+	{
+		std::string ProgramInfoLog(InfoLogLength, '\0');
+		glGetProgramInfoLog(ProgramId, InfoLogLength, nullptr, &ProgramInfoLog[0]);
+
+		std::cout << ProgramInfoLog << std::endl;
+	}
+}
+
+std::string MakeShaderDefines(uint32_t Features)
+{
+	static const std::pair<uint32_t, const char*> FeatureDefines[] =
+	{
+		{ EShaderFeature::HasClouds, "HAS_CLOUDS" },
+		{ EShaderFeature::Emissive, "EMISSIVE" },
+		{ EShaderFeature::Specular, "SPECULAR" },
+		{ EShaderFeature::PredictedOrbit, "PREDICTED_ORBIT" },
+		{ EShaderFeature::VirtualTexture, "VIRTUAL_TEXTURE" },
+		{ EShaderFeature::Terrain, "TERRAIN" },
+	};
+
+	std::string Defines;
+	for (const auto& FeatureDefine : FeatureDefines)
+	{
+		if (Features & FeatureDefine.first)
+		{
+			Defines += "#define ";
+			Defines += FeatureDefine.second;
+			Defines += "\n";
+		}
+	}
+	return Defines;
+}
+
+void BindUniformBlocks(GLuint ProgramId)
+{
+	static const std::pair<const char*, GLuint> UniformBlocks[] =
+	{
+		{ "FrameBlock", EUniformBlock::Frame },
+	};
+
+	for (const auto& UniformBlock : UniformBlocks)
+	{
+		GLuint BlockIndex = glGetUniformBlockIndex(ProgramId, UniformBlock.first);
+		if (BlockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(ProgramId, BlockIndex, UniformBlock.second);
+		}
+	}
+}
+
+void SetShaderSource(GLuint ShaderId, const std::string& Source, const std::string& Defines)
+{
+	// A diretiva #version precisa ser a primeira linha do shader, então os
+	// #defines entram logo depois dela. O #line faz com que os erros de
+	// compilação continuem apontando para as linhas do arquivo original.
+	std::string::size_type VersionEnd = 0;
+	if (Source.compare(0, 8, "#version") == 0)
+	{
+		VersionEnd = Source.find('\n');
+		VersionEnd = (VersionEnd == std::string::npos) ? Source.size() : VersionEnd + 1;
+	}
+
+	const std::string LineDirective = (VersionEnd > 0) ? "#line 2\n" : "#line 1\n";
+
+	const char* Sources[] =
+	{
+		Source.c_str(),
+		Defines.c_str(),
+		LineDirective.c_str(),
+		Source.c_str() + VersionEnd
+	};
+
+	const GLint Lengths[] =
+	{
+		static_cast<GLint>(VersionEnd),
+		static_cast<GLint>(Defines.size()),
+		static_cast<GLint>(LineDirective.size()),
+		static_cast<GLint>(Source.size() - VersionEnd)
+	};
+
+	glShaderSource(ShaderId, 4, Sources, Lengths);
+}
+
+PendingProgram BeginLoadShaders(const std::string& VertexShaderSource, const std::string& FragmentShaderSource, const std::string& Defines)
+{
+	PendingProgram Program;
+
+	// Criar os identificadores de cada um dos shaders
+	Program.VertShaderId = glCreateShader(GL_VERTEX_SHADER);
+	Program.FragShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+
+	SetShaderSource(Program.VertShaderId, VertexShaderSource, Defines);
+	glCompileShader(Program.VertShaderId);
+
+	SetShaderSource(Program.FragShaderId, FragmentShaderSource, Defines);
+	glCompileShader(Program.FragShaderId);
+
+	// O status da compilação só é consultado em FinishLoadShaders, assim o
+	// driver pode compilar e linkar em paralelo sem travar quem chamou
+	Program.ProgramId = glCreateProgram();
+	glAttachShader(Program.ProgramId, Program.VertShaderId);
+	glAttachShader(Program.ProgramId, Program.FragShaderId);
+	glLinkProgram(Program.ProgramId);
+
+	return Program;
+}
+
+bool IsProgramReady(const PendingProgram& Program)
+{
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		GLint Completed = GL_FALSE;
+		glGetProgramiv(Program.ProgramId, GL_COMPLETION_STATUS_KHR, &Completed);
+		return Completed == GL_TRUE;
+	}
+
+	// Sem a extensão não há como saber sem bloquear
+	return true;
+}
+
+GLuint FinishLoadShaders(PendingProgram& Program)
+{
+	bool bCompiled = CheckShader(Program.VertShaderId);
+	bCompiled = CheckShader(Program.FragShaderId) && bCompiled;
+
+	// Verificar o programa
+	GLint Result = GL_TRUE;
+	glGetProgramiv(Program.ProgramId, GL_LINK_STATUS, &Result);
+
+	if (bCompiled && Result == GL_FALSE)
+	{
+		PrintProgramInfoLog(Program.ProgramId);
+	}
+
+	glDetachShader(Program.ProgramId, Program.VertShaderId);
+	glDetachShader(Program.ProgramId, Program.FragShaderId);
+
+	glDeleteShader(Program.VertShaderId);
+	glDeleteShader(Program.FragShaderId);
+
+	GLuint ProgramId = Program.ProgramId;
+	if (!bCompiled || Result == GL_FALSE)
+	{
+		glDeleteProgram(ProgramId);
+		ProgramId = 0;
+	}
+	else
+	{
+		BindUniformBlocks(ProgramId);
+	}
+
+	Program = PendingProgram{};
+	return ProgramId;
+}
+
+void CancelLoadShaders(PendingProgram& Program)
+{
+	glDeleteShader(Program.VertShaderId);
+	glDeleteShader(Program.FragShaderId);
+	glDeleteProgram(Program.ProgramId);
+
+	Program = PendingProgram{};
+}
+
+GLuint LoadShaders(const char* VertexShaderFile, const char* FragmentShaderFile, const std::string& Defines, bool bFromDisk)
+{
+	std::string VertexShaderSource = ReadShaderSource(VertexShaderFile, bFromDisk);
+	std::string FragmentShaderSource = ReadShaderSource(FragmentShaderFile, bFromDisk);
+
+	if (VertexShaderSource.empty() || FragmentShaderSource.empty())
+	{
+		std::cout << "Erro ao ler " << VertexShaderFile << " ou " << FragmentShaderFile << std::endl;
+		return 0;
+	}
+
+	std::cout << "Compilando " << VertexShaderFile << " e " << FragmentShaderFile << std::endl;
+	PendingProgram Program = BeginLoadShaders(VertexShaderSource, FragmentShaderSource, Defines);
+	return FinishLoadShaders(Program);
+}
+
+GLuint LoadComputeShader(const char* ComputeShaderFile, const std::string& Defines)
+{
+	std::string ComputeShaderSource = ReadShaderSource(ComputeShaderFile, false);
+
+	if (ComputeShaderSource.empty())
+	{
+		std::cout << "Erro ao ler " << ComputeShaderFile << std::endl;
+		return 0;
+	}
+
+	std::cout << "Compilando " << ComputeShaderFile << std::endl;
+	GLuint ComputeShaderId = glCreateShader(GL_COMPUTE_SHADER);
+	SetShaderSource(ComputeShaderId, ComputeShaderSource, Defines);
+	glCompileShader(ComputeShaderId);
+
+	GLuint ProgramId = 0;
+	if (CheckShader(ComputeShaderId))
+	{
+		ProgramId = glCreateProgram();
+		glAttachShader(ProgramId, ComputeShaderId);
+		glLinkProgram(ProgramId);
+
+		GLint Result = GL_TRUE;
+		glGetProgramiv(ProgramId, GL_LINK_STATUS, &Result);
+		if (Result == GL_FALSE)
+		{
+			PrintProgramInfoLog(ProgramId);
+			glDeleteProgram(ProgramId);
+			ProgramId = 0;
+		}
+		else
+		{
+			glDetachShader(ProgramId, ComputeShaderId);
+			BindUniformBlocks(ProgramId);
+		}
+	}
+
+	glDeleteShader(ComputeShaderId);
+	return ProgramId;
+}
+
+ShaderPermutations::ShaderPermutations(const char* InVertexShaderFile, const char* InFragmentShaderFile)
+	: VertexShaderFile(InVertexShaderFile)
+	, FragmentShaderFile(InFragmentShaderFile)
+{
+}
+
+GLuint ShaderPermutations::Get(uint32_t Features)
+{
+	auto It = Programs.find(Features);
+	if (It != Programs.end())
+	{
+		return It->second;
+	}
+
+	std::string Defines = MakeShaderDefines(Features);
+	std::cout << "Variante do shader:" << std::endl << Defines;
+
+	// Mesmo que a compilação falhe a variante fica registrada (com o programa
+	// 0) para que ela seja refeita quando o arquivo for corrigido
+	GLuint ProgramId = LoadShaders(VertexShaderFile.c_str(), FragmentShaderFile.c_str(), Defines, bReloaded);
+	Programs.emplace(Features, ProgramId);
+	return ProgramId;
+}
+
+bool ShaderPermutations::UsesFile(const std::string& FilePath) const
+{
+	return FilePath == VertexShaderFile || FilePath == FragmentShaderFile;
+}
+
+void ShaderPermutations::Reload()
+{
+	std::string VertexShaderSource = ReadFile(VertexShaderFile.c_str());
+	std::string FragmentShaderSource = ReadFile(FragmentShaderFile.c_str());
+
+	// Alguns editores truncam o arquivo antes de escrever o conteúdo novo
+	if (VertexShaderSource.empty() || FragmentShaderSource.empty())
+	{
+		return;
+	}
+
+	std::cout << "Recarregando " << VertexShaderFile << " e " << FragmentShaderFile << std::endl;
+	bReloaded = true;
+
+	for (auto& Pending : PendingPrograms)
+	{
+		CancelLoadShaders(Pending.second);
+	}
+	PendingPrograms.clear();
+
+	for (const auto& Program : Programs)
+	{
+		PendingPrograms.emplace(Program.first, BeginLoadShaders(VertexShaderSource, FragmentShaderSource, MakeShaderDefines(Program.first)));
+	}
+}
+
+void ShaderPermutations::Update()
+{
+	for (auto It = PendingPrograms.begin(); It != PendingPrograms.end();)
+	{
+		if (!IsProgramReady(It->second))
+		{
+			++It;
+			continue;
+		}
+
+		// O programa novo só substitui o antigo se compilou e linkou
+		GLuint NewProgramId = FinishLoadShaders(It->second);
+		if (NewProgramId != 0)
+		{
+			GLuint& ProgramId = Programs[It->first];
+			glDeleteProgram(ProgramId);
+			ProgramId = NewProgramId;
+		}
+		else
+		{
+			std::cout << "Mantendo a versao anterior do shader" << std::endl;
+		}
+
+		It = PendingPrograms.erase(It);
+	}
+}
+
+void ShaderPermutations::Release()
+{
+	for (auto& Pending : PendingPrograms)
+	{
+		CancelLoadShaders(Pending.second);
+	}
+	PendingPrograms.clear();
+
+	for (const auto& Program : Programs)
+	{
+		glDeleteProgram(Program.second);
+	}
+	Programs.clear();
+}
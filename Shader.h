@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+// Features opcionais do shader. Cada bit vira um #define injetado no código
+// fonte antes da compilação, gerando uma variante (permutação) do programa.
+namespace EShaderFeature
+{
+	enum Type : uint32_t
+	{
+		None           = 0,
+		HasClouds      = 1 << 0,
+		Emissive       = 1 << 1,
+		Specular       = 1 << 2,
+
+		// Órbita prevista gerada no vertex shader em vez do rastro gravado
+		PredictedOrbit = 1 << 3,
+
+		// Superfície amostrada da textura virtual quando o tile está no atlas
+		VirtualTexture = 1 << 4,
+
+		// Patches do PlanetTerrain, que giram com o planeta em vez de deslocar a textura
+		Terrain        = 1 << 5,
+	};
+}
+
+// Pontos de ligação fixos dos uniform blocks compartilhados entre os
+// programas. Todo programa linkado tem seus blocks ligados automaticamente.
+namespace EUniformBlock
+{
+	enum Type : GLuint
+	{
+		Frame = 0,
+	};
+}
+
+// Programa que foi enviado para compilação e ainda não teve o resultado
+// verificado. Com GL_KHR_parallel_shader_compile o driver compila em outras
+// threads e IsProgramReady consulta o andamento sem bloquear.
+struct PendingProgram
+{
+	GLuint ProgramId = 0;
+	GLuint VertShaderId = 0;
+	GLuint FragShaderId = 0;
+};
+
+std::string ReadFile(const char* FilePath);
+
+// Lê do AssetPack quando o arquivo está no pacote, a não ser que bFromDisk
+std::string ReadShaderSource(const char* FilePath, bool bFromDisk);
+
+std::string MakeShaderDefines(uint32_t Features);
+
+void BindUniformBlocks(GLuint ProgramId);
+
+PendingProgram BeginLoadShaders(const std::string& VertexShaderSource, const std::string& FragmentShaderSource, const std::string& Defines);
+bool IsProgramReady(const PendingProgram& Program);
+GLuint FinishLoadShaders(PendingProgram& Program);
+void CancelLoadShaders(PendingProgram& Program);
+
+// Retorna 0 se algum dos shaders não compilar ou o programa não linkar
+GLuint LoadShaders(const char* VertexShaderFile, const char* FragmentShaderFile, const std::string& Defines = std::string{}, bool bFromDisk = false);
+GLuint LoadComputeShader(const char* ComputeShaderFile, const std::string& Defines = std::string{});
+
+class ShaderPermutations
+{
+public:
+	ShaderPermutations(const char* VertexShaderFile, const char* FragmentShaderFile);
+
+	GLuint Get(uint32_t Features);
+	void Release();
+
+	// Recompila todas as variantes já usadas. As novas versões só entram no
+	// lugar das antigas em Update, depois que o link terminar com sucesso.
+	bool UsesFile(const std::string& FilePath) const;
+	void Reload();
+	void Update();
+
+private:
+	std::string VertexShaderFile;
+	std::string FragmentShaderFile;
+	std::unordered_map<uint32_t, GLuint> Programs;
+	std::unordered_map<uint32_t, PendingProgram> PendingPrograms;
+
+	// Variantes novas usam o arquivo em disco depois do primeiro Reload
+	bool bReloaded = false;
+};
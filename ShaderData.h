@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Structs com o mesmo layout dos dados que os shaders leem dos buffers
+
+// Dados de um corpo lidos pelo vertex shader como atributos por instância
+struct InstanceData
+{
+	glm::mat4 ModelViewMatrix;
+	glm::mat4 ModelViewProjection;
+	glm::vec4 NormalMatrix[3];
+
+	// x: camada da textura da superfície, y: camada da textura das nuvens
+	glm::vec4 TextureLayers;
+};
+
+// O compute shader de culling também lê InstanceData com layout std430
+static_assert(sizeof(InstanceData) == 192, "InstanceData precisa seguir o layout std430");
+
+// Igual a MAX_OCCLUDERS nos shaders
+constexpr int MaxShadowOccluders = 16;
+
+// Mesmo layout (std140) do FrameBlock dos shaders
+struct FrameUniforms
+{
+	glm::mat4 ViewMatrix;
+	glm::mat4 ViewProjectionMatrix;
+
+	// Posição do Sol no espaço da câmera e raio dele, para a penumbra
+	glm::vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	GLint NumOccluders;
+
+	// Brilho das superfícies emissivas (o Sol), acima de 1 quando a cena é HDR
+	float EmissiveIntensity;
+
+	// Esferas que podem fazer sombra (eclipses): xyz é o centro no espaço da
+	// câmera e w o raio
+	glm::vec4 Occluders[MaxShadowOccluders];
+};
+
+static_assert(sizeof(FrameUniforms) == 416, "FrameUniforms precisa seguir o layout std140");
+
+// Entrada do compute shader de culling (std430), uma por corpo
+struct CullInput
+{
+	// xyz: centro no espaço do mundo, w: raio
+	glm::vec4 BoundingSphere;
+
+	// Primeiro DrawElementsIndirectCommand da variante do corpo. O nível de
+	// detalhe escolhido é somado a ele.
+	GLuint FirstCommand;
+	GLuint Padding[3];
+};
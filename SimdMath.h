@@ -0,0 +1,384 @@
+#pragma once
+
+#include <cmath>
+
+// Caminho escrito à mão para as contas que o loop de renderização faz por
+// corpo. As matrizes são float[16] em colunas, o mesmo layout da glm::mat4,
+// então os ponteiros podem vir de glm::value_ptr ou de &Matrix[0][0]. Nada
+// precisa estar alinhado. Com AVX o produto de matrizes faz duas colunas por
+// instrução e com FMA as somas usam multiply-add; fora do x86 as mesmas
+// funções existem em C++ puro.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_MATH_SSE 1
+#include <immintrin.h>
+#else
+#define SIMD_MATH_SSE 0
+#endif
+
+#if SIMD_MATH_SSE && defined(__AVX__)
+#define SIMD_MATH_AVX 1
+#else
+#define SIMD_MATH_AVX 0
+#endif
+
+// Nome do caminho compilado, para os benchmarks
+inline const char* GetSimdMathPath()
+{
+#if SIMD_MATH_AVX && defined(__FMA__)
+	return "AVX+FMA";
+#elif SIMD_MATH_AVX
+	return "AVX";
+#elif SIMD_MATH_SSE
+	return "SSE";
+#else
+	return "C++";
+#endif
+}
+
+#if SIMD_MATH_SSE
+namespace SimdMathDetail
+{
+	inline __m128 MultiplyAdd(__m128 A, __m128 B, __m128 C)
+	{
+#if defined(__FMA__)
+		return _mm_fmadd_ps(A, B, C);
+#else
+		return _mm_add_ps(_mm_mul_ps(A, B), C);
+#endif
+	}
+
+	template<int Lane>
+	inline __m128 Splat(__m128 V)
+	{
+		return _mm_shuffle_ps(V, V, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+	}
+
+	// Só xyz, com w zerado
+	inline __m128 LoadVector3(const float* V)
+	{
+		return _mm_setr_ps(V[0], V[1], V[2], 0.0f);
+	}
+
+	// O w do resultado é zero quando os w de A e B são finitos
+	inline __m128 Cross(__m128 A, __m128 B)
+	{
+		const __m128 AYZX = _mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 BYZX = _mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 C = _mm_sub_ps(_mm_mul_ps(A, BYZX), _mm_mul_ps(AYZX, B));
+		return _mm_shuffle_ps(C, C, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	// Produto escalar repetido nas quatro posições
+	inline __m128 Dot(__m128 A, __m128 B)
+	{
+		__m128 Product = _mm_mul_ps(A, B);
+		Product = _mm_add_ps(Product, _mm_shuffle_ps(Product, Product, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_add_ps(Product, _mm_shuffle_ps(Product, Product, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+
+	inline __m128 Normalize(__m128 V)
+	{
+		return _mm_div_ps(V, _mm_sqrt_ps(Dot(V, V)));
+	}
+
+	inline __m128 TransformColumn(__m128 A0, __m128 A1, __m128 A2, __m128 A3, __m128 Column)
+	{
+		__m128 Result = _mm_mul_ps(A0, Splat<0>(Column));
+		Result = MultiplyAdd(A1, Splat<1>(Column), Result);
+		Result = MultiplyAdd(A2, Splat<2>(Column), Result);
+		return MultiplyAdd(A3, Splat<3>(Column), Result);
+	}
+
+	// Grava só xyz, para não passar do fim de um glm::vec3
+	inline void StoreVector3(float* Out, __m128 V)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(Out), V);
+		_mm_store_ss(Out + 2, _mm_movehl_ps(V, V));
+	}
+}
+#endif
+
+// Out = A * B. Out pode ser A ou B.
+inline void MultiplyMatrices(const float* A, const float* B, float* Out)
+{
+#if SIMD_MATH_AVX
+	const __m256 A0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A));
+	const __m256 A1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 4));
+	const __m256 A2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 8));
+	const __m256 A3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 12));
+	for (int Column = 0; Column < 4; Column += 2)
+	{
+		const __m256 B01 = _mm256_loadu_ps(B + Column * 4);
+		__m256 Result = _mm256_mul_ps(A0, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(0, 0, 0, 0)));
+#if defined(__FMA__)
+		Result = _mm256_fmadd_ps(A1, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(1, 1, 1, 1)), Result);
+		Result = _mm256_fmadd_ps(A2, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(2, 2, 2, 2)), Result);
+		Result = _mm256_fmadd_ps(A3, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(3, 3, 3, 3)), Result);
+#else
+		Result = _mm256_add_ps(Result, _mm256_mul_ps(A1, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(1, 1, 1, 1))));
+		Result = _mm256_add_ps(Result, _mm256_mul_ps(A2, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(2, 2, 2, 2))));
+		Result = _mm256_add_ps(Result, _mm256_mul_ps(A3, _mm256_shuffle_ps(B01, B01, _MM_SHUFFLE(3, 3, 3, 3))));
+#endif
+		_mm256_storeu_ps(Out + Column * 4, Result);
+	}
+#elif SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	const __m128 A0 = _mm_loadu_ps(A);
+	const __m128 A1 = _mm_loadu_ps(A + 4);
+	const __m128 A2 = _mm_loadu_ps(A + 8);
+	const __m128 A3 = _mm_loadu_ps(A + 12);
+	for (int Column = 0; Column < 4; ++Column)
+	{
+		_mm_storeu_ps(Out + Column * 4, TransformColumn(A0, A1, A2, A3, _mm_loadu_ps(B + Column * 4)));
+	}
+#else
+	float Result[16];
+	for (int Column = 0; Column < 4; ++Column)
+	{
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			Result[Column * 4 + Row] = A[Row] * B[Column * 4] + A[4 + Row] * B[Column * 4 + 1] + A[8 + Row] * B[Column * 4 + 2] + A[12 + Row] * B[Column * 4 + 3];
+		}
+	}
+	for (int Index = 0; Index < 16; ++Index)
+	{
+		Out[Index] = Result[Index];
+	}
+#endif
+}
+
+// Out = M * V, com V de 4 componentes. Out pode ser V.
+inline void TransformVector(const float* M, const float* V, float* Out)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	_mm_storeu_ps(Out, TransformColumn(_mm_loadu_ps(M), _mm_loadu_ps(M + 4), _mm_loadu_ps(M + 8), _mm_loadu_ps(M + 12), _mm_loadu_ps(V)));
+#else
+	float Result[4];
+	for (int Row = 0; Row < 4; ++Row)
+	{
+		Result[Row] = M[Row] * V[0] + M[4 + Row] * V[1] + M[8 + Row] * V[2] + M[12 + Row] * V[3];
+	}
+	for (int Index = 0; Index < 4; ++Index)
+	{
+		Out[Index] = Result[Index];
+	}
+#endif
+}
+
+// Vetores de 3 componentes, como glm::vec3
+inline void NormalizeVector3(const float* V, float* Out)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	StoreVector3(Out, Normalize(LoadVector3(V)));
+#else
+	const float InverseLength = 1.0f / std::sqrt(V[0] * V[0] + V[1] * V[1] + V[2] * V[2]);
+	Out[0] = V[0] * InverseLength;
+	Out[1] = V[1] * InverseLength;
+	Out[2] = V[2] * InverseLength;
+#endif
+}
+
+inline void CrossVector3(const float* A, const float* B, float* Out)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	StoreVector3(Out, Cross(LoadVector3(A), LoadVector3(B)));
+#else
+	const float Result[3] = { A[1] * B[2] - A[2] * B[1], A[2] * B[0] - A[0] * B[2], A[0] * B[1] - A[1] * B[0] };
+	Out[0] = Result[0];
+	Out[1] = Result[1];
+	Out[2] = Result[2];
+#endif
+}
+
+// Translação * Rotação * Escala uniforme, o mesmo que
+// glm::scale(glm::rotate(glm::translate(I, Position), Angle, Axis), glm::vec3{ Scale }),
+// mas montando as colunas direto em vez de multiplicar as três matrizes.
+// Axis precisa estar normalizado.
+inline void ComposeTransform(const float* Position, const float* Axis, float Angle, float Scale, float* Out)
+{
+	const float Cos = std::cos(Angle);
+	const float Sin = std::sin(Angle);
+
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	// Coluna i da rotação: Cos * e_i + Sin * (Axis x e_i) + (1 - Cos) * Axis[i] * Axis
+	const __m128 AxisVector = LoadVector3(Axis);
+	const __m128 SinAxis = _mm_mul_ps(_mm_set1_ps(Sin), AxisVector);
+	const __m128 OneMinusCosAxis = _mm_mul_ps(_mm_set1_ps(1.0f - Cos), AxisVector);
+	const __m128 ScaleVector = _mm_set1_ps(Scale);
+
+	// Axis x e_0 = (0, z, -y), Axis x e_1 = (-z, 0, x), Axis x e_2 = (y, -x, 0), já multiplicados por Sin
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 NegativeSinAxis = _mm_sub_ps(Zero, SinAxis);
+	const __m128 Skew0 = _mm_shuffle_ps(SinAxis, NegativeSinAxis, _MM_SHUFFLE(3, 1, 2, 3));
+	const __m128 Skew1 = _mm_shuffle_ps(NegativeSinAxis, SinAxis, _MM_SHUFFLE(3, 0, 3, 2));
+	const __m128 Skew2 = _mm_shuffle_ps(_mm_unpacklo_ps(SinAxis, NegativeSinAxis), Zero, _MM_SHUFFLE(0, 0, 1, 2));
+
+	const __m128 Column0 = _mm_add_ps(_mm_add_ps(_mm_setr_ps(Cos, 0.0f, 0.0f, 0.0f), Skew0), _mm_mul_ps(Splat<0>(OneMinusCosAxis), AxisVector));
+	const __m128 Column1 = _mm_add_ps(_mm_add_ps(_mm_setr_ps(0.0f, Cos, 0.0f, 0.0f), Skew1), _mm_mul_ps(Splat<1>(OneMinusCosAxis), AxisVector));
+	const __m128 Column2 = _mm_add_ps(_mm_add_ps(_mm_setr_ps(0.0f, 0.0f, Cos, 0.0f), Skew2), _mm_mul_ps(Splat<2>(OneMinusCosAxis), AxisVector));
+
+	_mm_storeu_ps(Out, _mm_mul_ps(Column0, ScaleVector));
+	_mm_storeu_ps(Out + 4, _mm_mul_ps(Column1, ScaleVector));
+	_mm_storeu_ps(Out + 8, _mm_mul_ps(Column2, ScaleVector));
+	_mm_storeu_ps(Out + 12, _mm_setr_ps(Position[0], Position[1], Position[2], 1.0f));
+#else
+	const float OneMinusCos = 1.0f - Cos;
+	for (int Column = 0; Column < 3; ++Column)
+	{
+		for (int Row = 0; Row < 3; ++Row)
+		{
+			Out[Column * 4 + Row] = OneMinusCos * Axis[Column] * Axis[Row] * Scale;
+		}
+		Out[Column * 4 + Column] += Cos * Scale;
+		Out[Column * 4 + 3] = 0.0f;
+	}
+	Out[1] += Sin * Axis[2] * Scale;
+	Out[2] -= Sin * Axis[1] * Scale;
+	Out[4] -= Sin * Axis[2] * Scale;
+	Out[6] += Sin * Axis[0] * Scale;
+	Out[8] += Sin * Axis[1] * Scale;
+	Out[9] -= Sin * Axis[0] * Scale;
+	Out[12] = Position[0];
+	Out[13] = Position[1];
+	Out[14] = Position[2];
+	Out[15] = 1.0f;
+#endif
+}
+
+// Inversa transposta da parte 3x3 de M, em três colunas com w zero, como a
+// NormalMatrix do InstanceData. A inversa transposta é a matriz dos
+// cofatores dividida pelo determinante, e os cofatores de uma 3x3 são os
+// produtos vetoriais das colunas: não precisa da inversa geral da glm.
+inline void ComputeNormalMatrix(const float* M, float* Out)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	const __m128 Column0 = LoadVector3(M);
+	const __m128 Column1 = LoadVector3(M + 4);
+	const __m128 Column2 = LoadVector3(M + 8);
+
+	const __m128 Cofactor0 = Cross(Column1, Column2);
+	const __m128 Cofactor1 = Cross(Column2, Column0);
+	const __m128 Cofactor2 = Cross(Column0, Column1);
+	const __m128 InverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), Dot(Column0, Cofactor0));
+
+	_mm_storeu_ps(Out, _mm_mul_ps(Cofactor0, InverseDeterminant));
+	_mm_storeu_ps(Out + 4, _mm_mul_ps(Cofactor1, InverseDeterminant));
+	_mm_storeu_ps(Out + 8, _mm_mul_ps(Cofactor2, InverseDeterminant));
+#else
+	const float* Columns[3] = { M, M + 4, M + 8 };
+	float Cofactors[3][3];
+	for (int Column = 0; Column < 3; ++Column)
+	{
+		const float* A = Columns[(Column + 1) % 3];
+		const float* B = Columns[(Column + 2) % 3];
+		Cofactors[Column][0] = A[1] * B[2] - A[2] * B[1];
+		Cofactors[Column][1] = A[2] * B[0] - A[0] * B[2];
+		Cofactors[Column][2] = A[0] * B[1] - A[1] * B[0];
+	}
+
+	const float InverseDeterminant = 1.0f / (M[0] * Cofactors[0][0] + M[1] * Cofactors[0][1] + M[2] * Cofactors[0][2]);
+	for (int Column = 0; Column < 3; ++Column)
+	{
+		Out[Column * 4] = Cofactors[Column][0] * InverseDeterminant;
+		Out[Column * 4 + 1] = Cofactors[Column][1] * InverseDeterminant;
+		Out[Column * 4 + 2] = Cofactors[Column][2] * InverseDeterminant;
+		Out[Column * 4 + 3] = 0.0f;
+	}
+#endif
+}
+
+// Com escala uniforme s a parte 3x3 é s * R, e a inversa transposta é
+// R / s = M / s², então basta dividir as colunas pelo quadrado do tamanho
+// de uma delas
+inline void ComputeNormalMatrixUniformScale(const float* M, float* Out)
+{
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	const __m128 Column0 = LoadVector3(M);
+	const __m128 InverseScaleSquared = _mm_div_ps(_mm_set1_ps(1.0f), Dot(Column0, Column0));
+
+	_mm_storeu_ps(Out, _mm_mul_ps(Column0, InverseScaleSquared));
+	_mm_storeu_ps(Out + 4, _mm_mul_ps(LoadVector3(M + 4), InverseScaleSquared));
+	_mm_storeu_ps(Out + 8, _mm_mul_ps(LoadVector3(M + 8), InverseScaleSquared));
+#else
+	const float InverseScaleSquared = 1.0f / (M[0] * M[0] + M[1] * M[1] + M[2] * M[2]);
+	for (int Column = 0; Column < 3; ++Column)
+	{
+		Out[Column * 4] = M[Column * 4] * InverseScaleSquared;
+		Out[Column * 4 + 1] = M[Column * 4 + 1] * InverseScaleSquared;
+		Out[Column * 4 + 2] = M[Column * 4 + 2] * InverseScaleSquared;
+		Out[Column * 4 + 3] = 0.0f;
+	}
+#endif
+}
+
+// glm::perspective(FieldOfView, AspectRatio, Near, Far) * glm::lookAt(Eye, Center, Up),
+// com as mesmas convenções da glm (mão direita, profundidade de -1 a 1). A
+// projeção tem só cinco termos, então as linhas do produto saem direto das
+// linhas da view sem o produto de matrizes completo.
+inline void ComputeViewProjection(const float* Eye, const float* Center, const float* Up, float FieldOfView, float AspectRatio, float Near, float Far, float* Out)
+{
+	const float TanHalfFieldOfView = std::tan(FieldOfView * 0.5f);
+	const float ScaleX = 1.0f / (AspectRatio * TanHalfFieldOfView);
+	const float ScaleY = 1.0f / TanHalfFieldOfView;
+	const float ScaleZ = -(Far + Near) / (Far - Near);
+	const float OffsetZ = -(2.0f * Far * Near) / (Far - Near);
+
+#if SIMD_MATH_SSE
+	using namespace SimdMathDetail;
+	const __m128 EyeVector = LoadVector3(Eye);
+	const __m128 Forward = Normalize(_mm_sub_ps(LoadVector3(Center), EyeVector));
+	const __m128 Side = Normalize(Cross(Forward, LoadVector3(Up)));
+	const __m128 CameraUp = Cross(Side, Forward);
+
+	// Linhas da view: (Side, -Side.Eye), (CameraUp, -CameraUp.Eye), (-Forward, Forward.Eye), (0, 0, 0, 1).
+	// O w de cada eixo é zero, então somar o produto escalar em w monta a linha.
+	const __m128 WMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+	const __m128 SideRow = _mm_sub_ps(Side, _mm_and_ps(Dot(Side, EyeVector), WMask));
+	const __m128 UpRow = _mm_sub_ps(CameraUp, _mm_and_ps(Dot(CameraUp, EyeVector), WMask));
+	const __m128 ForwardRow = _mm_sub_ps(Forward, _mm_and_ps(Dot(Forward, EyeVector), WMask));
+
+	// Linhas de Projeção * View
+	__m128 Row0 = _mm_mul_ps(_mm_set1_ps(ScaleX), SideRow);
+	__m128 Row1 = _mm_mul_ps(_mm_set1_ps(ScaleY), UpRow);
+	__m128 Row2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-ScaleZ), ForwardRow), _mm_and_ps(_mm_set1_ps(OffsetZ), WMask));
+	__m128 Row3 = ForwardRow;
+	_MM_TRANSPOSE4_PS(Row0, Row1, Row2, Row3);
+
+	_mm_storeu_ps(Out, Row0);
+	_mm_storeu_ps(Out + 4, Row1);
+	_mm_storeu_ps(Out + 8, Row2);
+	_mm_storeu_ps(Out + 12, Row3);
+#else
+	auto Normalize3 = [](float* V)
+	{
+		const float InverseLength = 1.0f / std::sqrt(V[0] * V[0] + V[1] * V[1] + V[2] * V[2]);
+		V[0] *= InverseLength;
+		V[1] *= InverseLength;
+		V[2] *= InverseLength;
+	};
+
+	float Forward[3] = { Center[0] - Eye[0], Center[1] - Eye[1], Center[2] - Eye[2] };
+	Normalize3(Forward);
+	float Side[3] = { Forward[1] * Up[2] - Forward[2] * Up[1], Forward[2] * Up[0] - Forward[0] * Up[2], Forward[0] * Up[1] - Forward[1] * Up[0] };
+	Normalize3(Side);
+	const float CameraUp[3] = { Side[1] * Forward[2] - Side[2] * Forward[1], Side[2] * Forward[0] - Side[0] * Forward[2], Side[0] * Forward[1] - Side[1] * Forward[0] };
+
+	const float SideRow[4] = { Side[0], Side[1], Side[2], -(Side[0] * Eye[0] + Side[1] * Eye[1] + Side[2] * Eye[2]) };
+	const float UpRow[4] = { CameraUp[0], CameraUp[1], CameraUp[2], -(CameraUp[0] * Eye[0] + CameraUp[1] * Eye[1] + CameraUp[2] * Eye[2]) };
+	const float ForwardRow[4] = { Forward[0], Forward[1], Forward[2], -(Forward[0] * Eye[0] + Forward[1] * Eye[1] + Forward[2] * Eye[2]) };
+	for (int Column = 0; Column < 4; ++Column)
+	{
+		Out[Column * 4] = ScaleX * SideRow[Column];
+		Out[Column * 4 + 1] = ScaleY * UpRow[Column];
+		Out[Column * 4 + 2] = -ScaleZ * ForwardRow[Column] + (Column == 3 ? OffsetZ : 0.0f);
+		Out[Column * 4 + 3] = ForwardRow[Column];
+	}
+#endif
+}
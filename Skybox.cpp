@@ -0,0 +1,56 @@
+#include "Skybox.h"
+
+#include <glm/ext.hpp>
+
+#include "Texture.h"
+
+void Skybox::Create(const char* PanoramaFile)
+{
+	CubemapId = LoadCubemapFromEquirectangular(PanoramaFile);
+
+	// O triângulo é gerado no vertex shader a partir de gl_VertexID
+	glGenVertexArrays(1, &VertexArrayId);
+
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+void Skybox::Release()
+{
+	glDeleteVertexArrays(1, &VertexArrayId);
+	glDeleteTextures(1, &CubemapId);
+
+	VertexArrayId = 0;
+	CubemapId = 0;
+}
+
+void Skybox::Draw(GLuint ProgramId, const glm::mat4& ViewProjection, const glm::vec3& CameraLocation) const
+{
+	if (ProgramId == 0)
+	{
+		return;
+	}
+
+	// Sem a translação da câmera o fundo fica infinitamente distante
+	const glm::mat4 InverseViewProjection = glm::inverse(glm::translate(ViewProjection, CameraLocation));
+
+	glUseProgram(ProgramId);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "InverseViewProjection"), 1, GL_FALSE, glm::value_ptr(InverseViewProjection));
+	glUniform1i(glGetUniformLocation(ProgramId, "Sky"), 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, CubemapId);
+
+	// O triângulo fica exatamente no plano de fundo (profundidade 1), onde
+	// só passa nos pixels que não foram cobertos
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+
+	glBindVertexArray(VertexArrayId);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
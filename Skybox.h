@@ -0,0 +1,20 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Fundo com o panorama da Via Láctea, convertido para cubemap ao carregar.
+// É desenhado como um triângulo que cobre a tela no plano de fundo, depois
+// dos objetos opacos, então só os pixels que sobraram são sombreados.
+class Skybox
+{
+public:
+	void Create(const char* PanoramaFile);
+	void Release();
+
+	void Draw(GLuint ProgramId, const glm::mat4& ViewProjection, const glm::vec3& CameraLocation) const;
+
+private:
+	GLuint CubemapId = 0;
+	GLuint VertexArrayId = 0;
+};
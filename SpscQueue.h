@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Fila sem lock para exatamente uma thread produtora e uma consumidora. Os
+// índices só crescem e são mascarados no acesso, por isso Capacity precisa
+// ser potência de 2. Cada índice é escrito por uma única thread e fica numa
+// linha de cache própria, para as duas threads não disputarem a mesma linha.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity precisa ser potencia de 2");
+
+public:
+	// Chamado só pela thread produtora. Retorna false se a fila estiver cheia.
+	bool Push(const T& Item)
+	{
+		const size_t Write = WriteIndex.load(std::memory_order_relaxed);
+		if (Write - ReadIndex.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		Items[Write & (Capacity - 1)] = Item;
+		WriteIndex.store(Write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Chamado só pela thread consumidora. Retorna false se a fila estiver vazia.
+	bool Pop(T& OutItem)
+	{
+		const size_t Read = ReadIndex.load(std::memory_order_relaxed);
+		if (Read == WriteIndex.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		OutItem = Items[Read & (Capacity - 1)];
+		ReadIndex.store(Read + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	alignas(64) std::atomic<size_t> WriteIndex{ 0 };
+	alignas(64) std::atomic<size_t> ReadIndex{ 0 };
+	alignas(64) T Items[Capacity];
+};
@@ -0,0 +1,158 @@
+#include "StarCatalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	constexpr float MinTableMagnitude = -2.0f;
+	constexpr float MaxTableMagnitude = 22.0f;
+	constexpr float TableStep = 0.1f;
+}
+
+bool StarCatalog::Create(const char* CatalogFile)
+{
+	if (!File.Open(CatalogFile))
+	{
+		std::cout << "Catalogo de estrelas " << CatalogFile << " nao encontrado" << std::endl;
+		return false;
+	}
+
+	StarCatalogHeader Header;
+	if (File.GetSize() < sizeof(Header))
+	{
+		std::cout << "Catalogo de estrelas " << CatalogFile << " invalido" << std::endl;
+		File.Close();
+		return false;
+	}
+	std::memcpy(&Header, File.GetData(), sizeof(Header));
+
+	if (std::memcmp(Header.Magic, StarCatalogFormat::Magic, sizeof(Header.Magic)) != 0 || Header.Version != StarCatalogFormat::Version ||
+	    File.GetSize() < sizeof(Header) + static_cast<size_t>(Header.NumStars) * sizeof(StarRecord))
+	{
+		std::cout << "Catalogo de estrelas " << CatalogFile << " invalido" << std::endl;
+		File.Close();
+		return false;
+	}
+
+	Records = reinterpret_cast<const StarRecord*>(File.GetData() + sizeof(Header));
+	NumStars = Header.NumStars;
+	NumLoadedStars = 0;
+
+	// Busca binária por cada décimo de magnitude: só algumas páginas do
+	// arquivo são lidas, o resto é lido pelo Stream
+	const int TableSize = static_cast<int>((MaxTableMagnitude - MinTableMagnitude) / TableStep) + 1;
+	MagnitudeCounts.resize(TableSize);
+	for (int Entry = 0; Entry < TableSize; ++Entry)
+	{
+		const int16_t Magnitude = static_cast<int16_t>((MinTableMagnitude + Entry * TableStep) * StarCatalogFormat::ValueScale);
+		const StarRecord* Last = std::upper_bound(Records, Records + NumStars, Magnitude, [](int16_t Value, const StarRecord& Record) { return Value < Record.Magnitude; });
+		MagnitudeCounts[Entry] = static_cast<GLuint>(Last - Records);
+	}
+
+	std::cout << "Catalogo de estrelas com " << NumStars << " estrelas" << std::endl;
+
+	glGenVertexArrays(1, &VertexArrayId);
+	glGenBuffers(1, &VertexBuffer);
+
+	glBindVertexArray(VertexArrayId);
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(NumStars) * sizeof(StarRecord), nullptr, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, sizeof(StarRecord), reinterpret_cast<void*>(offsetof(StarRecord, Direction)));
+	glVertexAttribPointer(1, 1, GL_SHORT, GL_FALSE, sizeof(StarRecord), reinterpret_cast<void*>(offsetof(StarRecord, Magnitude)));
+	glVertexAttribPointer(2, 1, GL_SHORT, GL_FALSE, sizeof(StarRecord), reinterpret_cast<void*>(offsetof(StarRecord, ColorIndex)));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// O tamanho de cada ponto vem do vertex shader
+	glEnable(GL_PROGRAM_POINT_SIZE);
+
+	return true;
+}
+
+void StarCatalog::Release()
+{
+	File.Close();
+	Records = nullptr;
+
+	glDeleteBuffers(1, &VertexBuffer);
+	glDeleteVertexArrays(1, &VertexArrayId);
+
+	VertexBuffer = 0;
+	VertexArrayId = 0;
+	NumStars = 0;
+	NumLoadedStars = 0;
+}
+
+void StarCatalog::Stream(GLuint MaxStarsPerFrame)
+{
+	if (!Records || NumLoadedStars >= NumStars)
+	{
+		return;
+	}
+
+	// Os registros vão do arquivo mapeado direto para o buffer
+	const GLuint Count = std::min(MaxStarsPerFrame, NumStars - NumLoadedStars);
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(NumLoadedStars) * sizeof(StarRecord), static_cast<GLsizeiptr>(Count) * sizeof(StarRecord), Records + NumLoadedStars);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	NumLoadedStars += Count;
+
+	// Tudo já está na GPU, o arquivo não é mais necessário
+	if (NumLoadedStars == NumStars)
+	{
+		File.Close();
+		Records = nullptr;
+	}
+}
+
+GLuint StarCatalog::CountBrighterThan(float Magnitude) const
+{
+	if (MagnitudeCounts.empty())
+	{
+		return 0;
+	}
+
+	const int Entry = static_cast<int>((Magnitude - MinTableMagnitude) / TableStep);
+	if (Entry < 0)
+	{
+		return 0;
+	}
+	return MagnitudeCounts[std::min(Entry, static_cast<int>(MagnitudeCounts.size()) - 1)];
+}
+
+void StarCatalog::Draw(GLuint ProgramId, const glm::mat4& ViewProjection, float MagnitudeLimit) const
+{
+	const GLuint NumVisibleStars = std::min(NumLoadedStars, CountBrighterThan(MagnitudeLimit));
+	if (ProgramId == 0 || NumVisibleStars == 0)
+	{
+		return;
+	}
+
+	glUseProgram(ProgramId);
+	glUniformMatrix4fv(glGetUniformLocation(ProgramId, "ViewProjection"), 1, GL_FALSE, glm::value_ptr(ViewProjection));
+	glUniform1f(glGetUniformLocation(ProgramId, "MagnitudeLimit"), MagnitudeLimit);
+
+	// No plano de fundo, atrás dos corpos, e somando a luz das estrelas
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	glBindVertexArray(VertexArrayId);
+	glDrawArrays(GL_POINTS, 0, NumVisibleStars);
+	glBindVertexArray(0);
+
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
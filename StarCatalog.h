@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+#include "StarCatalogFormat.h"
+
+// Estrelas de um catálogo binário (ver StarCatalogFormat.h) desenhadas como
+// GL_POINTS com mistura aditiva. O arquivo é mapeado na memória e enviado
+// para a GPU em blocos, um por frame, começando pelas mais brilhantes. Como
+// os registros estão ordenados por magnitude, o limite de brilho é só o
+// número de estrelas desenhadas a partir do início do buffer.
+class StarCatalog
+{
+public:
+	bool Create(const char* CatalogFile);
+	void Release();
+
+	// Envia o próximo bloco de até MaxStarsPerFrame estrelas
+	void Stream(GLuint MaxStarsPerFrame);
+
+	// Depois do fundo e antes dos transparentes
+	void Draw(GLuint ProgramId, const glm::mat4& ViewProjection, float MagnitudeLimit) const;
+
+	GLuint GetNumStars() const { return NumStars; }
+	GLuint GetNumLoadedStars() const { return NumLoadedStars; }
+
+private:
+	// Quantas estrelas têm magnitude menor ou igual a Magnitude
+	GLuint CountBrighterThan(float Magnitude) const;
+
+	MappedFile File;
+	const StarRecord* Records = nullptr;
+	GLuint NumStars = 0;
+	GLuint NumLoadedStars = 0;
+
+	GLuint VertexArrayId = 0;
+	GLuint VertexBuffer = 0;
+
+	// Quantidade de estrelas até cada décimo de magnitude, a partir de
+	// MinTableMagnitude. Fica válida depois que o arquivo é fechado.
+	std::vector<GLuint> MagnitudeCounts;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Formato binário do catálogo de estrelas: um StarCatalogHeader seguido de
+// NumStars registros StarRecord, ordenados da estrela mais brilhante para a
+// mais fraca. Os registros são lidos direto pela GPU como atributos de
+// vértice, sem nenhuma conversão na CPU.
+namespace StarCatalogFormat
+{
+	constexpr char Magic[4] = { 'B', 'M', 'S', 'C' };
+	constexpr uint32_t Version = 1;
+
+	// Magnitude e índice de cor B-V são guardados em milésimos
+	constexpr float ValueScale = 1000.0f;
+}
+
+struct StarCatalogHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t NumStars;
+	uint32_t Reserved;
+};
+
+struct StarRecord
+{
+	// Direção em coordenadas octaédricas, como snorm de 16 bits
+	int16_t Direction[2];
+	int16_t Magnitude;
+	int16_t ColorIndex;
+};
+
+static_assert(sizeof(StarCatalogHeader) == 16, "StarCatalogHeader precisa ter 16 bytes");
+static_assert(sizeof(StarRecord) == 8, "StarRecord precisa ter 8 bytes");
+
+// Projeta a direção (unitária) num octaedro desdobrado no quadrado [-1, 1]²
+inline glm::vec2 EncodeOctahedral(const glm::vec3& Direction)
+{
+	const glm::vec3 D = Direction / (glm::abs(Direction.x) + glm::abs(Direction.y) + glm::abs(Direction.z));
+	if (D.z >= 0.0f)
+	{
+		return glm::vec2{ D.x, D.y };
+	}
+
+	const glm::vec2 Sign{ D.x >= 0.0f ? 1.0f : -1.0f, D.y >= 0.0f ? 1.0f : -1.0f };
+	return (1.0f - glm::abs(glm::vec2{ D.y, D.x })) * Sign;
+}
+
+inline glm::vec3 DecodeOctahedral(const glm::vec2& Encoded)
+{
+	glm::vec3 D{ Encoded.x, Encoded.y, 1.0f - glm::abs(Encoded.x) - glm::abs(Encoded.y) };
+	if (D.z < 0.0f)
+	{
+		const glm::vec2 Sign{ D.x >= 0.0f ? 1.0f : -1.0f, D.y >= 0.0f ? 1.0f : -1.0f };
+		const glm::vec2 XY = (1.0f - glm::abs(glm::vec2{ D.y, D.x })) * Sign;
+		D.x = XY.x;
+		D.y = XY.y;
+	}
+	return glm::normalize(D);
+}
@@ -0,0 +1,368 @@
+#include "Texture.h"
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "deps/stb/stb_image.h"
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "deps/stb/stb_image_resize.h"
+
+namespace
+{
+	// Texels RGB de uma imagem, apontando para o AssetPack quando ela está
+	// empacotada em RGB8 ou decodificados pelo stbi_load
+	struct RGBImage
+	{
+		const unsigned char* Pixels = nullptr;
+		int Width = 0;
+		int Height = 0;
+		unsigned char* DecodedPixels = nullptr;
+
+		RGBImage() = default;
+		RGBImage(const RGBImage&) = delete;
+		RGBImage& operator=(const RGBImage&) = delete;
+		~RGBImage() { stbi_image_free(DecodedPixels); }
+	};
+
+	bool LoadRGBImage(const char* TextureFile, RGBImage& Image)
+	{
+		const AssetEntry* Entry = AssetPack::Get().Find(TextureFile);
+		if (Entry && Entry->Type == EAssetType::Texture && Entry->Format == ETextureFormat::RGB8)
+		{
+			Image.Pixels = AssetPack::Get().GetData(*Entry);
+			Image.Width = static_cast<int>(Entry->Dimensions[0]);
+			Image.Height = static_cast<int>(Entry->Dimensions[1]);
+			return true;
+		}
+
+		int NumberOfComponents = 0;
+		Image.DecodedPixels = stbi_load(TextureFile, &Image.Width, &Image.Height, &NumberOfComponents, 3);
+		Image.Pixels = Image.DecodedPixels;
+		return Image.Pixels != nullptr;
+	}
+
+	// Retorna as entradas BC1 de todas as camadas se todas estiverem no
+	// pacote com o mesmo tamanho e número de mips
+	bool FindBC1Layers(const char* const* TextureFiles, size_t TextureCount, std::vector<const AssetEntry*>& Entries)
+	{
+		if (!GLEW_EXT_texture_compression_s3tc)
+		{
+			return false;
+		}
+
+		Entries.clear();
+		for (size_t Layer = 0; Layer < TextureCount; ++Layer)
+		{
+			const AssetEntry* Entry = AssetPack::Get().Find(TextureFiles[Layer]);
+			if (!Entry || Entry->Type != EAssetType::Texture || Entry->Format != ETextureFormat::BC1)
+			{
+				return false;
+			}
+
+			if (!Entries.empty() && (Entry->Dimensions[0] != Entries[0]->Dimensions[0] || Entry->Dimensions[1] != Entries[0]->Dimensions[1] || Entry->Dimensions[2] != Entries[0]->Dimensions[2]))
+			{
+				return false;
+			}
+			Entries.push_back(Entry);
+		}
+		return true;
+	}
+
+	// Envia os mips já comprimidos pelo BuildAssetPack, lendo direto do pacote
+	void UploadBC1Layers(const std::vector<const AssetEntry*>& Entries)
+	{
+		const GLsizei LayerCount = static_cast<GLsizei>(Entries.size());
+		const uint32_t LevelCount = Entries[0]->Dimensions[2];
+
+		uint32_t Width = Entries[0]->Dimensions[0];
+		uint32_t Height = Entries[0]->Dimensions[1];
+		size_t LevelOffset = 0;
+
+		for (uint32_t Level = 0; Level < LevelCount; ++Level)
+		{
+			const GLsizei LevelSize = static_cast<GLsizei>(GetBC1LevelSize(Width, Height));
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, Level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, Width, Height, LayerCount, 0, LevelSize * LayerCount, nullptr);
+
+			for (GLsizei Layer = 0; Layer < LayerCount; ++Layer)
+			{
+				const unsigned char* LevelData = AssetPack::Get().GetData(*Entries[Layer]) + LevelOffset;
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, Level, 0, 0, Layer, Width, Height, 1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, LevelSize, LevelData);
+			}
+
+			LevelOffset += LevelSize;
+			Width = Width > 1 ? Width / 2 : 1;
+			Height = Height > 1 ? Height / 2 : 1;
+		}
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(LevelCount) - 1);
+	}
+}
+
+GLuint LoadTexture(const char* TextureFile)
+{
+	std::cout << "Carregando Textura " << TextureFile << std::endl;
+
+	RGBImage Texture;
+	const bool bLoaded = LoadRGBImage(TextureFile, Texture);
+	assert(bLoaded);
+	(void)bLoaded;
+
+	// Gerar o Identifador da Textura
+	GLuint TextureId;
+	glGenTextures(1, &TextureId);
+
+	// Habilita a textura para ser modificada
+	glBindTexture(GL_TEXTURE_2D, TextureId);
+
+	// Copia a textura para a memória da GPU
+	GLint Level = 0;
+	GLint Border = 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, Level, GL_RGB, Texture.Width, Texture.Height, Border, GL_RGB, GL_UNSIGNED_BYTE, Texture.Pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return TextureId;
+}
+
+bool IsTextureAvailable(const char* TextureFile)
+{
+	const AssetEntry* Entry = AssetPack::Get().Find(TextureFile);
+	if (Entry && Entry->Type == EAssetType::Texture)
+	{
+		return true;
+	}
+
+	int Width = 0;
+	int Height = 0;
+	int NumberOfComponents = 0;
+	return stbi_info(TextureFile, &Width, &Height, &NumberOfComponents) != 0;
+}
+
+GLuint LoadTextureArray(const char* const* TextureFiles, size_t TextureCount, size_t LayerCapacity)
+{
+	assert(TextureCount > 0);
+	LayerCapacity = std::max(LayerCapacity, TextureCount);
+
+	GLuint TextureId;
+	glGenTextures(1, &TextureId);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, TextureId);
+
+	std::vector<const AssetEntry*> BC1Entries;
+	if (FindBC1Layers(TextureFiles, TextureCount, BC1Entries))
+	{
+		std::cout << "Carregando " << TextureCount << " texturas BC1 do pacote de assets" << std::endl;
+		UploadBC1Layers(BC1Entries);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return TextureId;
+	}
+
+	int ArrayWidth = 0;
+	int ArrayHeight = 0;
+	std::vector<unsigned char> ResizedData;
+
+	for (size_t Layer = 0; Layer < TextureCount; ++Layer)
+	{
+		std::cout << "Carregando Textura " << TextureFiles[Layer] << " na camada " << Layer << std::endl;
+
+		RGBImage Texture;
+		if (!LoadRGBImage(TextureFiles[Layer], Texture))
+		{
+			std::cout << "Erro ao carregar a textura " << TextureFiles[Layer] << std::endl;
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+			glDeleteTextures(1, &TextureId);
+			return 0;
+		}
+
+		const int TextureWidth = Texture.Width;
+		const int TextureHeight = Texture.Height;
+
+		// A primeira imagem define o tamanho de todas as camadas
+		if (Layer == 0)
+		{
+			ArrayWidth = TextureWidth;
+			ArrayHeight = TextureHeight;
+
+			GLint Level = 0;
+			GLint Border = 0;
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, Level, GL_RGB8, ArrayWidth, ArrayHeight, static_cast<GLsizei>(LayerCapacity), Border, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		}
+
+		const unsigned char* LayerData = Texture.Pixels;
+		if (TextureWidth != ArrayWidth || TextureHeight != ArrayHeight)
+		{
+			ResizedData.resize(static_cast<size_t>(ArrayWidth) * ArrayHeight * 3);
+			stbir_resize_uint8(Texture.Pixels, TextureWidth, TextureHeight, 0, ResizedData.data(), ArrayWidth, ArrayHeight, 0, 3);
+			LayerData = ResizedData.data();
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(Layer), ArrayWidth, ArrayHeight, 1, GL_RGB, GL_UNSIGNED_BYTE, LayerData);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return TextureId;
+}
+
+bool UpdateTextureArrayLayer(GLuint TextureId, size_t Layer, const char* TextureFile)
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, TextureId);
+
+	GLint bCompressed = GL_FALSE;
+	GLint ArrayWidth = 0;
+	GLint ArrayHeight = 0;
+	GLint LayerCapacity = 0;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_COMPRESSED, &bCompressed);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &ArrayWidth);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &ArrayHeight);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_DEPTH, &LayerCapacity);
+
+	RGBImage Texture;
+	if (bCompressed || Layer >= static_cast<size_t>(LayerCapacity) || !LoadRGBImage(TextureFile, Texture))
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return false;
+	}
+
+	std::cout << "Carregando Textura " << TextureFile << " na camada " << Layer << std::endl;
+
+	std::vector<unsigned char> ResizedData;
+	const unsigned char* LayerData = Texture.Pixels;
+	if (Texture.Width != ArrayWidth || Texture.Height != ArrayHeight)
+	{
+		ResizedData.resize(static_cast<size_t>(ArrayWidth) * ArrayHeight * 3);
+		stbir_resize_uint8(Texture.Pixels, Texture.Width, Texture.Height, 0, ResizedData.data(), ArrayWidth, ArrayHeight, 0, 3);
+		LayerData = ResizedData.data();
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(Layer), ArrayWidth, ArrayHeight, 1, GL_RGB, GL_UNSIGNED_BYTE, LayerData);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return true;
+}
+
+void GenerateTextureArrayMipmaps(GLuint TextureId)
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, TextureId);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+GLuint LoadCubemapFromEquirectangular(const char* TextureFile, int FaceSize)
+{
+	std::cout << "Carregando Textura " << TextureFile << " como cubemap" << std::endl;
+
+	RGBImage Texture;
+	const bool bLoaded = LoadRGBImage(TextureFile, Texture);
+	assert(bLoaded);
+	(void)bLoaded;
+
+	const int TextureWidth = Texture.Width;
+	const int TextureHeight = Texture.Height;
+	const unsigned char* TextureData = Texture.Pixels;
+
+	if (FaceSize <= 0)
+	{
+		FaceSize = TextureWidth / 4;
+	}
+
+	// Leitura bilinear do panorama, repetindo na horizontal
+	auto SamplePanorama = [&](float U, float V, unsigned char* OutTexel)
+	{
+		const float X = U * TextureWidth - 0.5f;
+		const float Y = std::fmin(std::fmax(V * TextureHeight - 0.5f, 0.0f), TextureHeight - 1.0f);
+		const int X0 = static_cast<int>(std::floor(X));
+		const int Y0 = static_cast<int>(Y);
+		const float FracX = X - X0;
+		const float FracY = Y - Y0;
+		const int Columns[2] = { (X0 % TextureWidth + TextureWidth) % TextureWidth, ((X0 + 1) % TextureWidth + TextureWidth) % TextureWidth };
+		const int Rows[2] = { Y0, Y0 + 1 < TextureHeight ? Y0 + 1 : Y0 };
+
+		for (int Channel = 0; Channel < 3; ++Channel)
+		{
+			const float Top = TextureData[(Rows[0] * TextureWidth + Columns[0]) * 3 + Channel] * (1.0f - FracX) + TextureData[(Rows[0] * TextureWidth + Columns[1]) * 3 + Channel] * FracX;
+			const float Bottom = TextureData[(Rows[1] * TextureWidth + Columns[0]) * 3 + Channel] * (1.0f - FracX) + TextureData[(Rows[1] * TextureWidth + Columns[1]) * 3 + Channel] * FracX;
+			OutTexel[Channel] = static_cast<unsigned char>(Top * (1.0f - FracY) + Bottom * FracY + 0.5f);
+		}
+	};
+
+	GLuint TextureId;
+	glGenTextures(1, &TextureId);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, TextureId);
+
+	constexpr float Pi = 3.14159265358979f;
+	std::vector<unsigned char> FaceData(static_cast<size_t>(FaceSize) * FaceSize * 3);
+
+	for (int Face = 0; Face < 6; ++Face)
+	{
+		for (int Row = 0; Row < FaceSize; ++Row)
+		{
+			for (int Column = 0; Column < FaceSize; ++Column)
+			{
+				const float S = 2.0f * (Column + 0.5f) / FaceSize - 1.0f;
+				const float T = 2.0f * (Row + 0.5f) / FaceSize - 1.0f;
+
+				// Direção de cada texel segundo a convenção das faces de cubemap do OpenGL
+				float Direction[3];
+				switch (Face)
+				{
+					case 0: Direction[0] = 1.0f;  Direction[1] = -T;    Direction[2] = -S;    break;
+					case 1: Direction[0] = -1.0f; Direction[1] = -T;    Direction[2] = S;     break;
+					case 2: Direction[0] = S;     Direction[1] = 1.0f;  Direction[2] = T;     break;
+					case 3: Direction[0] = S;     Direction[1] = -1.0f; Direction[2] = -T;    break;
+					case 4: Direction[0] = S;     Direction[1] = -T;    Direction[2] = 1.0f;  break;
+					default: Direction[0] = -S;   Direction[1] = -T;    Direction[2] = -1.0f; break;
+				}
+
+				const float Length = std::sqrt(Direction[0] * Direction[0] + Direction[1] * Direction[1] + Direction[2] * Direction[2]);
+				const float Longitude = std::atan2(Direction[2], Direction[0]);
+				const float Latitude = std::acos(Direction[1] / Length);
+
+				SamplePanorama(0.5f + Longitude / (2.0f * Pi), Latitude / Pi, &FaceData[(static_cast<size_t>(Row) * FaceSize + Column) * 3]);
+			}
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + Face, 0, GL_RGB8, FaceSize, FaceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, FaceData.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	return TextureId;
+}
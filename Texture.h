@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+GLuint LoadTexture(const char* TextureFile);
+
+// Se a imagem está no pacote de assets ou o cabeçalho do arquivo pode ser
+// lido, sem decodificar os pixels. A cena confere as texturas com isso antes
+// de trocar a cena em uso.
+bool IsTextureAvailable(const char* TextureFile);
+
+// Carrega as imagens como camadas de uma GL_TEXTURE_2D_ARRAY. As imagens com
+// tamanho diferente da primeira são redimensionadas para o tamanho dela.
+// LayerCapacity reserva camadas vazias depois das imagens, para
+// UpdateTextureArrayLayer acrescentar texturas sem recriar a array; as arrays
+// comprimidas do pacote de assets ficam sempre com TextureCount camadas.
+// Retorna 0 se alguma imagem não pode ser carregada.
+GLuint LoadTextureArray(const char* const* TextureFiles, size_t TextureCount, size_t LayerCapacity = 0);
+
+// Troca a imagem de uma camada, que pode ser uma das reservadas. Os mips só
+// são refeitos por GenerateTextureArrayMipmaps, uma vez depois de todas as
+// camadas trocadas. Retorna false se a array é comprimida (veio do pacote de
+// assets) ou não tem a camada, e precisa ser carregada de novo.
+bool UpdateTextureArrayLayer(GLuint TextureId, size_t Layer, const char* TextureFile);
+
+void GenerateTextureArrayMipmaps(GLuint TextureId);
+
+// Converte um panorama equirretangular numa cubemap com faces de FaceSize
+// texels. Se FaceSize for 0 usa um quarto da largura da imagem.
+GLuint LoadCubemapFromEquirectangular(const char* TextureFile, int FaceSize = 0);
@@ -0,0 +1,159 @@
+#include "TiledScreenshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// Tiles maiores que isso não trazem ganho e pesam na memória da GPU
+	constexpr int MaxTileSize = 2048;
+}
+
+bool TiledScreenshot::Begin(const std::string& InPath, int InImageWidth, int InImageHeight, size_t MemoryBudget)
+{
+	if (IsActive())
+	{
+		return false;
+	}
+
+	GLint MaxRenderbufferSize = 0;
+	GLint MaxViewportSize[2] = {};
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &MaxRenderbufferSize);
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, MaxViewportSize);
+
+	ImageWidth = InImageWidth;
+	ImageHeight = InImageHeight;
+
+	// A altura do tile sai do orçamento: a faixa tem TileHeight linhas da imagem inteira
+	const int MaxSize = std::min({ MaxTileSize, static_cast<int>(MaxRenderbufferSize), static_cast<int>(MaxViewportSize[0]), static_cast<int>(MaxViewportSize[1]) });
+	const size_t RowSize = static_cast<size_t>(ImageWidth) * 3;
+	TileWidth = std::min(ImageWidth, MaxSize);
+	TileHeight = static_cast<int>(std::min<size_t>({ MemoryBudget / RowSize, static_cast<size_t>(MaxSize), static_cast<size_t>(ImageHeight) }));
+	if (TileHeight < 1)
+	{
+		std::cout << "Memoria insuficiente para uma linha de " << ImageWidth << " pixels" << std::endl;
+		return false;
+	}
+
+	NumTilesX = (ImageWidth + TileWidth - 1) / TileWidth;
+	NumTilesY = (ImageHeight + TileHeight - 1) / TileHeight;
+	TileX = 0;
+	TileY = 0;
+
+	Path = InPath;
+	File = std::fopen(Path.c_str(), "wb");
+	if (!File)
+	{
+		std::cout << "Erro ao criar " << Path << std::endl;
+		return false;
+	}
+	std::fprintf(File, "P6\n%d %d\n255\n", ImageWidth, ImageHeight);
+
+	Strip.resize(RowSize * TileHeight);
+	TilePixels.resize(static_cast<size_t>(TileWidth) * TileHeight * 3);
+
+	glGenRenderbuffers(1, &ColorRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, ColorRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TileWidth, TileHeight);
+
+	glGenRenderbuffers(1, &DepthRenderbufferId);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthRenderbufferId);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, TileWidth, TileHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &FramebufferId);
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorRenderbufferId);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthRenderbufferId);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Erro ao criar o framebuffer dos tiles" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		Finish();
+		return false;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	std::cout << "Renderizando " << Path << " (" << ImageWidth << "x" << ImageHeight << ") em " << NumTilesX << "x" << NumTilesY << " tiles" << std::endl;
+	return true;
+}
+
+glm::ivec2 TiledScreenshot::GetTileSize() const
+{
+	return { std::min(TileWidth, ImageWidth - TileX * TileWidth), std::min(TileHeight, ImageHeight - TileY * TileHeight) };
+}
+
+void TiledScreenshot::GetTileBounds(glm::vec2& OutMin, glm::vec2& OutMax) const
+{
+	// As linhas de tiles começam no topo da imagem, onde y normalizado é 1
+	const glm::ivec2 Size = GetTileSize();
+	const float Left = static_cast<float>(TileX * TileWidth);
+	const float Top = static_cast<float>(TileY * TileHeight);
+
+	OutMin = glm::vec2{ Left / ImageWidth * 2.0f - 1.0f, 1.0f - (Top + Size.y) / ImageHeight * 2.0f };
+	OutMax = glm::vec2{ (Left + Size.x) / ImageWidth * 2.0f - 1.0f, 1.0f - Top / ImageHeight * 2.0f };
+}
+
+void TiledScreenshot::EndTile()
+{
+	if (!IsActive())
+	{
+		return;
+	}
+
+	const glm::ivec2 Size = GetTileSize();
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FramebufferId);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, Size.x, Size.y, GL_RGB, GL_UNSIGNED_BYTE, TilePixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	// O OpenGL lê de baixo para cima e o PPM é de cima para baixo
+	const size_t StripRowSize = static_cast<size_t>(ImageWidth) * 3;
+	const size_t TileRowSize = static_cast<size_t>(Size.x) * 3;
+	for (int Row = 0; Row < Size.y; ++Row)
+	{
+		unsigned char* Destination = &Strip[(Size.y - 1 - Row) * StripRowSize + static_cast<size_t>(TileX) * TileWidth * 3];
+		std::memcpy(Destination, &TilePixels[Row * TileRowSize], TileRowSize);
+	}
+
+	if (++TileX < NumTilesX)
+	{
+		return;
+	}
+
+	if (std::fwrite(Strip.data(), StripRowSize, Size.y, File) != static_cast<size_t>(Size.y))
+	{
+		std::cout << "Erro ao escrever " << Path << std::endl;
+		Finish();
+		return;
+	}
+
+	TileX = 0;
+	if (++TileY == NumTilesY)
+	{
+		std::cout << "Imagem salva em " << Path << std::endl;
+		Finish();
+	}
+}
+
+void TiledScreenshot::Finish()
+{
+	if (File)
+	{
+		std::fclose(File);
+		File = nullptr;
+	}
+
+	glDeleteFramebuffers(1, &FramebufferId);
+	glDeleteRenderbuffers(1, &DepthRenderbufferId);
+	glDeleteRenderbuffers(1, &ColorRenderbufferId);
+	FramebufferId = 0;
+	DepthRenderbufferId = 0;
+	ColorRenderbufferId = 0;
+
+	// Devolve a memória da faixa
+	std::vector<unsigned char>().swap(Strip);
+	std::vector<unsigned char>().swap(TilePixels);
+}
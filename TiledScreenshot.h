@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Imagens muito maiores que a janela (16k x 16k para impressão), desenhadas
+// em tiles. Cada tile usa um frustum descentralizado da câmera e é
+// desenhado num único framebuffer reaproveitado, lido de volta e copiado
+// para uma faixa com uma linha de tiles. A faixa é escrita no arquivo assim
+// que fica completa, então só ela ocupa memória, dentro do limite pedido.
+//
+// O arquivo é PPM binário (P6), que é gravado em ordem de cima para baixo
+// sem precisar da imagem inteira, ao contrário do PNG do stb_image_write.
+class TiledScreenshot
+{
+public:
+	// Abre o arquivo e escolhe o tamanho dos tiles para a faixa caber em MemoryBudget bytes
+	bool Begin(const std::string& Path, int ImageWidth, int ImageHeight, size_t MemoryBudget);
+
+	bool IsActive() const { return File != nullptr; }
+
+	glm::ivec2 GetImageSize() const { return { ImageWidth, ImageHeight }; }
+	float GetAspectRatio() const { return static_cast<float>(ImageWidth) / ImageHeight; }
+
+	// Tamanho do tile atual, menor nas bordas da imagem
+	glm::ivec2 GetTileSize() const;
+
+	// Região do tile atual em coordenadas normalizadas da imagem inteira
+	void GetTileBounds(glm::vec2& OutMin, glm::vec2& OutMax) const;
+
+	GLuint GetFramebuffer() const { return FramebufferId; }
+
+	// Lê o tile desenhado no framebuffer e passa para o próximo. Depois do
+	// último tile fecha o arquivo e libera o framebuffer.
+	void EndTile();
+
+private:
+	void Finish();
+
+	std::FILE* File = nullptr;
+	std::string Path;
+
+	int ImageWidth = 0;
+	int ImageHeight = 0;
+	int TileWidth = 0;
+	int TileHeight = 0;
+	int NumTilesX = 0;
+	int NumTilesY = 0;
+	int TileX = 0;
+	int TileY = 0;
+
+	// Uma linha de tiles em RGB, de cima para baixo
+	std::vector<unsigned char> Strip;
+	std::vector<unsigned char> TilePixels;
+
+	GLuint FramebufferId = 0;
+	GLuint ColorRenderbufferId = 0;
+	GLuint DepthRenderbufferId = 0;
+};
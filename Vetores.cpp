@@ -1,10 +1,21 @@
 
+#include <cstring>
 #include <iostream>
+#include <random>
+#include <vector>
 
+// No GCC e no Clang a glm s oferece os swizzles como membros (Point1.xxx)
+// com as intrnsecas ligadas; sem elas existem s as funes (Point1.xxx())
 #define GLM_FORCE_SWIZZLE
+#define GLM_FORCE_INTRINSICS
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_aligned.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "MathBenchmark.h"
+
 void Constructors()
 {
 	std::cout << std::endl;
@@ -61,7 +72,7 @@ void Operations()
 	// Comprimento
 	float L = glm::length(Point1);
 	// No confundir com a funo membro length
-	constexpr int C = Point1.length();
+	const int C = Point1.length();
 
 	// Norma
 	glm::vec3 Norm = glm::normalize(Point1);
@@ -82,12 +93,133 @@ void Operations()
 	glm::vec3 Reflect = glm::reflect(Point1, Norm);
 }
 
-int main()
+// As sadas dos trs caminhos ficam em vec4 com w zero para serem comparadas
+// da mesma forma; a glm com SIMD usa glm::aligned_vec4 e glm::aligned_vec3
+void RunVectorBenchmarks()
 {
-	Constructors();
-	Components();
-	Swizzles();
-	Operations();
+	std::mt19937 Random{ 42 };
+	std::uniform_real_distribution<float> Coordinate{ -100.0f, 100.0f };
+
+	std::vector<glm::vec3> Directions;
+	std::vector<glm::vec3> Others;
+	std::vector<glm::vec4> Centers;
+	std::vector<glm::aligned_vec4> AlignedDirections;
+	std::vector<glm::aligned_vec3> AlignedDirections3;
+	std::vector<glm::aligned_vec3> AlignedOthers;
+	std::vector<glm::aligned_vec4> AlignedCenters;
+	for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+	{
+		Directions.push_back(glm::vec3{ Coordinate(Random), Coordinate(Random), Coordinate(Random) });
+		Others.push_back(glm::vec3{ Coordinate(Random), Coordinate(Random), Coordinate(Random) });
+		Centers.push_back(glm::vec4{ Coordinate(Random), Coordinate(Random), Coordinate(Random), 1.0f });
+		AlignedDirections.push_back(glm::aligned_vec4{ Directions.back(), 0.0f });
+		AlignedDirections3.push_back(glm::aligned_vec3{ Directions.back() });
+		AlignedOthers.push_back(glm::aligned_vec3{ Others.back() });
+		AlignedCenters.push_back(glm::aligned_vec4{ Centers.back() });
+	}
+
+	const glm::mat4 View = glm::lookAt(glm::vec3{ 0.0f, 50.0f, 300.0f }, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+	const glm::aligned_mat4 AlignedView{ View };
+
+	std::vector<glm::vec4> GlmResults(BenchmarkBatchSize, glm::vec4{ 0.0f });
+	std::vector<glm::aligned_vec4> AlignedResults(BenchmarkBatchSize, glm::aligned_vec4{ 0.0f });
+	std::vector<glm::vec4> SimdResults(BenchmarkBatchSize, glm::vec4{ 0.0f });
+
+	std::cout << "Lotes de " << BenchmarkBatchSize << " vetores, melhor de " << BenchmarkRounds << " rodadas, uma thread" << std::endl;
+	std::cout << "SimdMath compilado com " << GetSimdMathPath() << std::endl;
+
+	CompareMathPaths("normalize", 4,
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				GlmResults[Index] = glm::vec4{ glm::normalize(Directions[Index]), 0.0f };
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				AlignedResults[Index] = glm::normalize(AlignedDirections[Index]);
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				NormalizeVector3(glm::value_ptr(Directions[Index]), glm::value_ptr(SimdResults[Index]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+
+	CompareMathPaths("cross", 4,
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				GlmResults[Index] = glm::vec4{ glm::cross(Directions[Index], Others[Index]), 0.0f };
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				AlignedResults[Index] = glm::aligned_vec4{ glm::cross(AlignedDirections3[Index], AlignedOthers[Index]), 0.0f };
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				CrossVector3(glm::value_ptr(Directions[Index]), glm::value_ptr(Others[Index]), glm::value_ptr(SimdResults[Index]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+
+	// O centro de cada corpo levado para o espao da cmera, como no culling
+	CompareMathPaths("mat4 x vec4 (View * Centro)", 4,
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				GlmResults[Index] = View * Centers[Index];
+			}
+			return glm::value_ptr(GlmResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				AlignedResults[Index] = AlignedView * AlignedCenters[Index];
+			}
+			return glm::value_ptr(AlignedResults[0]);
+		},
+		[&]()
+		{
+			for (size_t Index = 0; Index < BenchmarkBatchSize; ++Index)
+			{
+				TransformVector(glm::value_ptr(View), glm::value_ptr(Centers[Index]), glm::value_ptr(SimdResults[Index]));
+			}
+			return glm::value_ptr(SimdResults[0]);
+		});
+}
 
+int main(int argc, char** argv)
+{
+	// Os exemplos de antes continuam com --exemplos
+	if (argc > 1 && std::strcmp(argv[1], "--exemplos") == 0)
+	{
+		Constructors();
+		Components();
+		Swizzles();
+		Operations();
+		return 0;
+	}
+
+	RunVectorBenchmarks();
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,563 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include "FrameArena.h"
+
+bool VirtualTextureCache::IsSupported()
+{
+	// Shader storage buffers, glClearBufferData e glTexStorage
+	return GLEW_VERSION_4_3 != 0;
+}
+
+void VirtualTextureCache::Create()
+{
+	Textures.reserve(MaxTextures);
+	Slots.assign(AtlasTilesPerSide * AtlasTilesPerSide, AtlasSlot{});
+
+	// Sem mips: cada nível da textura virtual é um tile diferente no atlas,
+	// e a borda dos tiles cobre a filtragem bilinear
+	constexpr int AtlasSize = AtlasTilesPerSide * VirtualTextureFormat::PaddedTileSize;
+	glGenTextures(1, &AtlasTextureId);
+	glBindTexture(GL_TEXTURE_2D, AtlasTextureId);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, AtlasSize, AtlasSize);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Uma camada por textura virtual e um mip por nível: cada texel é um tile,
+	// com o slot no atlas em xy, o nível do tile no atlas em z e residência em w
+	glGenTextures(1, &PageTableTextureId);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, PageTableTextureId);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, NumPageTableLevels, GL_RGBA8, MaxPageTableSize, MaxPageTableSize, MaxTextures);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenBuffers(1, &FeedbackBufferId);
+	glGenBuffers(NumReadbackBuffers, ReadbackBuffers);
+
+	LoadQueue.reserve(MaxQueuedLoads);
+	LoadedTiles.reserve(MaxQueuedLoads);
+	UploadingTiles.reserve(MaxQueuedLoads);
+
+	bStopLoader = false;
+	Loader = std::thread(&VirtualTextureCache::LoaderLoop, this);
+}
+
+void VirtualTextureCache::Release()
+{
+	if (Loader.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(LoaderMutex);
+			bStopLoader = true;
+		}
+		LoaderCondition.notify_all();
+		Loader.join();
+	}
+	LoadQueue.clear();
+	for (const TileLoad& Load : LoadedTiles)
+	{
+		TileBuffers.Free(Load.Pixels);
+	}
+	LoadedTiles.clear();
+
+	for (GLsync& Fence : ReadbackFences)
+	{
+		if (Fence)
+		{
+			glDeleteSync(Fence);
+			Fence = nullptr;
+		}
+	}
+
+	glDeleteBuffers(NumReadbackBuffers, ReadbackBuffers);
+	glDeleteBuffers(1, &FeedbackBufferId);
+	glDeleteTextures(1, &PageTableTextureId);
+	glDeleteTextures(1, &AtlasTextureId);
+
+	std::fill(std::begin(ReadbackBuffers), std::end(ReadbackBuffers), 0);
+	FeedbackBufferId = 0;
+	PageTableTextureId = 0;
+	AtlasTextureId = 0;
+	NumFeedbackWords = 0;
+	NextReadbackBuffer = 0;
+
+	Textures.clear();
+	Slots.clear();
+}
+
+int VirtualTextureCache::AddTexture(const char* FilePath)
+{
+	if (!IsEnabled() || Textures.size() >= MaxTextures)
+	{
+		return -1;
+	}
+
+	auto Texture = std::make_unique<VirtualTexture>();
+	if (!Texture->Pack.Open(FilePath))
+	{
+		std::cout << "Textura virtual nao encontrada: " << FilePath << std::endl;
+		return -1;
+	}
+
+	VirtualTextureHeader& Header = Texture->Header;
+	bool bValid = Texture->Pack.GetSize() >= sizeof(Header);
+	if (bValid)
+	{
+		std::memcpy(&Header, Texture->Pack.GetData(), sizeof(Header));
+		bValid = std::memcmp(Header.Magic, VirtualTextureFormat::Magic, sizeof(Header.Magic)) == 0 && Header.Version == VirtualTextureFormat::Version &&
+		         Header.TilesX > 0 && Header.TilesX <= MaxPageTableSize && Header.TilesY > 0 && Header.TilesY <= MaxPageTableSize &&
+		         Header.NumLevels > 0 && Header.NumLevels <= NumPageTableLevels;
+	}
+
+	if (bValid)
+	{
+		for (int Level = 0; Level <= static_cast<int>(Header.NumLevels); ++Level)
+		{
+			Texture->LevelFirstTile.push_back(GetVirtualLevelFirstTile(Header, Level));
+		}
+		bValid = Texture->Pack.GetSize() >= GetVirtualTileOffset(Texture->LevelFirstTile.back());
+	}
+
+	if (!bValid)
+	{
+		std::cout << "Pacote de textura virtual invalido: " << FilePath << std::endl;
+		return -1;
+	}
+
+	const uint32_t NumTiles = Texture->LevelFirstTile.back();
+	Texture->FirstFeedbackBit = Textures.empty() ? 0 : Textures.back()->FirstFeedbackBit + static_cast<uint32_t>(Textures.back()->TileSlots.size());
+	Texture->TileSlots.assign(NumTiles, -1);
+	Texture->bTilePending.assign(NumTiles, 0);
+	Texture->bPageTableDirty = true;
+
+	Textures.push_back(std::move(Texture));
+	const int TextureIndex = static_cast<int>(Textures.size()) - 1;
+	const VirtualTexture& Added = *Textures.back();
+
+	// Um bit por tile de todas as texturas; as leituras pendentes do tamanho
+	// antigo são descartadas
+	NumFeedbackWords = (Added.FirstFeedbackBit + NumTiles + 31) / 32;
+	const GLsizeiptr FeedbackSize = NumFeedbackWords * sizeof(uint32_t);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, FeedbackBufferId);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, FeedbackSize, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	for (int Buffer = 0; Buffer < NumReadbackBuffers; ++Buffer)
+	{
+		if (ReadbackFences[Buffer])
+		{
+			glDeleteSync(ReadbackFences[Buffer]);
+			ReadbackFences[Buffer] = nullptr;
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ReadbackBuffers[Buffer]);
+		glBufferData(GL_COPY_WRITE_BUFFER, FeedbackSize, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// O último nível fica sempre no atlas, então todo pixel tem o que amostrar
+	for (uint32_t Tile = Added.LevelFirstTile[Added.Header.NumLevels - 1]; Tile < NumTiles; ++Tile)
+	{
+		RequestTile(TextureIndex, Tile);
+	}
+
+	std::cout << "Textura virtual " << FilePath << ": " << Added.Header.TilesX * VirtualTextureFormat::TileSize << "x" << Added.Header.TilesY * VirtualTextureFormat::TileSize
+	          << ", " << Added.Header.NumLevels << " niveis, " << NumTiles << " tiles" << std::endl;
+
+	return TextureIndex;
+}
+
+void VirtualTextureCache::Update()
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	++FrameIndex;
+
+	CollectFeedback();
+	UploadLoadedTiles();
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, PageTableTextureId);
+	for (size_t TextureIndex = 0; TextureIndex < Textures.size(); ++TextureIndex)
+	{
+		if (Textures[TextureIndex]->bPageTableDirty)
+		{
+			UpdatePageTable(static_cast<int>(TextureIndex));
+			Textures[TextureIndex]->bPageTableDirty = false;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if (NumFeedbackWords > 0)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, FeedbackBufferId);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
+
+void VirtualTextureCache::Bind(GLuint ProgramId) const
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	// x, y: tiles no nível 0, z: número de níveis, w: primeiro bit de feedback
+	glm::ivec4 TextureInfo[MaxTextures] = {};
+	for (size_t TextureIndex = 0; TextureIndex < Textures.size(); ++TextureIndex)
+	{
+		const VirtualTexture& Texture = *Textures[TextureIndex];
+		TextureInfo[TextureIndex] = glm::ivec4{ glm::uvec4{ Texture.Header.TilesX, Texture.Header.TilesY, Texture.Header.NumLevels, Texture.FirstFeedbackBit } };
+	}
+
+	glUniform1i(glGetUniformLocation(ProgramId, "VirtualAtlas"), AtlasTextureUnit);
+	glUniform1i(glGetUniformLocation(ProgramId, "PageTables"), PageTableTextureUnit);
+	glUniform4iv(glGetUniformLocation(ProgramId, "VirtualTextureInfo"), MaxTextures, &TextureInfo[0].x);
+
+	// Só um pixel de cada bloco 4x4 escreve o feedback, um diferente a cada frame
+	glUniform1i(glGetUniformLocation(ProgramId, "FeedbackPhase"), static_cast<GLint>(FrameIndex % 16));
+
+	const GLuint FeedbackBlockIndex = glGetProgramResourceIndex(ProgramId, GL_SHADER_STORAGE_BLOCK, "FeedbackBlock");
+	if (FeedbackBlockIndex != GL_INVALID_INDEX)
+	{
+		glShaderStorageBlockBinding(ProgramId, FeedbackBlockIndex, FeedbackBinding);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, FeedbackBinding, FeedbackBufferId);
+
+	glActiveTexture(GL_TEXTURE0 + AtlasTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, AtlasTextureId);
+	glActiveTexture(GL_TEXTURE0 + PageTableTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, PageTableTextureId);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void VirtualTextureCache::EndFrame()
+{
+	if (!IsEnabled() || NumFeedbackWords == 0)
+	{
+		return;
+	}
+
+	// Se a leitura mais antiga ainda não chegou, o feedback deste frame é
+	// descartado em vez de esperar a GPU
+	const int Buffer = NextReadbackBuffer;
+	if (ReadbackFences[Buffer])
+	{
+		return;
+	}
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, FeedbackBufferId);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ReadbackBuffers[Buffer]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, NumFeedbackWords * sizeof(uint32_t));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	ReadbackFences[Buffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	NextReadbackBuffer = (Buffer + 1) % NumReadbackBuffers;
+}
+
+PoolCounters VirtualTextureCache::GetTileBufferCounters()
+{
+	std::lock_guard<std::mutex> Lock(LoaderMutex);
+	return TileBuffers.GetCounters();
+}
+
+void VirtualTextureCache::CollectFeedback()
+{
+	// Da leitura mais antiga para a mais nova, parando na primeira que a GPU
+	// ainda não terminou
+	for (int Offset = 0; Offset < NumReadbackBuffers; ++Offset)
+	{
+		const int Buffer = (NextReadbackBuffer + Offset) % NumReadbackBuffers;
+		GLsync& Fence = ReadbackFences[Buffer];
+		if (!Fence)
+		{
+			continue;
+		}
+
+		const GLenum WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (WaitResult != GL_ALREADY_SIGNALED && WaitResult != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		glDeleteSync(Fence);
+		Fence = nullptr;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, ReadbackBuffers[Buffer]);
+		if (const void* FeedbackBits = glMapBufferRange(GL_COPY_READ_BUFFER, 0, NumFeedbackWords * sizeof(uint32_t), GL_MAP_READ_BIT))
+		{
+			ProcessFeedback(static_cast<const uint32_t*>(FeedbackBits));
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+}
+
+void VirtualTextureCache::ProcessFeedback(const uint32_t* FeedbackBits)
+{
+	for (uint32_t Word = 0; Word < NumFeedbackWords; ++Word)
+	{
+		if (FeedbackBits[Word] == 0)
+		{
+			continue;
+		}
+
+		for (uint32_t BitIndex = 0; BitIndex < 32; ++BitIndex)
+		{
+			if ((FeedbackBits[Word] & (1u << BitIndex)) == 0)
+			{
+				continue;
+			}
+
+			const uint32_t Bit = Word * 32 + BitIndex;
+			for (size_t TextureIndex = 0; TextureIndex < Textures.size(); ++TextureIndex)
+			{
+				const VirtualTexture& Texture = *Textures[TextureIndex];
+				if (Bit >= Texture.FirstFeedbackBit && Bit < Texture.FirstFeedbackBit + Texture.TileSlots.size())
+				{
+					RequestTileAndAncestors(static_cast<int>(TextureIndex), Bit - Texture.FirstFeedbackBit);
+					break;
+				}
+			}
+		}
+	}
+}
+
+void VirtualTextureCache::RequestTileAndAncestors(int TextureIndex, uint32_t Tile)
+{
+	const VirtualTexture& Texture = *Textures[TextureIndex];
+	const int NumLevels = static_cast<int>(Texture.Header.NumLevels);
+
+	int Level = 0;
+	while (Level + 1 < NumLevels && Tile >= Texture.LevelFirstTile[Level + 1])
+	{
+		++Level;
+	}
+
+	const int LevelTilesX = GetVirtualLevelTiles(Texture.Header, Level).x;
+	const int TileInLevel = static_cast<int>(Tile - Texture.LevelFirstTile[Level]);
+	glm::ivec2 TileCoord{ TileInLevel % LevelTilesX, TileInLevel / LevelTilesX };
+
+	uint32_t Chain[NumPageTableLevels];
+	int ChainLength = 0;
+	for (; Level < NumLevels; ++Level)
+	{
+		Chain[ChainLength++] = Texture.LevelFirstTile[Level] + TileCoord.y * GetVirtualLevelTiles(Texture.Header, Level).x + TileCoord.x;
+		TileCoord /= 2;
+	}
+
+	// Os níveis menos detalhados primeiro, para a fila não ficar com buracos
+	// que caem direto no último nível
+	while (ChainLength > 0)
+	{
+		RequestTile(TextureIndex, Chain[--ChainLength]);
+	}
+}
+
+void VirtualTextureCache::RequestTile(int TextureIndex, uint32_t Tile)
+{
+	VirtualTexture& Texture = *Textures[TextureIndex];
+
+	const int Slot = Texture.TileSlots[Tile];
+	if (Slot >= 0)
+	{
+		Slots[Slot].LastUsedFrame = FrameIndex;
+		return;
+	}
+
+	if (Texture.bTilePending[Tile])
+	{
+		return;
+	}
+
+	{
+		// O limite conta os pedidos na fila e os tiles com buffer do pool, que
+		// estão sendo copiados ou esperando o envio; assim o pool e os vetores
+		// não passam de MaxQueuedLoads e não alocam durante os frames. Cheio:
+		// o tile volta no feedback dos próximos frames
+		std::lock_guard<std::mutex> Lock(LoaderMutex);
+		if (LoadQueue.size() + TileBuffers.GetCounters().NumAllocated >= MaxQueuedLoads)
+		{
+			return;
+		}
+		LoadQueue.push_back({ TextureIndex, Tile, Texture.Pack.GetData() + GetVirtualTileOffset(Tile), nullptr });
+	}
+	Texture.bTilePending[Tile] = 1;
+	LoaderCondition.notify_one();
+}
+
+void VirtualTextureCache::UploadLoadedTiles()
+{
+	std::vector<TileLoad>& Loaded = UploadingTiles;
+	{
+		std::lock_guard<std::mutex> Lock(LoaderMutex);
+		Loaded.swap(LoadedTiles);
+	}
+
+	if (Loaded.empty())
+	{
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, AtlasTextureId);
+
+	size_t LoadIndex = 0;
+	for (; LoadIndex < Loaded.size() && LoadIndex < MaxUploadsPerFrame; ++LoadIndex)
+	{
+		TileLoad& Load = Loaded[LoadIndex];
+		VirtualTexture& Texture = *Textures[Load.Texture];
+		Texture.bTilePending[Load.Tile] = 0;
+
+		// Atlas cheio de tiles em uso: descarta e deixa o feedback pedir de novo
+		const int Slot = AllocateSlot();
+		if (Slot < 0)
+		{
+			continue;
+		}
+
+		const glm::ivec2 SlotCoord{ Slot % AtlasTilesPerSide, Slot / AtlasTilesPerSide };
+		glTexSubImage2D(GL_TEXTURE_2D, 0, SlotCoord.x * VirtualTextureFormat::PaddedTileSize, SlotCoord.y * VirtualTextureFormat::PaddedTileSize,
+		                VirtualTextureFormat::PaddedTileSize, VirtualTextureFormat::PaddedTileSize, GL_RGBA, GL_UNSIGNED_BYTE, Load.Pixels);
+
+		AtlasSlot& NewSlot = Slots[Slot];
+		NewSlot.Texture = Load.Texture;
+		NewSlot.Tile = Load.Tile;
+		NewSlot.LastUsedFrame = FrameIndex;
+		NewSlot.bPinned = Load.Tile >= Texture.LevelFirstTile[Texture.Header.NumLevels - 1];
+
+		Texture.TileSlots[Load.Tile] = static_cast<int16_t>(Slot);
+		Texture.bPageTableDirty = true;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Os enviados devolvem o buffer, e o que passou do limite do frame vai
+	// na frente dos próximos
+	{
+		std::lock_guard<std::mutex> Lock(LoaderMutex);
+		for (size_t UploadedIndex = 0; UploadedIndex < LoadIndex; ++UploadedIndex)
+		{
+			TileBuffers.Free(Loaded[UploadedIndex].Pixels);
+		}
+		LoadedTiles.insert(LoadedTiles.begin(), Loaded.begin() + LoadIndex, Loaded.end());
+	}
+	Loaded.clear();
+}
+
+int VirtualTextureCache::AllocateSlot()
+{
+	// Um slot livre, ou o usado há mais tempo entre os que não foram pedidos
+	// neste frame
+	int Oldest = -1;
+	for (int SlotIndex = 0; SlotIndex < static_cast<int>(Slots.size()); ++SlotIndex)
+	{
+		const AtlasSlot& Slot = Slots[SlotIndex];
+		if (Slot.Texture < 0)
+		{
+			return SlotIndex;
+		}
+
+		if (!Slot.bPinned && Slot.LastUsedFrame < FrameIndex && (Oldest < 0 || Slot.LastUsedFrame < Slots[Oldest].LastUsedFrame))
+		{
+			Oldest = SlotIndex;
+		}
+	}
+
+	if (Oldest >= 0)
+	{
+		VirtualTexture& Owner = *Textures[Slots[Oldest].Texture];
+		Owner.TileSlots[Slots[Oldest].Tile] = -1;
+		Owner.bPageTableDirty = true;
+		Slots[Oldest] = AtlasSlot{};
+	}
+
+	return Oldest;
+}
+
+void VirtualTextureCache::UpdatePageTable(int TextureIndex)
+{
+	const VirtualTexture& Texture = *Textures[TextureIndex];
+
+	// Do último nível para o primeiro: um tile fora do atlas herda a entrada
+	// do pai, que já aponta para o ancestral mais próximo no atlas. Os dois
+	// níveis em montagem ficam na arena do frame, com o tamanho do nível 0.
+	const glm::ivec2 FirstLevelTiles = GetVirtualLevelTiles(Texture.Header, 0);
+	const size_t MaxEntries = static_cast<size_t>(FirstLevelTiles.x) * FirstLevelTiles.y;
+	glm::u8vec4* Entries = GetFrameArena().AllocateArray<glm::u8vec4>(MaxEntries);
+	glm::u8vec4* ParentEntries = GetFrameArena().AllocateArray<glm::u8vec4>(MaxEntries);
+	bool bHasParent = false;
+	glm::ivec2 ParentTiles{ 0 };
+
+	for (int Level = static_cast<int>(Texture.Header.NumLevels) - 1; Level >= 0; --Level)
+	{
+		const glm::ivec2 Tiles = GetVirtualLevelTiles(Texture.Header, Level);
+		std::fill(Entries, Entries + static_cast<size_t>(Tiles.x) * Tiles.y, glm::u8vec4{ 0 });
+
+		for (int TileY = 0; TileY < Tiles.y; ++TileY)
+		{
+			for (int TileX = 0; TileX < Tiles.x; ++TileX)
+			{
+				glm::u8vec4& Entry = Entries[TileY * Tiles.x + TileX];
+				const int Slot = Texture.TileSlots[Texture.LevelFirstTile[Level] + TileY * Tiles.x + TileX];
+				if (Slot >= 0)
+				{
+					Entry = glm::u8vec4{ Slot % AtlasTilesPerSide, Slot / AtlasTilesPerSide, Level, 255 };
+				}
+				else if (bHasParent)
+				{
+					Entry = ParentEntries[(TileY / 2) * ParentTiles.x + TileX / 2];
+				}
+			}
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, Level, 0, 0, TextureIndex, Tiles.x, Tiles.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, Entries);
+
+		std::swap(ParentEntries, Entries);
+		bHasParent = true;
+		ParentTiles = Tiles;
+	}
+}
+
+void VirtualTextureCache::LoaderLoop()
+{
+	for (;;)
+	{
+		TileLoad Load;
+		{
+			std::unique_lock<std::mutex> Lock(LoaderMutex);
+			LoaderCondition.wait(Lock, [this] { return bStopLoader || !LoadQueue.empty(); });
+			if (bStopLoader)
+			{
+				return;
+			}
+			// A fila tem no máximo MaxQueuedLoads pedidos, então tirar da
+			// frente do vetor custa pouco
+			Load = LoadQueue.front();
+			LoadQueue.erase(LoadQueue.begin());
+			Load.Pixels = static_cast<unsigned char*>(TileBuffers.Allocate());
+		}
+
+		// A cópia é o que faz o sistema ler as páginas do arquivo, fora da
+		// thread de renderização
+		std::memcpy(Load.Pixels, Load.Source, VirtualTextureFormat::TileBytes);
+
+		std::lock_guard<std::mutex> Lock(LoaderMutex);
+		LoadedTiles.push_back(Load);
+	}
+}
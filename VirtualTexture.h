@@ -0,0 +1,140 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MappedFile.h"
+#include "PoolAllocator.h"
+#include "VirtualTextureFormat.h"
+
+// Mapas de planetas maiores que a memória de vídeo, gerados pelo
+// BuildVirtualTexture. Só os tiles que aparecem na tela ficam na GPU, num
+// atlas de tamanho fixo compartilhado por todas as texturas virtuais.
+//
+// O fragment shader marca num bitset (shader storage buffer) os tiles que
+// gostaria de amostrar. O bitset é lido de volta alguns frames depois, sem
+// esperar a GPU, e os tiles que faltam são copiados do pacote mapeado na
+// memória por uma thread de carregamento. Quando o atlas enche, o tile usado
+// há mais tempo dá lugar ao novo. A tabela de páginas de cada textura aponta
+// os tiles que faltam para o ancestral mais próximo que está no atlas.
+//
+// Precisa de OpenGL 4.3. Sem isso os corpos usam só a texture array.
+class VirtualTextureCache
+{
+public:
+	static constexpr int MaxTextures = 4;
+
+	// 32x32 tiles de 136x136 texels em RGBA8, cerca de 75 MB
+	static constexpr int AtlasTilesPerSide = 32;
+
+	// Em tiles no nível 0, o que dá mapas de até 64k x 64k texels
+	static constexpr int MaxPageTableSize = 512;
+	static constexpr int NumPageTableLevels = 10;
+
+	static constexpr int MaxUploadsPerFrame = 16;
+	static constexpr size_t MaxQueuedLoads = 64;
+	static constexpr int NumReadbackBuffers = 3;
+
+	// Unidades de textura e ponto de ligação do buffer de feedback
+	static constexpr GLuint AtlasTextureUnit = 2;
+	static constexpr GLuint PageTableTextureUnit = 3;
+	static constexpr GLuint FeedbackBinding = 1;
+
+	static bool IsSupported();
+
+	void Create();
+	void Release();
+
+	// Abre um pacote .bmvt. Retorna o índice da textura ou -1 se o pacote não
+	// existe ou é inválido.
+	int AddTexture(const char* FilePath);
+
+	bool IsEnabled() const { return AtlasTextureId != 0; }
+
+	// Chamado no começo do frame: lê o feedback que já chegou, envia para a
+	// GPU os tiles carregados e atualiza as tabelas de páginas
+	void Update();
+
+	// Liga o atlas, as tabelas e o feedback para um programa com VIRTUAL_TEXTURE
+	void Bind(GLuint ProgramId) const;
+
+	// Chamado depois dos draws que usam as texturas virtuais
+	void EndFrame();
+
+	// Buffers dos tiles que estão entre a thread de carregamento e o atlas
+	PoolCounters GetTileBufferCounters();
+
+private:
+	struct VirtualTexture
+	{
+		MappedFile Pack;
+		VirtualTextureHeader Header;
+		std::vector<uint32_t> LevelFirstTile;
+		uint32_t FirstFeedbackBit;
+
+		// Slot do atlas de cada tile, -1 se não está no atlas
+		std::vector<int16_t> TileSlots;
+		std::vector<uint8_t> bTilePending;
+		bool bPageTableDirty;
+	};
+
+	struct TileLoad
+	{
+		int Texture;
+		uint32_t Tile;
+		const unsigned char* Source;
+
+		// Bloco de TileBuffers, nulo até a thread de carregamento copiar o tile
+		unsigned char* Pixels;
+	};
+
+	struct AtlasSlot
+	{
+		int Texture = -1;
+		uint32_t Tile = 0;
+		uint64_t LastUsedFrame = 0;
+		bool bPinned = false;
+	};
+
+	void RequestTile(int Texture, uint32_t Tile);
+	void RequestTileAndAncestors(int Texture, uint32_t Tile);
+	void ProcessFeedback(const uint32_t* FeedbackBits);
+	void CollectFeedback();
+	void UploadLoadedTiles();
+	int AllocateSlot();
+	void UpdatePageTable(int Texture);
+	void LoaderLoop();
+
+	std::vector<std::unique_ptr<VirtualTexture>> Textures;
+	std::vector<AtlasSlot> Slots;
+	uint64_t FrameIndex = 0;
+
+	GLuint AtlasTextureId = 0;
+	GLuint PageTableTextureId = 0;
+
+	GLuint FeedbackBufferId = 0;
+	uint32_t NumFeedbackWords = 0;
+	GLuint ReadbackBuffers[NumReadbackBuffers] = {};
+	GLsync ReadbackFences[NumReadbackBuffers] = {};
+	int NextReadbackBuffer = 0;
+
+	// Pedidos para a thread de carregamento e tiles já copiados do pacote.
+	// Os pixels ficam em blocos do TileBuffers, que só é usado com o
+	// LoaderMutex travado; UploadingTiles troca de lugar com LoadedTiles a
+	// cada frame, e os dois mantêm a capacidade. Os pedidos na fila mais os
+	// blocos em uso nunca passam de MaxQueuedLoads.
+	std::mutex LoaderMutex;
+	std::condition_variable LoaderCondition;
+	std::vector<TileLoad> LoadQueue;
+	std::vector<TileLoad> LoadedTiles;
+	std::vector<TileLoad> UploadingTiles;
+	PoolAllocator TileBuffers{ VirtualTextureFormat::TileBytes, MaxQueuedLoads };
+	bool bStopLoader = false;
+	std::thread Loader;
+};
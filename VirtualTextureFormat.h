@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Formato do pacote de uma textura virtual: um VirtualTextureHeader seguido
+// dos tiles de todos os níveis da pirâmide de mips, do nível 0 (mais
+// detalhado) até o último, cada nível em ordem de linhas. Todos os tiles têm
+// o mesmo tamanho, então a posição de um tile no arquivo é calculada sem
+// índice e o pacote pode ser mapeado na memória e lido tile a tile.
+namespace VirtualTextureFormat
+{
+	constexpr char Magic[4] = { 'B', 'M', 'V', 'T' };
+	constexpr uint32_t Version = 1;
+
+	// Texels úteis de cada tile, mais uma borda copiada dos vizinhos para a
+	// filtragem bilinear não misturar tiles que não são vizinhos no atlas
+	constexpr int TileSize = 128;
+	constexpr int TileBorder = 4;
+	constexpr int PaddedTileSize = TileSize + 2 * TileBorder;
+
+	// RGBA8
+	constexpr size_t TileBytes = static_cast<size_t>(PaddedTileSize) * PaddedTileSize * 4;
+}
+
+struct VirtualTextureHeader
+{
+	char Magic[4];
+	uint32_t Version;
+
+	// Em tiles no nível 0. O tiler garante que são potências de 2.
+	uint32_t TilesX;
+	uint32_t TilesY;
+	uint32_t NumLevels;
+	uint32_t Reserved[3];
+};
+
+static_assert(sizeof(VirtualTextureHeader) == 32, "VirtualTextureHeader precisa ter 32 bytes");
+
+inline glm::ivec2 GetVirtualLevelTiles(const VirtualTextureHeader& Header, int Level)
+{
+	return glm::max(glm::ivec2{ static_cast<int>(Header.TilesX) >> Level, static_cast<int>(Header.TilesY) >> Level }, glm::ivec2{ 1 });
+}
+
+// Índice do primeiro tile do nível, contando os tiles de todos os níveis anteriores
+inline uint32_t GetVirtualLevelFirstTile(const VirtualTextureHeader& Header, int Level)
+{
+	uint32_t FirstTile = 0;
+	for (int PreviousLevel = 0; PreviousLevel < Level; ++PreviousLevel)
+	{
+		const glm::ivec2 Tiles = GetVirtualLevelTiles(Header, PreviousLevel);
+		FirstTile += static_cast<uint32_t>(Tiles.x * Tiles.y);
+	}
+	return FirstTile;
+}
+
+inline size_t GetVirtualTileOffset(uint32_t TileIndex)
+{
+	return sizeof(VirtualTextureHeader) + static_cast<size_t>(TileIndex) * VirtualTextureFormat::TileBytes;
+}
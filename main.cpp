@@ -1,222 +1,243 @@
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <glm/gtx/string_cast.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include "deps/stb/stb_image.h"
+#include "AllocationCounter.h"
+#include "AssetPack.h"
+#include "AsteroidField.h"
+#include "Atmosphere.h"
+#include "BodyTransforms.h"
 #include "Camera.h"
+#include "Culling.h"
+#include "DepthPyramid.h"
+#include "FileWatcher.h"
+#include "FrameArena.h"
+#include "FrameCapture.h"
+#include "IndirectDraw.h"
+#include "Mesh.h"
+#include "OrbitTrails.h"
+#include "PlanetRings.h"
+#include "PlanetTerrain.h"
+#include "PostProcess.h"
+#include "RingBuffer.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "ShaderData.h"
+#include "Skybox.h"
+#include "SpscQueue.h"
+#include "StarCatalog.h"
+#include "Texture.h"
+#include "TiledScreenshot.h"
+#include "VirtualTexture.h"
 
 int Width = 800;
 int Height = 600;
 
-struct Vertex
-{
-	glm::vec3 Position;
-	glm::vec3 Normal;
-	glm::vec3 Color;
-	glm::vec2 UV;
-};
-
-struct Triangle
-{
-	GLuint V0;
-	GLuint V1;
-	GLuint V2;
-};
-
-struct DirectionalLight
-{
-	glm::vec3 Direction;
-	GLfloat Intensity;
-};
+// Cena relida quando o arquivo é salvo
+const char* SceneFile = "scenes/sistema_solar.json";
 
 SimpleCamera Camera;
 
-void GenerateSphere(GLuint Resolution, std::vector<Vertex>& Vertices, std::vector<Triangle>& Indices)
+// Estrelas mais fracas que essa magnitude não são desenhadas
+float StarMagnitudeLimit = 6.5f;
+
+// O que é desenhado nas órbitas, trocado com a tecla O
+namespace EOrbitDisplay
 {
-	Vertices.clear();
-	Indices.clear();
+	enum Type : int
+	{
+		Trails,
+		Predicted,
+		Hidden,
+		Count
+	};
+}
+int OrbitDisplay = EOrbitDisplay::Trails;
 
-	constexpr float Pi = glm::pi<float>();
-	constexpr float TwoPi = glm::two_pi<float>();
-	float InvResolution = 1.0f / static_cast<float>(Resolution - 1);
+// Cena em HDR com bloom e tonemapping, trocado com a tecla H
+bool bPostProcess = true;
 
-	for (GLuint UIndex = 0; UIndex < Resolution; ++UIndex)
-	{
-		const float U = UIndex * InvResolution;
-		const float Theta = glm::mix(0.0f, TwoPi, static_cast<float>(U));
+// Captura dos frames para vídeo, ligada e desligada com a tecla C. A cena é
+// renderizada em CaptureWidth x CaptureHeight enquanto captura.
+bool bCapturing = false;
+constexpr int CaptureWidth = 1920;
+constexpr int CaptureHeight = 1080;
 
-		for (GLuint VIndex = 0; VIndex < Resolution; ++VIndex)
-		{
-			const float V = VIndex * InvResolution;
-			const float Phi = glm::mix(0.0f, Pi, static_cast<float>(V));
+// Imagem em alta resolução renderizada em tiles, pedida com a tecla P
+bool bPosterRequested = false;
+constexpr int PosterSize = 16384;
+constexpr size_t PosterMemoryBudget = 64 * 1024 * 1024;
 
-			glm::vec3 VertexPosition =
-			{
-				glm::cos(Theta) * glm::sin(Phi),
-				glm::sin(Theta) * glm::sin(Phi),
-				glm::cos(Phi)
-			};
+// Uso da arena do frame, dos pools e do heap, impresso uma vez por segundo
+// com a tecla M
+bool bMemoryStats = false;
 
-			glm::vec3 VertexNormal = glm::normalize(VertexPosition);
+// Distância, em raios do planeta, em que a esfera dá lugar ao terreno
+constexpr float TerrainDistance = 4.0f;
 
-			Vertices.push_back(Vertex{
-				VertexPosition,
-				VertexNormal,
-				glm::vec3{ 1.0f, 1.0f, 1.0f },
-				glm::vec2{ 1.0f - U, 1.0f - V }
-			});
-		}
-	}
+// Igual ao deslocamento da textura da superfície no triangle_frag.glsl
+constexpr double SurfaceScrollSpeed = 0.008;
 
-	for (GLuint U = 0; U < Resolution - 1; ++U)
+// Aponta os atributos 4 a 15 para os dados por instância que começam em
+// BaseOffset no buffer ligado em GL_ARRAY_BUFFER
+void SetInstanceAttributes(GLintptr BaseOffset)
+{
+	for (GLuint Column = 0; Column < 4; ++Column)
 	{
-		for (GLuint V = 0; V < Resolution - 1; ++V)
-		{
-			GLuint P0 = U + V * Resolution;
-			GLuint P1 = U + 1 + V * Resolution;
-			GLuint P2 = U + (V + 1) * Resolution;
-			GLuint P3 = U + 1 + (V + 1) * Resolution;
-
-			Indices.push_back(Triangle{ P3, P2, P0 });
-			Indices.push_back(Triangle{ P1, P3, P0 });
-		}
+		const GLintptr ColumnOffset = BaseOffset + Column * sizeof(glm::vec4);
+		glVertexAttribPointer(4 + Column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(ColumnOffset + offsetof(InstanceData, ModelViewMatrix)));
+		glVertexAttribPointer(8 + Column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(ColumnOffset + offsetof(InstanceData, ModelViewProjection)));
 	}
-}
 
-std::string ReadFile(const char* FilePath)
-{
-	std::string FileContents;
-	if (std::ifstream FileStream{ FilePath, std::ios::in })
+	for (GLuint Column = 0; Column < 3; ++Column)
 	{
-		FileContents.assign((std::istreambuf_iterator<char>(FileStream)), std::istreambuf_iterator<char>());
+		const GLintptr ColumnOffset = BaseOffset + Column * sizeof(glm::vec4);
+		glVertexAttribPointer(12 + Column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(ColumnOffset + offsetof(InstanceData, NormalMatrix)));
 	}
-	return FileContents;
+
+	glVertexAttribPointer(15, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(BaseOffset + offsetof(InstanceData, TextureLayers)));
 }
 
-void CheckShader(GLuint ShaderId)
+// Bytes de um frame no ring buffer com NumBodies corpos: o InstanceData e o
+// CullInput de cada um, SphereLOD::Count comandos de draw por corpo (no pior
+// caso cada corpo é uma variante), o FrameUniforms, a instância do terreno e a
+// folga dos alinhamentos das cinco reservas. O ring buffer multiplica pelos
+// frames em voo.
+GLsizeiptr GetFrameRingBufferSize(size_t NumBodies, GLint MaxAlignment)
 {
-	// Verificar se o shader foi compilado
-	GLint Result = GL_TRUE;
-	glGetShaderiv(ShaderId, GL_COMPILE_STATUS, &Result);
+	const size_t BytesPerBody = sizeof(InstanceData) + sizeof(CullInput) + SphereLOD::Count * sizeof(DrawElementsIndirectCommand);
+	const size_t FixedBytes = sizeof(FrameUniforms) + sizeof(InstanceData) + 5 * static_cast<size_t>(MaxAlignment);
+	return static_cast<GLsizeiptr>(NumBodies * BytesPerBody + FixedBytes);
+}
 
-	if (Result == GL_FALSE)
+// Texture array com uma camada para cada textura da cena. A capacidade é
+// arredondada para a próxima potência de dois, então acrescentar texturas na
+// cena durante o hot reload só recria a array quando ela enche. Retorna 0 se
+// alguma textura não pode ser carregada
+GLuint LoadSceneTextures(const SceneDesc& Scene)
+{
+	std::vector<const char*> TextureFiles;
+	for (const std::string& TextureFile : Scene.TextureFiles)
 	{
-		// Erro ao compilar o shader, imprimir o log para saber o que est� errado
-		GLint InfoLogLength = 0;
-		glGetShaderiv(ShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
-
-		std::string ShaderInfoLog(InfoLogLength, '\0');
-		glGetShaderInfoLog(ShaderId, InfoLogLength, nullptr, &ShaderInfoLog[0]);
-
-		if (InfoLogLength > 0)
-		{
-			std::cout << "Erro no Vertex Shader: " << std::endl;
-			std::cout << ShaderInfoLog << std::endl;
+		TextureFiles.push_back(TextureFile.c_str());
+	}
 
-			assert(false);
-		}
+	size_t LayerCapacity = 1;
+	while (LayerCapacity < TextureFiles.size())
+	{
+		LayerCapacity *= 2;
 	}
+	return LoadTextureArray(TextureFiles.data(), TextureFiles.size(), LayerCapacity);
 }
 
-GLuint LoadShaders(const char* VertexShaderFile, const char* FragmentShaderFile)
+// Comandos enviados pela thread de eventos da janela para a thread de
+// renderização, que é a única que mexe na câmera e no estado do OpenGL.
+// São só os eventos discretos; o cursor, o tamanho da janela e as teclas de
+// movimento são estados e vão nos LatestVec2 abaixo.
+namespace ERenderCommand
 {
-	// Criar os identificadores de cada um dos shaders
-	GLuint VertShaderId = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-
-	std::string VertexShaderSource = ReadFile(VertexShaderFile);
-	std::string FragmentShaderSource = ReadFile(FragmentShaderFile);
+	enum Type : int
+	{
+		BeginMouseLook,
+		EndMouseLook,
+		ChangeStarMagnitudeLimit,
+		CycleOrbitDisplay,
+		TogglePostProcess,
+		ToggleCapture,
+		RenderPoster,
+		ToggleMemoryStats
+	};
+}
 
-	assert(!VertexShaderSource.empty());
-	assert(!FragmentShaderSource.empty());
+struct RenderCommand
+{
+	ERenderCommand::Type Type;
+	glm::vec2 Value;
+};
 
-	std::cout << "Compilando " << VertexShaderFile << std::endl;
-	const char* VertexShaderSourcePtr = VertexShaderSource.c_str();
-	glShaderSource(VertShaderId, 1, &VertexShaderSourcePtr, nullptr);
-	glCompileShader(VertShaderId);
-	CheckShader(VertShaderId);
+SpscQueue<RenderCommand, 1024> RenderCommands;
 
-	std::cout << "Compilando " << FragmentShaderFile << std::endl;
-	const char* FragmentShaderSourcePtr = FragmentShaderSource.c_str();
-	glShaderSource(FragShaderId, 1, &FragmentShaderSourcePtr, nullptr);
-	glCompileShader(FragShaderId);
-	CheckShader(FragShaderId);
+// A fila enche quando a thread de renderização fica parada, por exemplo
+// carregando texturas na inicialização. Os comandos que não couberam esperam
+// aqui, na ordem, e entram na fila assim que houver espaço. Só a thread de
+// eventos mexe neste vetor.
+std::vector<RenderCommand> PendingRenderCommands;
 
-	std::cout << "Linkando Programa" << std::endl;
-	GLuint ProgramId = glCreateProgram();
-	glAttachShader(ProgramId, VertShaderId);
-	glAttachShader(ProgramId, FragShaderId);
-	glLinkProgram(ProgramId);
+// Retorna true se todos os comandos pendentes entraram na fila
+bool FlushRenderCommands()
+{
+	size_t NumFlushed = 0;
+	while (NumFlushed < PendingRenderCommands.size() && RenderCommands.Push(PendingRenderCommands[NumFlushed]))
+	{
+		++NumFlushed;
+	}
+	PendingRenderCommands.erase(PendingRenderCommands.begin(), PendingRenderCommands.begin() + NumFlushed);
+	return PendingRenderCommands.empty();
+}
 
-	// Verificar o programa
-	GLint Result = GL_TRUE;
-	glGetProgramiv(ProgramId, GL_LINK_STATUS, &Result);
+void PushRenderCommand(ERenderCommand::Type Type, const glm::vec2& Value = glm::vec2{ 0.0f })
+{
+	const RenderCommand Command{ Type, Value };
+	if (!FlushRenderCommands() || !RenderCommands.Push(Command))
+	{
+		PendingRenderCommands.push_back(Command);
+	}
+}
 
-	if (Result == GL_FALSE)
+// Último valor de um estado contínuo escrito pela thread de eventos. Os
+// valores intermediários que a thread de renderização não chegou a ler são
+// substituídos, então uma rajada de movimentos do mouse nunca enche nada e o
+// estado final, como soltar uma tecla, nunca se perde.
+class LatestVec2
+{
+public:
+	void Store(const glm::vec2& Value)
 	{
-		GLint InfoLogLength = 0;
-		glGetProgramiv(ProgramId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+		uint64_t NewBits;
+		std::memcpy(&NewBits, &Value, sizeof(NewBits));
+		Bits.store(NewBits, std::memory_order_release);
+	}
 
-		if (InfoLogLength > 0)
+	// Retorna false se nada mudou desde o último Take
+	bool Take(glm::vec2& OutValue)
+	{
+		const uint64_t OldBits = Bits.exchange(Empty, std::memory_order_acquire);
+		if (OldBits == Empty)
 		{
-			std::string ProgramInfoLog(InfoLogLength, '\0');
-			glGetProgramInfoLog(ProgramId, InfoLogLength, nullptr, &ProgramInfoLog[0]);
-
-			std::cout << "Erro ao linkar programa" << std::endl;
-			std::cout << ProgramInfoLog << std::endl;
-
-			assert(false);
+			return false;
 		}
+		std::memcpy(&OutValue, &OldBits, sizeof(OldBits));
+		return true;
 	}
 
-	glDetachShader(ProgramId, VertShaderId);
-	glDetachShader(ProgramId, FragShaderId);
-
-	glDeleteShader(VertShaderId);
-	glDeleteShader(FragShaderId);
-
-	return ProgramId;
-}
+private:
+	// Dois NaN, que nunca são escritos
+	static constexpr uint64_t Empty = ~0ull;
+	std::atomic<uint64_t> Bits{ Empty };
+};
 
-GLuint LoadTexture(const char* TextureFile)
-{
-	std::cout << "Carregando Textura " << TextureFile << std::endl;
-
-	int TextureWidth = 0;
-	int TextureHeight = 0;
-	int NumberOfComponents = 0;
-	unsigned char* TextureData = stbi_load(TextureFile, &TextureWidth, &TextureHeight, &NumberOfComponents, 3);
-	assert(TextureData);
-
-	// Gerar o Identifador da Textura
-	GLuint TextureId;
-	glGenTextures(1, &TextureId);
-
-	// Habilita a textura para ser modificada
-	glBindTexture(GL_TEXTURE_2D, TextureId);
-
-	// Copia a textura para a memória da GPU
-	GLint Level = 0;
-	GLint Border = 0;
-	glTexImage2D(GL_TEXTURE_2D, Level, GL_RGB, TextureWidth, TextureHeight, Border, GL_RGB, GL_UNSIGNED_BYTE, TextureData);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	stbi_image_free(TextureData);
-	return TextureId;
-}
+// Velocidade pedida pelas teclas W/S em x e A/D em y, posição do cursor e
+// tamanho da janela. MoveState é a cópia da thread de eventos.
+glm::vec2 MoveState{ 0.0f };
+LatestVec2 MoveInput;
+LatestVec2 CursorInput;
+LatestVec2 ResizeInput;
 
 void MouseButtonCallback(GLFWwindow* Window, int Button, int Action, int Modifiers)
 {
@@ -231,14 +252,18 @@ void MouseButtonCallback(GLFWwindow* Window, int Button, int Action, int Modifie
 			double X, Y;
 			glfwGetCursorPos(Window, &X, &Y);
 
-			Camera.PreviousCursor = glm::vec2{ X, Y };
-			Camera.bEnableMouseMovement = true;
+			PushRenderCommand(ERenderCommand::BeginMouseLook, glm::vec2{ X, Y });
 		}
 		else if (Action == GLFW_RELEASE)
 		{
 			glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 
-			Camera.bEnableMouseMovement = false;
+			// O movimento até soltar o botão conta, mesmo que a posição final
+			// do cursor só seja lida depois deste comando
+			double X, Y;
+			glfwGetCursorPos(Window, &X, &Y);
+
+			PushRenderCommand(ERenderCommand::EndMouseLook, glm::vec2{ X, Y });
 		}
 	}
 }
@@ -246,7 +271,7 @@ void MouseButtonCallback(GLFWwindow* Window, int Button, int Action, int Modifie
 void MouseMotionCallback(GLFWwindow* Window, double X, double Y)
 {
 	// std::cout << "X: " << X << " Y: " << Y << std::endl;
-	Camera.MouseMove(X, Y);
+	CursorInput.Store(glm::vec2{ X, Y });
 }
 
 void KeyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, int Modifers)
@@ -262,19 +287,51 @@ void KeyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, int Modi
 				break;
 
 			case GLFW_KEY_W:
-				Camera.MoveForward(50.0f);
+				MoveState.x = 50.0f;
+				MoveInput.Store(MoveState);
 				break;
 
 			case GLFW_KEY_S:
-				Camera.MoveForward(-50.0f);
+				MoveState.x = -50.0f;
+				MoveInput.Store(MoveState);
 				break;
 
 			case GLFW_KEY_A:
-				Camera.MoveRight(-50.0f);
+				MoveState.y = -50.0f;
+				MoveInput.Store(MoveState);
 				break;
 
 			case GLFW_KEY_D:
-				Camera.MoveRight(50.0f);
+				MoveState.y = 50.0f;
+				MoveInput.Store(MoveState);
+				break;
+
+			case GLFW_KEY_EQUAL:
+				PushRenderCommand(ERenderCommand::ChangeStarMagnitudeLimit, glm::vec2{ 0.5f, 0.0f });
+				break;
+
+			case GLFW_KEY_MINUS:
+				PushRenderCommand(ERenderCommand::ChangeStarMagnitudeLimit, glm::vec2{ -0.5f, 0.0f });
+				break;
+
+			case GLFW_KEY_O:
+				PushRenderCommand(ERenderCommand::CycleOrbitDisplay);
+				break;
+
+			case GLFW_KEY_H:
+				PushRenderCommand(ERenderCommand::TogglePostProcess);
+				break;
+
+			case GLFW_KEY_C:
+				PushRenderCommand(ERenderCommand::ToggleCapture);
+				break;
+
+			case GLFW_KEY_P:
+				PushRenderCommand(ERenderCommand::RenderPoster);
+				break;
+
+			case GLFW_KEY_M:
+				PushRenderCommand(ERenderCommand::ToggleMemoryStats);
 				break;
 
 			default:
@@ -290,19 +347,15 @@ void KeyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, int Modi
 				break;
 
 			case GLFW_KEY_W:
-				Camera.MoveForward(0.0f);
-				break;
-
 			case GLFW_KEY_S:
-				Camera.MoveForward(0.0f);
+				MoveState.x = 0.0f;
+				MoveInput.Store(MoveState);
 				break;
 
 			case GLFW_KEY_A:
-				Camera.MoveRight(0.0f);
-				break;
-
 			case GLFW_KEY_D:
-				Camera.MoveRight(0.0f);
+				MoveState.y = 0.0f;
+				MoveInput.Store(MoveState);
 				break;
 
 			default:
@@ -312,45 +365,99 @@ void KeyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, int Modi
 }
 
 void Resize(GLFWwindow* Window, int NewWidth, int NewHeight) {
-	Width = NewWidth;
-	Height = NewHeight;
-
-	Camera.AspectRatio = static_cast<float>(Width) / Height;
-	glViewport(0, 0, Width, Height);
+	ResizeInput.Store(glm::vec2{ NewWidth, NewHeight });
 }
 
-int main()
+// Aplica os comandos e os estados que chegaram desde o último frame. Só pode
+// ser chamado pela thread de renderização.
+void ApplyRenderCommands()
 {
-	if (!glfwInit())
+	glm::vec2 Value;
+	if (MoveInput.Take(Value))
 	{
-		std::cout << "Erro ao inicializar o GLFW" << std::endl;
-		return 1;
+		Camera.MoveForward(Value.x);
+		Camera.MoveRight(Value.y);
 	}
 
-	glfwWindowHint(GLFW_DEPTH_BITS, 32);
+	if (ResizeInput.Take(Value))
+	{
+		Width = static_cast<int>(Value.x);
+		Height = static_cast<int>(Value.y);
 
-	GLFWwindow* Window = glfwCreateWindow(Width, Height, "Blue Marble", nullptr, nullptr);
+		Camera.AspectRatio = static_cast<float>(Width) / Height;
+		glViewport(0, 0, Width, Height);
+	}
 
-	if (!Window)
+	RenderCommand Command;
+	while (RenderCommands.Pop(Command))
 	{
-		std::cout << "Erro ao criar janela" << std::endl;
-		glfwTerminate();
-		return 1;
+		switch (Command.Type)
+		{
+			case ERenderCommand::BeginMouseLook:
+				Camera.PreviousCursor = Command.Value;
+				Camera.bEnableMouseMovement = true;
+				break;
+
+			case ERenderCommand::EndMouseLook:
+				Camera.MouseMove(Command.Value.x, Command.Value.y);
+				Camera.bEnableMouseMovement = false;
+				break;
+
+			case ERenderCommand::ChangeStarMagnitudeLimit:
+				StarMagnitudeLimit = glm::clamp(StarMagnitudeLimit + Command.Value.x, -1.0f, 21.0f);
+				break;
+
+			case ERenderCommand::CycleOrbitDisplay:
+				OrbitDisplay = (OrbitDisplay + 1) % EOrbitDisplay::Count;
+				break;
+
+			case ERenderCommand::TogglePostProcess:
+				bPostProcess = !bPostProcess;
+				break;
+
+			case ERenderCommand::ToggleCapture:
+				bCapturing = !bCapturing;
+				break;
+
+			case ERenderCommand::RenderPoster:
+				bPosterRequested = true;
+				break;
+
+			case ERenderCommand::ToggleMemoryStats:
+				bMemoryStats = !bMemoryStats;
+				break;
+
+			default:
+				break;
+		}
 	}
 
-	glfwSetMouseButtonCallback(Window, MouseButtonCallback);
-	glfwSetCursorPosCallback(Window, MouseMotionCallback);
-	glfwSetKeyCallback(Window, KeyCallback);
-	glfwSetFramebufferSizeCallback(Window, Resize);
+	// Todos os movimentos do frame viram um só, a partir do último cursor aplicado
+	if (CursorInput.Take(Value))
+	{
+		Camera.MouseMove(Value.x, Value.y);
+	}
+}
 
+// Pede para a thread de eventos encerrar, acordando-a se estiver esperando
+void StopEventLoop(GLFWwindow* Window)
+{
+	glfwSetWindowShouldClose(Window, true);
+	glfwPostEmptyEvent();
+}
+
+// Dona do contexto do OpenGL: carrega tudo, desenha os frames e libera os
+// recursos quando a janela é fechada
+void RunRenderer(GLFWwindow* Window)
+{
 	glfwMakeContextCurrent(Window);
 	glfwSwapInterval(1);
 
 	if (glewInit() != GLEW_OK)
 	{
 		std::cout << "Erro ao inicializar o GLEW" << std::endl;
-		glfwTerminate();
-		return 1;
+		StopEventLoop(Window);
+		return;
 	}
 
 	GLint GLMajorVersion = 0;
@@ -363,6 +470,19 @@ int main()
 	std::cout << "OpenGL Version  : " << glGetString(GL_VERSION) << std::endl;
 	std::cout << "GLSL Version    : " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 
+	// Com OpenGL emulado por software (llvmpipe, softpipe, SwiftShader) as
+	// cargas mais pesadas são reduzidas
+	const char* Renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	const bool bSoftwareRenderer = Renderer && (std::strstr(Renderer, "llvmpipe") || std::strstr(Renderer, "softpipe") || std::strstr(Renderer, "SwiftShader"));
+	bPostProcess = !bSoftwareRenderer;
+
+	// Deixa o driver compilar os shaders em paralelo, assim recarregar um
+	// shader durante a execução não trava o frame
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
 	// Habilita o Buffer de Profundidade
 	glEnable(GL_DEPTH_TEST);
 
@@ -372,40 +492,196 @@ int main()
 	glDisable(GL_CULL_FACE);
 	glEnable(GL_CULL_FACE);
 
-	// Compilar o vertex e o fragment shader
-	GLuint ProgramId = LoadShaders("shaders/triangle_vert.glsl", "shaders/triangle_frag.glsl");
+	// Shaders, texturas e a malha da esfera saem do pacote gerado pelo
+	// BuildAssetPack quando ele existe, senão dos arquivos soltos
+	AssetPack::Get().Open("assets.bmpak");
 
-	// Gera a Geometria da esfera e copia os dados para a GPU 
+	SceneDesc Scene;
+	if (!LoadScene(SceneFile, Scene))
+	{
+		AssetPack::Get().Close();
+		StopEventLoop(Window);
+		return;
+	}
+
+	// O vertex e o fragment shader são compilados sob demanda, uma variante
+	// para cada combinação de features usada pelos corpos
+	ShaderPermutations Shaders{ "shaders/triangle_vert.glsl", "shaders/triangle_frag.glsl" };
+	ShaderPermutations AsteroidShaders{ "shaders/asteroid_vert.glsl", "shaders/asteroid_frag.glsl" };
+	ShaderPermutations RingShaders{ "shaders/ring_vert.glsl", "shaders/ring_frag.glsl" };
+	ShaderPermutations SkyShaders{ "shaders/sky_vert.glsl", "shaders/sky_frag.glsl" };
+	ShaderPermutations StarShaders{ "shaders/star_vert.glsl", "shaders/star_frag.glsl" };
+	ShaderPermutations OrbitShaders{ "shaders/orbit_vert.glsl", "shaders/orbit_frag.glsl" };
+	ShaderPermutations AtmosphereShaders{ "shaders/atmosphere_vert.glsl", "shaders/atmosphere_frag.glsl" };
+	ShaderPermutations BloomDownShaders{ "shaders/post_vert.glsl", "shaders/bloom_down_frag.glsl" };
+	ShaderPermutations BloomUpShaders{ "shaders/post_vert.glsl", "shaders/bloom_up_frag.glsl" };
+	ShaderPermutations TonemapShaders{ "shaders/post_vert.glsl", "shaders/tonemap_frag.glsl" };
+	ShaderPermutations* ReloadableShaders[] = { &Shaders, &AsteroidShaders, &RingShaders, &SkyShaders, &StarShaders, &OrbitShaders, &AtmosphereShaders,
+	                                            &BloomDownShaders, &BloomUpShaders, &TonemapShaders };
+
+	// Recompila os shaders quando algum arquivo da pasta shaders/ é salvo
+	FileWatcher ShaderWatcher{ "shaders" };
+	std::vector<std::string> ChangedShaderFiles;
+
+	FileWatcher SceneWatcher{ "scenes" };
+	std::vector<std::string> ChangedSceneFiles;
+
+	// Gera a Geometria da esfera em todos os níveis de detalhe, num único par
+	// de buffers, e copia os dados para a GPU. O pacote de assets já traz a
+	// malha pronta e ela é enviada direto da memória mapeada.
 	std::vector<Vertex> SphereVertices;
 	std::vector<Triangle> SphereIndices;
-	GenerateSphere(100, SphereVertices, SphereIndices);
+	MeshSection SphereSections[SphereLOD::Count];
+	const Vertex* SphereVertexData = nullptr;
+	const Triangle* SphereIndexData = nullptr;
+	size_t SphereVertexCount = 0;
+	size_t SphereTriangleCount = 0;
+
+	const AssetEntry* SphereMesh = AssetPack::Get().Find(AssetPackFormat::SphereMeshName);
+	if (SphereMesh && SphereMesh->Type == EAssetType::Mesh && SphereMesh->Dimensions[2] == SphereLOD::Count &&
+	    SphereMesh->Size == sizeof(SphereSections) + SphereMesh->Dimensions[0] * sizeof(Vertex) + SphereMesh->Dimensions[1] * sizeof(Triangle))
+	{
+		const unsigned char* MeshData = AssetPack::Get().GetData(*SphereMesh);
+		std::memcpy(SphereSections, MeshData, sizeof(SphereSections));
+		SphereVertexCount = SphereMesh->Dimensions[0];
+		SphereTriangleCount = SphereMesh->Dimensions[1];
+		SphereVertexData = reinterpret_cast<const Vertex*>(MeshData + sizeof(SphereSections));
+		SphereIndexData = reinterpret_cast<const Triangle*>(MeshData + sizeof(SphereSections) + SphereVertexCount * sizeof(Vertex));
+	}
+	else
+	{
+		std::vector<Vertex> LODVertices;
+		std::vector<Triangle> LODIndices;
+		for (int LOD = 0; LOD < SphereLOD::Count; ++LOD)
+		{
+			GenerateSphere(SphereLOD::Resolutions[LOD], LODVertices, LODIndices);
+			SphereSections[LOD] = AppendMesh(LODVertices, LODIndices, SphereVertices, SphereIndices);
+		}
+		SphereVertexData = SphereVertices.data();
+		SphereIndexData = SphereIndices.data();
+		SphereVertexCount = SphereVertices.size();
+		SphereTriangleCount = SphereIndices.size();
+	}
 	GLuint SphereVertexBuffer, SphereElementBuffer;
 	glGenBuffers(1, &SphereVertexBuffer);
 	glGenBuffers(1, &SphereElementBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, SphereVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, SphereVertices.size() * sizeof(Vertex), SphereVertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, SphereVertexCount * sizeof(Vertex), SphereVertexData, GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, SphereIndices.size() * sizeof(Triangle), SphereIndices.data(), GL_STATIC_DRAW);
-
-	// Criar uma fonte de luz direcional
-	DirectionalLight Light;
-	Light.Direction = glm::vec3(0.0f, 0.0f, -1.5f);
-	Light.Intensity = 1.5f;
-	
-
-	// Carregar a Textura para a Memoria de Vídeo
-	GLuint EarthTextureId = LoadTexture("textures/terra.jpg");
-	GLuint MercuryTextureId = LoadTexture("textures/mercurio.jpg");
-	GLuint VenusTextureId = LoadTexture("textures/venus.jpg");
-	GLuint MarsTextureId = LoadTexture("textures/marte.jpg");
-	GLuint JupterTextureId = LoadTexture("textures/jupiter.jpg");
-	GLuint SaturnTextureId = LoadTexture("textures/saturno.jpg");
-	GLuint UranusTextureId = LoadTexture("textures/urano.jpg");
-	GLuint NeptuneTextureId = LoadTexture("textures/netuno.jpg");
-	GLuint SunTextureId = LoadTexture("textures/sol.jpg");
-	GLuint MoonTextureId = LoadTexture("textures/lua.jpg");
-	GLuint EarthCloudsTextureId = LoadTexture("textures/terra_nuvens.jpg");
-	GLuint VenusCloudsTextureId = LoadTexture("textures/venus_nuvens.jpg");
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, SphereTriangleCount * sizeof(Triangle), SphereIndexData, GL_STATIC_DRAW);
+
+	// Carregar a Textura para a Memoria de Vídeo. Todas as texturas ficam numa
+	// única texture array para que um draw possa desenhar vários corpos.
+	GLuint BodyTexturesId = LoadSceneTextures(Scene);
+
+	Skybox MilkyWay;
+	MilkyWay.Create("textures/fundo_via_lactea.jpg");
+
+	// Catálogo gerado pelo ConvertStarCatalog. Abrir só mapeia o arquivo; as
+	// estrelas chegam na GPU aos poucos, das mais brilhantes para as mais fracas.
+	StarCatalog Stars;
+	Stars.Create("catalogs/stars.bin");
+
+	// Recursos de cada corpo que dependem da cena. Quando a cena é recarregada
+	// só os corpos que mudaram têm esses recursos refeitos.
+	size_t NumBodies = Scene.GetNumBodies();
+	std::vector<int> BodyVirtualTexture(NumBodies, -1);
+	std::vector<Atmosphere> BodyAtmospheres(NumBodies);
+	std::vector<PlanetRings> BodyRings(NumBodies);
+
+	// Mapas em alta resolução gerados pelo BuildVirtualTexture. São opcionais:
+	// sem o pacote, ou sem OpenGL 4.3, o corpo usa só a texture array. O cache
+	// não libera texturas, então cada arquivo é aberto uma única vez.
+	VirtualTextureCache VirtualTextures;
+	if (VirtualTextureCache::IsSupported())
+	{
+		VirtualTextures.Create();
+	}
+	std::unordered_map<std::string, int> VirtualTextureIndices;
+
+	auto CreateBodyResources = [&](size_t BodyIndex, uint32_t Changes)
+	{
+		if ((Changes & ESceneChange::VirtualTexture) && VirtualTextureCache::IsSupported())
+		{
+			const std::string& VirtualTextureFile = Scene.VirtualTextureFiles[BodyIndex];
+			auto It = VirtualTextureIndices.find(VirtualTextureFile);
+			if (It == VirtualTextureIndices.end())
+			{
+				It = VirtualTextureIndices.emplace(VirtualTextureFile, VirtualTextureFile.empty() ? -1 : VirtualTextures.AddTexture(VirtualTextureFile.c_str())).first;
+			}
+			BodyVirtualTexture[BodyIndex] = It->second;
+		}
+
+		if ((Changes & ESceneChange::Atmosphere) && Scene.Atmospheres[BodyIndex] >= 0)
+		{
+			BodyAtmospheres[BodyIndex].Create(Scene.AtmosphereDescs[Scene.Atmospheres[BodyIndex]]);
+		}
+
+		if ((Changes & ESceneChange::Rings) && Scene.Rings[BodyIndex] >= 0)
+		{
+			const RingsDesc& Rings = Scene.RingDescs[Scene.Rings[BodyIndex]];
+			BodyRings[BodyIndex].Create(Rings.InnerRadius, Rings.OuterRadius);
+		}
+	};
+
+	for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+	{
+		CreateBodyResources(BodyIndex, ESceneChange::All);
+	}
+
+	// Os planetas rochosos com "terrain" na cena ganham terreno para a
+	// aproximação. Sem mapa de altura o relevo é ruído.
+	PlanetTerrain Terrain;
+	Terrain.Create();
+
+	// Os corpos são agrupados por variante do shader e por nível de detalhe.
+	// Cada grupo vira um DrawElementsIndirectCommand, e cada variante um
+	// único glMultiDrawElementsIndirect.
+	std::vector<uint32_t> BodyShaderFeatures;
+	std::vector<glm::vec4> BodyTextureLayers;
+	std::vector<uint32_t> ShaderVariants;
+	std::vector<size_t> BodyVariant;
+	size_t NumDrawCommands = 0;
+	std::vector<DrawElementsIndirectCommand> DrawCommands;
+	constexpr GLuint InvalidDrawCommand = ~0u;
+	std::vector<glm::vec3> BodyOrbitPositions;
+
+	// Posição, rotação e escala dos corpos, de onde saem numa única passada
+	// as matrizes de modelo e os InstanceData
+	BodyTransforms Transforms;
+
+	// Elementos usados para desenhar as órbitas previstas. Órbitas em volta
+	// de outro corpo só têm o rastro.
+	std::vector<glm::vec4> OrbitElements;
+
+	AsteroidShaders.Get(EShaderFeature::None);
+	RingShaders.Get(EShaderFeature::None);
+	SkyShaders.Get(EShaderFeature::None);
+	StarShaders.Get(EShaderFeature::None);
+	OrbitShaders.Get(EShaderFeature::None);
+	OrbitShaders.Get(EShaderFeature::PredictedOrbit);
+
+	// Cinturões gerados a partir de distribuições dos elementos orbitais. A
+	// posição de cada asteroide é calculada no vertex shader.
+	const AsteroidBeltDesc AsteroidBelts[] =
+	{
+		// Cinturão principal, entre Marte e Júpiter
+		{ 85.0f, 95.0f, glm::radians(10.0f), 0.1f, 0.02f, 0.25f, 600000, 1 },
+		// Cinturão de Kuiper, depois de Netuno
+		{ 175.0f, 220.0f, glm::radians(20.0f), 0.15f, 0.03f, 0.4f, 400000, 2 },
+	};
+	AsteroidField Asteroids;
+	Asteroids.Create(AsteroidBelts, std::size(AsteroidBelts), bSoftwareRenderer ? 0.02f : 1.0f);
+
+	// As órbitas ficam no mesmo plano que as dos planetas
+	const glm::mat4 BeltMatrix = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
+
+	// Leva o plano das órbitas para o mundo e deixa os polos dos corpos em Y
+	const glm::quat OrbitPlaneRotation = glm::angleAxis(glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
+
+	// Rastro de todos os corpos com uma amostra a cada 50 ms
+	OrbitTrails Trails;
+	Trails.Create(static_cast<GLsizei>(NumBodies), 0.05);
 
 	// Configura a cor de fundo
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0);
@@ -438,481 +714,901 @@ int main()
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Color)));
 	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, UV)));
 
-	// Disabilitar o VAO
-	glBindVertexArray(0);
+	GLint UniformBufferAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &UniformBufferAlignment);
 
-	double PreviousTime = glfwGetTime();
+	// Com compute shader o culling e a escolha do nível de detalhe são feitos
+	// na GPU, que escreve as instâncias visíveis num buffer próprio
+	GpuCulling BodyCulling;
+	GLuint BodyCullingCapacity = static_cast<GLuint>(NumBodies * SphereLOD::Count);
+	BodyCulling.Create(BodyCullingCapacity);
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LESS);
+	GLint StorageBufferAlignment = 256;
+	if (BodyCulling.IsEnabled())
+	{
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &StorageBufferAlignment);
+	}
 
-	while (!glfwWindowShouldClose(Window))
+	// Matrizes de cada corpo e os dados do frame são escritos direto na memória
+	// mapeada do ring buffer, sem cópias intermediárias no driver. O tamanho
+	// acompanha o número de corpos e cresce no hot reload.
+	const GLint RingBufferAlignment = std::max({ UniformBufferAlignment, StorageBufferAlignment, static_cast<GLint>(sizeof(InstanceData)) });
+	PersistentRingBuffer FrameRingBuffer;
+	size_t FrameRingBufferBodies = NumBodies;
+	FrameRingBuffer.Create(GetFrameRingBufferSize(FrameRingBufferBodies, RingBufferAlignment));
+
+	// Refaz o que é derivado da cena no lado da CPU. É barato, então é
+	// refeito por inteiro a cada recarga.
+	auto BuildBodyState = [&]()
 	{
-		double CurrentTime = glfwGetTime();
-		double DeltaTime = CurrentTime - PreviousTime;
-		if (DeltaTime > 0.0)
+		NumBodies = Scene.GetNumBodies();
+
+		BodyShaderFeatures.resize(NumBodies);
+		BodyTextureLayers.resize(NumBodies);
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
 		{
-			Camera.Update(static_cast<float>(DeltaTime));
-			PreviousTime = CurrentTime;
+			BodyShaderFeatures[BodyIndex] = Scene.ShaderFeatures[BodyIndex] | (BodyVirtualTexture[BodyIndex] >= 0 ? EShaderFeature::VirtualTexture : EShaderFeature::None);
+			BodyTextureLayers[BodyIndex] = glm::vec4{ Scene.TextureLayers[BodyIndex], Scene.CloudsTextureLayers[BodyIndex], BodyVirtualTexture[BodyIndex] + 1, 0.0f };
 		}
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glUseProgram(ProgramId);
-
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~TERRA~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-
-		glm::mat4 ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixEarth = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixEarth = glm::translate(ModelMatrixEarth, glm::vec3(sin((float)CurrentTime) * 60.0, 0.0f, cos((float)CurrentTime) * 60.0));
-		ModelMatrixEarth = glm::scale(ModelMatrixEarth, glm::vec3(3.0f, 3.0f, 3.0f));
-		glm::mat4 NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixEarth));
-		glm::mat4 ModelViewMatrix = ViewMatrix * ModelMatrixEarth;
-		glm::mat4 ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixEarth;
-
-		GLint TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
-
-		GLint NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
-
-		GLint ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelViewMatrix));
-
-		GLint ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
-
-		GLint LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
-
-		glm::vec4 LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
-
-		GLint LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, EarthTextureId);
-
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, EarthCloudsTextureId);
-
-		GLint TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
-
-		GLint CloudsTextureSamplerLoc = glGetUniformLocation(ProgramId, "CloudsTexture");
-		glUniform1i(CloudsTextureSamplerLoc, 1);
-
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~MERCURIO~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixMercury = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixMercury = glm::translate(ModelMatrixMercury, glm::vec3(sin((float)CurrentTime * 0.5) * 20.0, 0.0f, cos((float)CurrentTime * 0.5) * 20.0));
-		ModelMatrixMercury = glm::scale(ModelMatrixMercury, glm::vec3(2.0f, 2.0f, 2.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixMercury));
-		ModelViewMatrix = ViewMatrix * ModelMatrixMercury;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixMercury;
-
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
-
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
-
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelViewMatrix));
-
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
-
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
-
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
-
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+		ShaderVariants.clear();
+		BodyVariant.resize(NumBodies);
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			auto It = std::find(ShaderVariants.begin(), ShaderVariants.end(), BodyShaderFeatures[BodyIndex]);
+			BodyVariant[BodyIndex] = It - ShaderVariants.begin();
+			if (It == ShaderVariants.end())
+			{
+				ShaderVariants.push_back(BodyShaderFeatures[BodyIndex]);
+			}
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, MercuryTextureId);
+		NumDrawCommands = ShaderVariants.size() * SphereLOD::Count;
+		DrawCommands.assign(NumDrawCommands, DrawElementsIndirectCommand{});
+		BodyOrbitPositions.resize(NumBodies);
+		Transforms.Resize(NumBodies);
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		OrbitElements.resize(NumBodies);
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			const bool bPredicted = Scene.OrbitSpeeds[BodyIndex] != 0.0f && Scene.Parents[BodyIndex] < 0;
+			OrbitElements[BodyIndex] = glm::vec4{ Scene.OrbitRadii[BodyIndex], bPredicted ? 1.0f : 0.0f };
+		}
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+		// Compila antes do próximo frame todas as variantes que serão usadas
+		for (uint32_t ShaderFeatures : ShaderVariants)
+		{
+			Shaders.Get(ShaderFeatures);
+		}
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			if (Scene.Terrains[BodyIndex] >= 0)
+			{
+				Shaders.Get(BodyShaderFeatures[BodyIndex] | EShaderFeature::Terrain);
+			}
+		}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (BodyCulling.IsEnabled())
+		{
+			// Os comandos são fixos: cada um reserva espaço para todos os corpos da
+			// sua variante e o compute shader só preenche o InstanceCount
+			GLuint NextInstance = 0;
+			for (size_t VariantIndex = 0; VariantIndex < ShaderVariants.size(); ++VariantIndex)
+			{
+				const GLuint VariantBodyCount = static_cast<GLuint>(std::count(BodyVariant.begin(), BodyVariant.end(), VariantIndex));
+				for (int LOD = 0; LOD < SphereLOD::Count; ++LOD)
+				{
+					const MeshSection& Section = SphereSections[LOD];
+					DrawCommands[VariantIndex * SphereLOD::Count + LOD] = { Section.IndexCount, 0, Section.FirstIndex, Section.BaseVertex, NextInstance };
+					NextInstance += VariantBodyCount;
+				}
+			}
+		}
+	};
+	BuildBodyState();
+
+	// O depth buffer de cada frame vira uma pirâmide de profundidade usada
+	// para descartar, no frame seguinte, os corpos escondidos atrás de outros
+	DepthPyramid OcclusionPyramid;
+	OcclusionPyramid.Create(Width, Height, !BodyCulling.IsEnabled());
+
+	PostProcess HdrPipeline;
+	HdrPipeline.Create(Width, Height);
+
+	// Sem BLUEMARBLE_ENCODER os frames capturados são salvos como PNG em captures/
+	FrameCapture Capture;
+	const char* EncoderCommand = std::getenv("BLUEMARBLE_ENCODER");
+
+	// Enquanto o pôster é renderizado cada frame desenha um tile, com a cena
+	// parada no instante em que ele foi pedido
+	TiledScreenshot Poster;
+	double PosterTime = 0.0;
+	float SavedBloomStrength = HdrPipeline.BloomStrength;
+
+	// Atributos por instância: avançam uma vez por instância em vez de por vértice
+	glBindBuffer(GL_ARRAY_BUFFER, BodyCulling.IsEnabled() ? BodyCulling.GetCulledInstanceBuffer() : FrameRingBuffer.GetBuffer());
+	for (GLuint Attribute = 4; Attribute <= 15; ++Attribute)
+	{
+		glEnableVertexAttribArray(Attribute);
+		glVertexAttribDivisor(Attribute, 1);
+	}
+	SetInstanceAttributes(0);
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~VENUS~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixVenus = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixVenus = glm::translate(ModelMatrixVenus, glm::vec3(sin((float)CurrentTime * 0.1) * 40.0, 0.0f, cos((float)CurrentTime * 0.1) * 40.0));
-		ModelMatrixVenus = glm::scale(ModelMatrixVenus, glm::vec3(3.0f, 3.0f, 3.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixVenus));
-		ModelViewMatrix = ViewMatrix * ModelMatrixVenus;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixVenus;
+	// O terreno lê a instância do planeta direto do ring buffer
+	glBindVertexArray(Terrain.GetVertexArray());
+	for (GLuint Attribute = 4; Attribute <= 15; ++Attribute)
+	{
+		glEnableVertexAttribArray(Attribute);
+		glVertexAttribDivisor(Attribute, 1);
+	}
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+	// Disabilitar o VAO
+	glBindVertexArray(0);
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+	// Recarrega a cena quando o arquivo é salvo. Os corpos são casados pelo
+	// nome, e os recursos na GPU dos corpos que não mudaram são mantidos.
+	auto ReloadScene = [&]()
+	{
+		SceneDesc NewScene;
+		if (!LoadScene(SceneFile, NewScene, &Scene))
+		{
+			std::cout << "Mantendo a cena anterior" << std::endl;
+			return;
+		}
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixVenus));
+		// As texturas mantêm as camadas entre as versões da cena, então só as
+		// camadas com outra textura são enviadas de novo e as texturas novas
+		// ocupam as camadas reservadas. A array só é recriada quando elas
+		// acabam ou quando veio comprimida do pacote de assets. Vem antes de
+		// qualquer outra mudança, porque uma imagem que some depois da leitura
+		// da cena ainda deixa manter a cena anterior
+		bool bReloadTextures = false;
+		bool bTexturesChanged = false;
+		for (size_t Layer = 0; !bReloadTextures && Layer < NewScene.TextureFiles.size(); ++Layer)
+		{
+			if (Layer >= Scene.TextureFiles.size() || NewScene.TextureFiles[Layer] != Scene.TextureFiles[Layer])
+			{
+				bReloadTextures = !UpdateTextureArrayLayer(BodyTexturesId, Layer, NewScene.TextureFiles[Layer].c_str());
+				bTexturesChanged = true;
+			}
+		}
+		if (bReloadTextures)
+		{
+			const GLuint NewTexturesId = LoadSceneTextures(NewScene);
+			if (NewTexturesId == 0)
+			{
+				// Devolve as camadas já trocadas para as texturas da cena anterior
+				for (size_t Layer = 0; Layer < std::min(Scene.TextureFiles.size(), NewScene.TextureFiles.size()); ++Layer)
+				{
+					if (NewScene.TextureFiles[Layer] != Scene.TextureFiles[Layer])
+					{
+						UpdateTextureArrayLayer(BodyTexturesId, Layer, Scene.TextureFiles[Layer].c_str());
+					}
+				}
+				GenerateTextureArrayMipmaps(BodyTexturesId);
+				std::cout << "Mantendo a cena anterior" << std::endl;
+				return;
+			}
+			glDeleteTextures(1, &BodyTexturesId);
+			BodyTexturesId = NewTexturesId;
+		}
+		else if (bTexturesChanged)
+		{
+			GenerateTextureArrayMipmaps(BodyTexturesId);
+		}
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+		const std::vector<SceneBodyChange> Changes = DiffScenes(Scene, NewScene);
+		const size_t NewNumBodies = NewScene.GetNumBodies();
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+		std::vector<int> NewVirtualTexture(NewNumBodies, -1);
+		std::vector<Atmosphere> NewAtmospheres(NewNumBodies);
+		std::vector<PlanetRings> NewRings(NewNumBodies);
+		std::vector<bool> bAtmosphereKept(NumBodies, false);
+		std::vector<bool> bRingsKept(NumBodies, false);
+		size_t NumChangedBodies = 0;
+		bool bResetTerrain = NewNumBodies != NumBodies;
+		bool bBodiesMoved = false;
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		for (size_t BodyIndex = 0; BodyIndex < NewNumBodies; ++BodyIndex)
+		{
+			const SceneBodyChange& Change = Changes[BodyIndex];
+			NumChangedBodies += Change.Changes != ESceneChange::None;
+			bBodiesMoved |= Change.PreviousIndex != static_cast<int>(BodyIndex);
+			bResetTerrain |= Change.PreviousIndex != static_cast<int>(BodyIndex) || (Change.Changes & ESceneChange::Terrain) != 0;
+			if (Change.PreviousIndex < 0)
+			{
+				continue;
+			}
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+			NewVirtualTexture[BodyIndex] = BodyVirtualTexture[Change.PreviousIndex];
+			if ((Change.Changes & ESceneChange::Atmosphere) == 0)
+			{
+				NewAtmospheres[BodyIndex] = BodyAtmospheres[Change.PreviousIndex];
+				bAtmosphereKept[Change.PreviousIndex] = true;
+			}
+			if ((Change.Changes & ESceneChange::Rings) == 0)
+			{
+				NewRings[BodyIndex] = BodyRings[Change.PreviousIndex];
+				bRingsKept[Change.PreviousIndex] = true;
+			}
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, VenusTextureId);
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			if (!bAtmosphereKept[BodyIndex])
+			{
+				BodyAtmospheres[BodyIndex].Release();
+			}
+			if (!bRingsKept[BodyIndex])
+			{
+				BodyRings[BodyIndex].Release();
+			}
+		}
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, VenusCloudsTextureId);
+		Scene = std::move(NewScene);
+		BodyVirtualTexture = std::move(NewVirtualTexture);
+		BodyAtmospheres = std::move(NewAtmospheres);
+		BodyRings = std::move(NewRings);
+		for (size_t BodyIndex = 0; BodyIndex < NewNumBodies; ++BodyIndex)
+		{
+			CreateBodyResources(BodyIndex, Changes[BodyIndex].PreviousIndex < 0 ? ESceneChange::All : Changes[BodyIndex].Changes);
+		}
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		// O terreno guarda o índice do corpo e o relevo dele
+		if (bResetTerrain)
+		{
+			Terrain.SetBody(-1, TerrainDesc{});
+		}
 
-		CloudsTextureSamplerLoc = glGetUniformLocation(ProgramId, "CloudsTexture");
-		glUniform1i(CloudsTextureSamplerLoc, 1);
+		// As amostras do rastro são guardadas pelo índice do corpo
+		if (NewNumBodies != NumBodies)
+		{
+			Trails.Release();
+			Trails.Create(static_cast<GLsizei>(NewNumBodies), 0.05);
+		}
+		else if (bBodiesMoved)
+		{
+			Trails.Clear();
+		}
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+		bool bInstanceBufferChanged = false;
+		if (NewNumBodies > FrameRingBufferBodies)
+		{
+			// Os frames em voo ainda leem o buffer antigo, que o driver só
+			// libera quando eles terminam
+			FrameRingBufferBodies = NewNumBodies;
+			FrameRingBuffer.Release();
+			FrameRingBuffer.Create(GetFrameRingBufferSize(FrameRingBufferBodies, RingBufferAlignment));
+			bInstanceBufferChanged = true;
+		}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (BodyCulling.IsEnabled() && NewNumBodies * SphereLOD::Count > BodyCullingCapacity)
+		{
+			BodyCullingCapacity = static_cast<GLuint>(NewNumBodies * SphereLOD::Count);
+			BodyCulling.Release();
+			BodyCulling.Create(BodyCullingCapacity);
+			bInstanceBufferChanged = true;
+		}
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~MARTE~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
+		if (bInstanceBufferChanged)
+		{
+			// Os atributos por instância do VAO apontavam para o buffer antigo
+			glBindVertexArray(SphereVAO);
+			glBindBuffer(GL_ARRAY_BUFFER, BodyCulling.IsEnabled() ? BodyCulling.GetCulledInstanceBuffer() : FrameRingBuffer.GetBuffer());
+			SetInstanceAttributes(0);
+			glBindVertexArray(0);
+		}
 
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixMars = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixMars = glm::translate(ModelMatrixMars, glm::vec3(sin((float)CurrentTime * 1.2) * 80.0, 0.0f, cos((float)CurrentTime * 1.2) * 80.0));
-		ModelMatrixMars = glm::scale(ModelMatrixMars, glm::vec3(2.0f, 2.0f, 2.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixMars));
-		ModelViewMatrix = ViewMatrix * ModelMatrixMars;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixMars;
+		BuildBodyState();
+		std::cout << "Cena recarregada, " << NumChangedBodies << " corpos mudaram" << std::endl;
+	};
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+	double PreviousTime = glfwGetTime();
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixMars));
+	// Os temporários do frame. Em regime o frame não aloca no heap, o que o
+	// build com BLUEMARBLE_COUNT_ALLOCATIONS confere com a tecla M.
+	LinearArena& FrameArena = GetFrameArena();
+	uint64_t MaxFrameAllocations = 0;
+	double LastMemoryStatsTime = PreviousTime;
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+	while (!glfwWindowShouldClose(Window))
+	{
+		const uint64_t FrameStartAllocations = GetThreadAllocationCount();
+		FrameArena.Reset();
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+		ApplyRenderCommands();
+		VirtualTextures.Update();
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		if (bPosterRequested && !Poster.IsActive())
+		{
+			const std::string PosterPath = "poster_" + std::to_string(std::time(nullptr)) + ".ppm";
+			if (Poster.Begin(PosterPath, PosterSize, PosterSize, PosterMemoryBudget))
+			{
+				PosterTime = glfwGetTime();
+				Camera.AspectRatio = Poster.GetAspectRatio();
+
+				// A pirâmide de um tile não vale para o seguinte, e o bloom
+				// é calculado por tile e deixaria as emendas visíveis
+				OcclusionPyramid.Invalidate();
+				SavedBloomStrength = HdrPipeline.BloomStrength;
+				HdrPipeline.BloomStrength = 0.0f;
+			}
+		}
+		bPosterRequested = false;
+		const bool bRenderingPoster = Poster.IsActive();
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+		// A captura desenha a cena no tamanho do vídeo, e não no da janela.
+		// O pôster tem prioridade: enquanto ele é renderizado nenhum frame é capturado.
+		if (!bRenderingPoster && bCapturing != Capture.IsCapturing())
+		{
+			if (bCapturing)
+			{
+				bCapturing = Capture.Start(CaptureWidth, CaptureHeight, "captures", EncoderCommand ? EncoderCommand : "");
+			}
+			else
+			{
+				Capture.Stop();
+			}
+		}
+		const bool bCapturingFrame = !bRenderingPoster && Capture.IsCapturing();
+		if (!bRenderingPoster)
+		{
+			Camera.AspectRatio = bCapturingFrame ? Capture.GetAspectRatio() : static_cast<float>(Width) / Height;
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, MarsTextureId);
+		double CurrentTime = glfwGetTime();
+		double DeltaTime = CurrentTime - PreviousTime;
+		if (DeltaTime > 0.0)
+		{
+			if (!bRenderingPoster)
+			{
+				Camera.Update(static_cast<float>(DeltaTime));
+			}
+			PreviousTime = CurrentTime;
+		}
+		if (bRenderingPoster)
+		{
+			CurrentTime = PosterTime;
+		}
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		ChangedShaderFiles.clear();
+		if (ShaderWatcher.Poll(ChangedShaderFiles))
+		{
+			for (ShaderPermutations* Permutations : ReloadableShaders)
+			{
+				for (const std::string& ChangedShaderFile : ChangedShaderFiles)
+				{
+					if (Permutations->UsesFile(ChangedShaderFile))
+					{
+						Permutations->Reload();
+						break;
+					}
+				}
+			}
+		}
+		for (ShaderPermutations* Permutations : ReloadableShaders)
+		{
+			Permutations->Update();
+		}
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+		ChangedSceneFiles.clear();
+		if (SceneWatcher.Poll(ChangedSceneFiles) && std::find(ChangedSceneFiles.begin(), ChangedSceneFiles.end(), SceneFile) != ChangedSceneFiles.end())
+		{
+			ReloadScene();
+		}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		// Cada tile do pôster e cada frame capturado são desenhados no
+		// framebuffer deles, no lugar da janela
+		glm::ivec2 RenderSize{ Width, Height };
+		GLuint TargetFramebuffer = 0;
+		if (bRenderingPoster)
+		{
+			RenderSize = Poster.GetTileSize();
+			TargetFramebuffer = Poster.GetFramebuffer();
+		}
+		else if (bCapturingFrame)
+		{
+			RenderSize = glm::ivec2{ Capture.GetWidth(), Capture.GetHeight() };
+			TargetFramebuffer = Capture.GetFramebuffer();
+		}
 
+		OcclusionPyramid.Resize(RenderSize.x, RenderSize.y);
+		HdrPipeline.Resize(RenderSize.x, RenderSize.y);
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~JUPITER~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixJupter = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixJupter = glm::translate(ModelMatrixJupter, glm::vec3(sin((float)CurrentTime * 2.4) * 100.0, 0.0f, cos((float)CurrentTime * 2.4) * 100.0));
-		ModelMatrixJupter = glm::scale(ModelMatrixJupter, glm::vec3(5.0f, 5.0f, 5.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixJupter));
-		ModelViewMatrix = ViewMatrix * ModelMatrixJupter;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixJupter;
+		if (bPostProcess)
+		{
+			HdrPipeline.BeginScene();
+		}
+		else
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, TargetFramebuffer);
+		}
+		glViewport(0, 0, RenderSize.x, RenderSize.y);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+		Stars.Stream(256 * 1024);
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+		glm::mat4 ViewMatrix = Camera.GetView();
+		glm::mat4 ViewProjectionMatrix = Camera.GetViewProjection();
+		if (bRenderingPoster)
+		{
+			glm::vec2 TileMin, TileMax;
+			Poster.GetTileBounds(TileMin, TileMax);
+			ViewProjectionMatrix = Camera.GetTileProjection(TileMin, TileMax) * ViewMatrix;
+		}
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixJupter));
+		FrameRingBuffer.BeginFrame();
+
+		// O ring buffer tem espaço para todos os corpos, mas se uma reserva
+		// falhar o que dependia dela fica de fora deste frame
+		GLintptr FrameUniformsOffset = 0;
+		FrameUniforms SpareFrame;
+		FrameUniforms* Frame = static_cast<FrameUniforms*>(FrameRingBuffer.Allocate(sizeof(FrameUniforms), UniformBufferAlignment, FrameUniformsOffset));
+		const bool bFrameAllocated = Frame != nullptr;
+		bool bDrawBodies = bFrameAllocated;
+		bool bDrawTerrain = bFrameAllocated;
+		if (!bFrameAllocated)
+		{
+			Frame = &SpareFrame;
+		}
+		Frame->ViewMatrix = ViewMatrix;
+		Frame->ViewProjectionMatrix = ViewProjectionMatrix;
+		Frame->LightIntensity = Scene.LightIntensity;
+		Frame->EmissiveIntensity = bPostProcess ? Scene.LightIntensity * 6.0f : Scene.LightIntensity;
+		Frame->Time = static_cast<float>(CurrentTime);
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+		const int ImageHeight = bRenderingPoster ? Poster.GetImageSize().y : RenderSize.y;
+		const float PixelsPerUnit = ImageHeight / (2.0f * glm::tan(Camera.FieldOfView * 0.5f));
+		const Frustum ViewFrustum = ExtractFrustum(ViewProjectionMatrix);
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			const glm::vec3& OrbitRadius = Scene.OrbitRadii[BodyIndex];
+			const float Angle = static_cast<float>(CurrentTime) * Scene.OrbitSpeeds[BodyIndex];
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+			// O pai vem antes na cena, então a posição dele já foi calculada
+			glm::vec3 OrbitPosition{ glm::sin(Angle) * OrbitRadius.x, OrbitRadius.y, glm::cos(Angle) * OrbitRadius.z };
+			if (Scene.Parents[BodyIndex] >= 0)
+			{
+				OrbitPosition += BodyOrbitPositions[Scene.Parents[BodyIndex]];
+			}
+			BodyOrbitPositions[BodyIndex] = OrbitPosition;
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+			Transforms.SetTransform(BodyIndex, OrbitPlaneRotation * OrbitPosition, OrbitPlaneRotation, Scene.Scales[BodyIndex]);
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, JupterTextureId);
+		Frame->LightPosition = ViewMatrix * glm::vec4{ Transforms.GetPosition(Scene.LightBody), 1.0f };
+		Frame->LightRadius = Scene.Scales[Scene.LightBody];
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		// Com mais corpos que MaxShadowOccluders fazem sombra os de superfície
+		// mais perto da câmera, que é onde os eclipses aparecem na tela, em
+		// ordem de distância. Os emissivos não fazem sombra.
+		float OccluderDistances[MaxShadowOccluders];
+		size_t OccluderBodies[MaxShadowOccluders];
+		int NumOccluders = 0;
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			if (Scene.ShaderFeatures[BodyIndex] & EShaderFeature::Emissive)
+			{
+				continue;
+			}
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+			const float Distance = glm::distance(Camera.Location, Transforms.GetPosition(BodyIndex)) - Scene.Scales[BodyIndex];
+			if (NumOccluders == MaxShadowOccluders && Distance >= OccluderDistances[MaxShadowOccluders - 1])
+			{
+				continue;
+			}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+			// Lista cheia: o mais distante sai
+			int Slot = NumOccluders < MaxShadowOccluders ? NumOccluders++ : MaxShadowOccluders - 1;
+			for (; Slot > 0 && OccluderDistances[Slot - 1] > Distance; --Slot)
+			{
+				OccluderDistances[Slot] = OccluderDistances[Slot - 1];
+				OccluderBodies[Slot] = OccluderBodies[Slot - 1];
+			}
+			OccluderDistances[Slot] = Distance;
+			OccluderBodies[Slot] = BodyIndex;
+		}
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~SATURNO~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixSaturn = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixSaturn = glm::translate(ModelMatrixSaturn, glm::vec3(sin((float)CurrentTime * 2) * 120.0, 0.0f, cos((float)CurrentTime * 2) * 120.0));
-		ModelMatrixSaturn = glm::scale(ModelMatrixSaturn, glm::vec3(4.0f, 4.0f, 4.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixSaturn));
-		ModelViewMatrix = ViewMatrix * ModelMatrixSaturn;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixSaturn;
+		Frame->NumOccluders = NumOccluders;
+		for (int Occluder = 0; Occluder < NumOccluders; ++Occluder)
+		{
+			const size_t BodyIndex = OccluderBodies[Occluder];
+			Frame->Occluders[Occluder] = glm::vec4{ glm::vec3(ViewMatrix * glm::vec4{ Transforms.GetPosition(BodyIndex), 1.0f }), Scene.Scales[BodyIndex] };
+		}
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+		// O planeta com terreno mais próximo da câmera, se ela estiver perto o
+		// bastante, é desenhado pelo terreno em vez da esfera
+		int TerrainBody = -1;
+		float TerrainBodyDistance = TerrainDistance;
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			const float Distance = glm::distance(Camera.Location, Transforms.GetPosition(BodyIndex)) / Scene.Scales[BodyIndex];
+			if (Scene.Terrains[BodyIndex] >= 0 && Distance < TerrainBodyDistance)
+			{
+				TerrainBody = static_cast<int>(BodyIndex);
+				TerrainBodyDistance = Distance;
+			}
+		}
+		Terrain.SetBody(TerrainBody, TerrainBody >= 0 ? Scene.TerrainDescs[Scene.Terrains[TerrainBody]] : TerrainDesc{});
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+		GLintptr TerrainInstanceOffset = 0;
+		if (TerrainBody >= 0)
+		{
+			// A esfera gira deslocando a textura; o terreno gira a geometria no
+			// mesmo ritmo, em volta do eixo dos polos
+			const float SurfaceAngle = static_cast<float>(glm::two_pi<double>() * std::fmod(SurfaceScrollSpeed * CurrentTime, 1.0));
+			const glm::mat4 TerrainModelMatrix = glm::rotate(Transforms.ComputeModelMatrix(TerrainBody), SurfaceAngle, glm::vec3{ 0.0f, 0.0f, 1.0f });
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixSaturn));
+			const glm::vec3 LocalCamera = glm::inverse(TerrainModelMatrix) * glm::vec4{ Camera.Location, 1.0f };
+			Terrain.Update(LocalCamera, ExtractFrustum(ViewProjectionMatrix * TerrainModelMatrix), PixelsPerUnit);
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+			InstanceData* TerrainInstance = static_cast<InstanceData*>(FrameRingBuffer.Allocate(sizeof(InstanceData), sizeof(glm::vec4), TerrainInstanceOffset));
+			bDrawTerrain = bDrawTerrain && TerrainInstance;
+			if (TerrainInstance)
+			{
+				WriteInstanceData(*TerrainInstance, BodyTextureLayers[TerrainBody], TerrainModelMatrix, ViewMatrix, ViewProjectionMatrix);
+			}
+		}
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+		GLintptr InstancesOffset = 0;
+		GLintptr CullInputsOffset = 0;
+		GLintptr DrawCommandsOffset = 0;
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		if (BodyCulling.IsEnabled())
+		{
+			// Todos os corpos vão para o ring buffer e o compute shader escolhe
+			// quais são desenhados e com qual nível de detalhe
+			InstanceData* Instances = static_cast<InstanceData*>(FrameRingBuffer.Allocate(NumBodies * sizeof(InstanceData), StorageBufferAlignment, InstancesOffset));
+			CullInput* CullInputs = static_cast<CullInput*>(FrameRingBuffer.Allocate(NumBodies * sizeof(CullInput), StorageBufferAlignment, CullInputsOffset));
+			void* DrawCommandsData = FrameRingBuffer.Allocate(NumDrawCommands * sizeof(DrawElementsIndirectCommand), StorageBufferAlignment, DrawCommandsOffset);
+			bDrawBodies = bDrawBodies && Instances && CullInputs && DrawCommandsData;
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+			// As matrizes de modelo são calculadas mesmo sem os corpos no frame
+			Transforms.Update(ViewMatrix, ViewProjectionMatrix, BodyTextureLayers.data(), bDrawBodies ? Instances : nullptr);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, SaturnTextureId);
+			for (size_t BodyIndex = 0; bDrawBodies && BodyIndex < NumBodies; ++BodyIndex)
+			{
+				// Raio zero tira do draw o corpo desenhado pelo terreno
+				CullInput& Input = CullInputs[BodyIndex];
+				Input.BoundingSphere = glm::vec4{ Transforms.GetPosition(BodyIndex), static_cast<int>(BodyIndex) == TerrainBody ? 0.0f : Scene.Scales[BodyIndex] };
+				Input.FirstCommand = static_cast<GLuint>(BodyVariant[BodyIndex] * SphereLOD::Count);
+			}
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+			if (bDrawBodies)
+			{
+				std::memcpy(DrawCommandsData, DrawCommands.data(), NumDrawCommands * sizeof(DrawElementsIndirectCommand));
+			}
+		}
+		else
+		{
+			// Descarta os corpos fora do frustum, escolhe o nível de detalhe pelo
+			// raio projetado na tela e conta quantos corpos caem em cada comando
+			for (DrawElementsIndirectCommand& Command : DrawCommands)
+			{
+				Command.InstanceCount = 0;
+			}
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+			// As listas do culling só valem neste frame
+			GLuint* BodyDrawCommand = FrameArena.AllocateArray<GLuint>(NumBodies);
+			uint32_t* BodyInstanceSlots = FrameArena.AllocateArray<uint32_t>(NumBodies);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+			GLuint NumVisibleBodies = 0;
+			for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+			{
+				const float Radius = Scene.Scales[BodyIndex];
+				const glm::vec3 Center = Transforms.GetPosition(BodyIndex);
+
+				if (static_cast<int>(BodyIndex) == TerrainBody || !IsSphereVisible(ViewFrustum, Center, Radius) || OcclusionPyramid.IsSphereOccluded(Center, Radius))
+				{
+					BodyDrawCommand[BodyIndex] = InvalidDrawCommand;
+					continue;
+				}
+
+				const float Distance = glm::distance(Camera.Location, Center);
+				const float ScreenRadius = Radius / glm::max(Distance, Camera.Near) * PixelsPerUnit;
+				const int LOD = SphereLOD::Select(ScreenRadius);
+
+				const GLuint CommandIndex = static_cast<GLuint>(BodyVariant[BodyIndex] * SphereLOD::Count + LOD);
+				BodyDrawCommand[BodyIndex] = CommandIndex;
+				DrawCommands[CommandIndex].InstanceCount++;
+				NumVisibleBodies++;
+			}
+
+			// O offset é múltiplo de sizeof(InstanceData), então também serve de base instance
+			InstanceData* Instances = static_cast<InstanceData*>(FrameRingBuffer.Allocate(glm::max(NumVisibleBodies, 1u) * sizeof(InstanceData), sizeof(InstanceData), InstancesOffset));
+			void* DrawCommandsData = FrameRingBuffer.Allocate(NumDrawCommands * sizeof(DrawElementsIndirectCommand), sizeof(GLuint), DrawCommandsOffset);
+			bDrawBodies = bDrawBodies && Instances && DrawCommandsData;
+			const GLuint FirstInstance = static_cast<GLuint>(InstancesOffset / sizeof(InstanceData));
+
+			// As instâncias de cada comando ficam contíguas
+			GLuint NextInstance = FirstInstance;
+			for (size_t CommandIndex = 0; CommandIndex < NumDrawCommands; ++CommandIndex)
+			{
+				const MeshSection& Section = SphereSections[CommandIndex % SphereLOD::Count];
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~URANO~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixUranus = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixUranus = glm::translate(ModelMatrixUranus, glm::vec3(sin((float)CurrentTime * 1.5) * 140.0, 0.0f, cos((float)CurrentTime * 1.5) * 140.0));
-		ModelMatrixUranus = glm::scale(ModelMatrixUranus, glm::vec3(2.5f, 2.5f, 2.5f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixUranus));
-		ModelViewMatrix = ViewMatrix * ModelMatrixUranus;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixUranus;
+				DrawElementsIndirectCommand& Command = DrawCommands[CommandIndex];
+				Command.Count = Section.IndexCount;
+				Command.FirstIndex = Section.FirstIndex;
+				Command.BaseVertex = Section.BaseVertex;
+				Command.BaseInstance = NextInstance;
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+				NextInstance += Command.InstanceCount;
+				Command.InstanceCount = 0;
+			}
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+			for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+			{
+				if (BodyDrawCommand[BodyIndex] == InvalidDrawCommand)
+				{
+					BodyInstanceSlots[BodyIndex] = BodyTransforms::InvalidSlot;
+					continue;
+				}
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixUranus));
+				DrawElementsIndirectCommand& Command = DrawCommands[BodyDrawCommand[BodyIndex]];
+				const GLuint InstanceIndex = Command.BaseInstance + Command.InstanceCount++;
+				BodyInstanceSlots[BodyIndex] = InstanceIndex - FirstInstance;
+			}
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+			Transforms.Update(ViewMatrix, ViewProjectionMatrix, BodyTextureLayers.data(), bDrawBodies ? Instances : nullptr, BodyInstanceSlots);
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+			// Os comandos vão para o ring buffer, de onde a GPU lê os draws indiretos
+			if (bDrawBodies)
+			{
+				std::memcpy(DrawCommandsData, DrawCommands.data(), NumDrawCommands * sizeof(DrawElementsIndirectCommand));
+			}
+		}
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		FrameRingBuffer.Flush();
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+		const std::vector<glm::mat4>& BodyModelMatrices = Transforms.GetModelMatrices();
+		Trails.Update(CurrentTime, BodyModelMatrices);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, UranusTextureId);
+		if (BodyCulling.IsEnabled() && bDrawBodies)
+		{
+			BodyCulling.Dispatch(FrameRingBuffer.GetBuffer(), InstancesOffset, CullInputsOffset, DrawCommandsOffset, NumDrawCommands * sizeof(DrawElementsIndirectCommand), static_cast<GLuint>(NumBodies),
+			                     ViewFrustum, Camera.Location, PixelsPerUnit, OcclusionPyramid);
+		}
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		if (bFrameAllocated)
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, EUniformBlock::Frame, FrameRingBuffer.GetBuffer(), FrameUniformsOffset, sizeof(FrameUniforms));
+		}
 
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~NETUNO~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixNeptune = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixNeptune = glm::translate(ModelMatrixNeptune, glm::vec3(sin((float)CurrentTime * 1.7) * 160.0, 0.0f, cos((float)CurrentTime * 1.7) * 160.0));
-		ModelMatrixNeptune = glm::scale(ModelMatrixNeptune, glm::vec3(3.0f, 3.0f, 3.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixNeptune));
-		ModelViewMatrix = ViewMatrix * ModelMatrixNeptune;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixNeptune;
-
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
-
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
-
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixNeptune));
-
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
-
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
-
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
-
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+		glBindBuffer(GL_ARRAY_BUFFER, FrameRingBuffer.GetBuffer());
+		if (SupportsMultiDrawIndirect())
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, FrameRingBuffer.GetBuffer());
+		}
 
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, NeptuneTextureId);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, BodyTexturesId);
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
-
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~SOL~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixSun = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixSun = glm::scale(ModelMatrixSun, glm::vec3(8.0f, 8.0f, 8.0f));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixSun));
-		ModelViewMatrix = ViewMatrix * ModelMatrixSun;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixSun;
-
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+		for (size_t VariantIndex = 0; bDrawBodies && VariantIndex < ShaderVariants.size(); ++VariantIndex)
+		{
+			// Variante com erro de compilação: pula até que o shader seja corrigido
+			GLuint ProgramId = Shaders.Get(ShaderVariants[VariantIndex]);
+			if (ProgramId == 0)
+			{
+				continue;
+			}
+			glUseProgram(ProgramId);
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+			GLint TexturesSamplerLoc = glGetUniformLocation(ProgramId, "Textures");
+			glUniform1i(TexturesSamplerLoc, 0);
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelMatrixSun));
+			if (ShaderVariants[VariantIndex] & EShaderFeature::VirtualTexture)
+			{
+				VirtualTextures.Bind(ProgramId);
+			}
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+			const size_t FirstCommand = VariantIndex * SphereLOD::Count;
+			MultiDrawElementsIndirect(&DrawCommands[FirstCommand], SphereLOD::Count, DrawCommandsOffset + FirstCommand * sizeof(DrawElementsIndirectCommand), [](GLuint BaseInstance)
+			{
+				// Sem base instance os atributos são reapontados para a primeira instância do comando
+				SetInstanceAttributes(BaseInstance * sizeof(InstanceData));
+			});
+		}
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
+		if (SupportsMultiDrawIndirect())
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		glBindVertexArray(0);
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+		if (TerrainBody >= 0 && bDrawTerrain)
+		{
+			const uint32_t TerrainFeatures = BodyShaderFeatures[TerrainBody] | EShaderFeature::Terrain;
+			const GLuint TerrainProgramId = Shaders.Get(TerrainFeatures);
+			if (TerrainProgramId != 0)
+			{
+				glUseProgram(TerrainProgramId);
+				glUniform1i(glGetUniformLocation(TerrainProgramId, "Textures"), 0);
+				if (TerrainFeatures & EShaderFeature::VirtualTexture)
+				{
+					VirtualTextures.Bind(TerrainProgramId);
+				}
+
+				glBindVertexArray(Terrain.GetVertexArray());
+				glBindBuffer(GL_ARRAY_BUFFER, FrameRingBuffer.GetBuffer());
+				SetInstanceAttributes(TerrainInstanceOffset);
+				Terrain.Draw();
+				glBindVertexArray(0);
+			}
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, SunTextureId);
+		// Os planetas já marcaram os tiles que querem no feedback
+		VirtualTextures.EndFrame();
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+		Asteroids.Draw(AsteroidShaders.Get(EShaderFeature::None), BeltMatrix);
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+		// O fundo só preenche os pixels que os objetos opacos deixaram livres
+		MilkyWay.Draw(SkyShaders.Get(EShaderFeature::None), ViewProjectionMatrix, Camera.Location);
+		Stars.Draw(StarShaders.Get(EShaderFeature::None), ViewProjectionMatrix, StarMagnitudeLimit);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (OrbitDisplay == EOrbitDisplay::Trails)
+		{
+			Trails.DrawTrails(OrbitShaders.Get(EShaderFeature::None));
+		}
+		else if (OrbitDisplay == EOrbitDisplay::Predicted)
+		{
+			Trails.DrawPredictedOrbits(OrbitShaders.Get(EShaderFeature::PredictedOrbit), OrbitElements, BeltMatrix);
+		}
 
-		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~LUA~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
-		
-		
-		ViewMatrix = Camera.GetView();
-		glm::mat4 ModelMatrixMoon = glm::rotate(glm::identity<glm::mat4>(), glm::radians(90.0f), glm::vec3{ 1.0f, 0.0f, 0.0f });
-		ModelMatrixMoon = glm::translate(ModelMatrixMoon, glm::vec3(sin((float)CurrentTime) * 60.0, 5.0f, cos((float)CurrentTime) * 50.0));
-		NormalMatrix = glm::transpose(glm::inverse(ViewMatrix * ModelMatrixMoon));
-		ModelViewMatrix = ViewMatrix * ModelMatrixMoon;
-		ModelViewProjectionMatrix = Camera.GetViewProjection() * ModelMatrixMoon;
+		// Transparentes por último, depois de todos os objetos opacos
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			if (Scene.Atmospheres[BodyIndex] >= 0)
+			{
+				BodyAtmospheres[BodyIndex].Draw(AtmosphereShaders.Get(EShaderFeature::None), BodyModelMatrices[BodyIndex], Scene.Scales[BodyIndex], ViewMatrix, ViewProjectionMatrix);
+			}
+		}
+		for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			if (Scene.Rings[BodyIndex] >= 0)
+			{
+				BodyRings[BodyIndex].Draw(RingShaders.Get(EShaderFeature::None), BodyModelMatrices[BodyIndex], Scene.Scales[BodyIndex], Scene.RingDescs[Scene.Rings[BodyIndex]].AxialTilt);
+			}
+		}
 
-		TimeLoc = glGetUniformLocation(ProgramId, "Time");
-		glUniform1f(TimeLoc, CurrentTime);
+		if (!bRenderingPoster)
+		{
+			OcclusionPyramid.Build(ViewProjectionMatrix, bPostProcess ? HdrPipeline.GetSceneFramebuffer() : TargetFramebuffer);
+		}
 
-		NormalMatrixLoc = glGetUniformLocation(ProgramId, "NormalMatrix");
-		glUniformMatrix4fv(NormalMatrixLoc, 1, GL_FALSE, glm::value_ptr(NormalMatrix));
+		if (bPostProcess)
+		{
+			HdrPipeline.Resolve(BloomDownShaders.Get(EShaderFeature::None), BloomUpShaders.Get(EShaderFeature::None), TonemapShaders.Get(EShaderFeature::None), TargetFramebuffer);
+		}
 
-		ModelViewMatrixLoc = glGetUniformLocation(ProgramId, "ModelViewMatrix");
-		glUniformMatrix4fv(ModelViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(ModelViewMatrix));
+		FrameRingBuffer.EndFrame();
 
-		ModelViewProjectionLoc = glGetUniformLocation(ProgramId, "ModelViewProjection");
-		glUniformMatrix4fv(ModelViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(ModelViewProjectionMatrix));
+		if (bRenderingPoster)
+		{
+			Poster.EndTile();
+			if (!Poster.IsActive())
+			{
+				HdrPipeline.BloomStrength = SavedBloomStrength;
+			}
+		}
+		else if (bCapturingFrame)
+		{
+			Capture.CaptureFrame(Width, Height);
+		}
 
-		LightIntensityLoc = glGetUniformLocation(ProgramId, "LightIntensity");
-		glUniform1f(LightIntensityLoc, Light.Intensity);
+		glfwSwapBuffers(Window);
 
-		LightDirectionViewSpace = ViewMatrix * glm::vec4{ Light.Direction, 0.0f };
+		// Recarregar a cena ou um shader e o pôster alocam, então o que
+		// aparece é o pior frame do último segundo
+		MaxFrameAllocations = std::max(MaxFrameAllocations, GetThreadAllocationCount() - FrameStartAllocations);
+		const double StatsTime = glfwGetTime();
+		if (StatsTime - LastMemoryStatsTime >= 1.0)
+		{
+			if (bMemoryStats)
+			{
+				const PoolCounters TerrainNodes = Terrain.GetNodeCounters();
+				const PoolCounters TileBuffers = VirtualTextures.GetTileBufferCounters();
+
+				std::cout << "Arena do frame: " << FrameArena.GetUsed() / 1024 << " KB de " << FrameArena.GetCapacity() / 1024 << " KB, pico de "
+				          << FrameArena.GetPeak() / 1024 << " KB, " << FrameArena.GetNumOverflows() << " estouros" << std::endl;
+				std::cout << "Nos do terreno: " << TerrainNodes.NumAllocated << " de " << TerrainNodes.Capacity
+				          << ", tiles carregando: " << TileBuffers.NumAllocated << " de " << TileBuffers.Capacity << std::endl;
+				if (IsAllocationCountingEnabled())
+				{
+					std::cout << "Alocacoes no heap: no maximo " << MaxFrameAllocations << " por frame" << std::endl;
+				}
+			}
+			MaxFrameAllocations = 0;
+			LastMemoryStatsTime = StatsTime;
+		}
+	}
 
-		LightDirectionLoc = glGetUniformLocation(ProgramId, "LightDirection");
-		glUniform3fv(LightDirectionLoc, 1, glm::value_ptr(LightDirectionViewSpace));
+	Capture.Stop();
+	HdrPipeline.Release();
+	BloomDownShaders.Release();
+	BloomUpShaders.Release();
+	TonemapShaders.Release();
+	OcclusionPyramid.Release();
+	BodyCulling.Release();
+	FrameRingBuffer.Release();
+	glDeleteBuffers(1, &SphereElementBuffer);
+	glDeleteBuffers(1, &SphereVertexBuffer);
+	glDeleteVertexArrays(1, &SphereVAO);
+	Trails.Release();
+	OrbitShaders.Release();
+	for (size_t BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+	{
+		BodyAtmospheres[BodyIndex].Release();
+		BodyRings[BodyIndex].Release();
+	}
+	AtmosphereShaders.Release();
+	RingShaders.Release();
+	Asteroids.Release();
+	AsteroidShaders.Release();
+	Shaders.Release();
+
+	VirtualTextures.Release();
+	Terrain.Release();
+	glDeleteTextures(1, &BodyTexturesId);
+	MilkyWay.Release();
+	SkyShaders.Release();
+	Stars.Release();
+	StarShaders.Release();
+	AssetPack::Get().Close();
+
+	glfwMakeContextCurrent(nullptr);
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, MoonTextureId);
+int main()
+{
+	if (!glfwInit())
+	{
+		std::cout << "Erro ao inicializar o GLFW" << std::endl;
+		return 1;
+	}
 
-		TextureSamplerLoc = glGetUniformLocation(ProgramId, "Texture");
-		glUniform1i(TextureSamplerLoc, 0);
+	glfwWindowHint(GLFW_DEPTH_BITS, 32);
 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(SphereVAO);
-		glDrawElements(GL_TRIANGLES, SphereIndices.size() * 3, GL_UNSIGNED_INT, nullptr);
+	GLFWwindow* Window = glfwCreateWindow(Width, Height, "Blue Marble", nullptr, nullptr);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+	if (!Window)
+	{
+		std::cout << "Erro ao criar janela" << std::endl;
+		glfwTerminate();
+		return 1;
+	}
 
-		glBindVertexArray(0);
+	glfwSetMouseButtonCallback(Window, MouseButtonCallback);
+	glfwSetCursorPosCallback(Window, MouseMotionCallback);
+	glfwSetKeyCallback(Window, KeyCallback);
+	glfwSetFramebufferSizeCallback(Window, Resize);
 
-		glBindVertexArray(0);
+	// O contexto do OpenGL fica com a thread de renderização e esta thread só
+	// trata os eventos da janela. Assim a espera do glfwSwapBuffers pelo
+	// vsync não atrasa a leitura do teclado e do mouse.
+	std::thread RenderThread{ RunRenderer, Window };
 
-		glfwPollEvents();
-		glfwSwapBuffers(Window);
+	// Com comandos esperando espaço na fila, acorda de tempos em tempos para
+	// tentar de novo mesmo sem eventos novos
+	while (!glfwWindowShouldClose(Window))
+	{
+		if (FlushRenderCommands())
+		{
+			glfwWaitEvents();
+		}
+		else
+		{
+			glfwWaitEventsTimeout(0.05);
+		}
 	}
 
-	glDeleteBuffers(1, &SphereElementBuffer);
-	glDeleteBuffers(1, &SphereVertexBuffer);
-	glDeleteVertexArrays(1, &SphereVAO);
-	glDeleteProgram(ProgramId);
-	glDeleteTextures(1, &EarthTextureId);
+	RenderThread.join();
 
 	glfwDestroyWindow(Window);
 	glfwTerminate();
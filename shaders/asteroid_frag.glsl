@@ -0,0 +1,36 @@
+#version 330 core
+
+in vec3 Normal;
+in vec3 ViewPosition;
+flat in float Albedo;
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+out vec4 OutColor;
+
+void main()
+{
+	vec3 N = normalize(Normal);
+	vec3 L = normalize(LightPosition - ViewPosition);
+
+	float Lambertian = clamp(dot(N, L), 0.0, 1.0);
+
+	// Rocha acinzentada puxando para o marrom
+	vec3 RockColor = Albedo * vec3(0.55, 0.5, 0.45);
+
+	OutColor = vec4(Lambertian * LightIntensity * RockColor, 1.0);
+}
@@ -0,0 +1,69 @@
+#version 330 core
+
+layout (location = 0) in vec3 InPosition;
+layout (location = 1) in vec3 InNormal;
+
+// Elementos orbitais de cada asteroide (ver AsteroidInstance)
+layout (location = 2) in vec4 Orbit;
+layout (location = 3) in vec4 Orientation;
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+// Leva o plano das rbitas para o espao do mundo, como os planetas
+uniform mat4 BeltMatrix;
+
+out vec3 Normal;
+out vec3 ViewPosition;
+flat out float Albedo;
+
+mat3 RotationX(float Angle)
+{
+	float C = cos(Angle);
+	float S = sin(Angle);
+	return mat3(1.0, 0.0, 0.0, 0.0, C, S, 0.0, -S, C);
+}
+
+mat3 RotationY(float Angle)
+{
+	float C = cos(Angle);
+	float S = sin(Angle);
+	return mat3(C, 0.0, -S, 0.0, 1.0, 0.0, S, 0.0, C);
+}
+
+void main()
+{
+	float SemiMajorAxis = Orbit.x;
+	float Eccentricity = Orbit.y;
+	float Phase = Orbit.z;
+
+	// A posio na rbita depende s do tempo, nada  atualizado pela CPU
+	float Angle = Phase + Time * Orbit.w;
+	float Radius = SemiMajorAxis * (1.0 - Eccentricity * Eccentricity) / (1.0 + Eccentricity * cos(Angle));
+	vec3 OrbitPosition = vec3(sin(Angle), 0.0, cos(Angle)) * Radius;
+
+	mat3 OrbitPlane = RotationY(Orientation.y) * RotationX(Orientation.x);
+
+	// A fase tambm escolhe o eixo de rotao, para que as rochas no girem juntas
+	mat3 Spin = RotationX(Phase * 3.0) * RotationY(Time * Orientation.w);
+
+	vec3 Position = OrbitPlane * OrbitPosition + Spin * (InPosition * Orientation.z);
+
+	Normal = mat3(ViewMatrix) * mat3(BeltMatrix) * (Spin * InNormal);
+	Albedo = 0.35 + 0.3 * fract(Phase * 43.758);
+	ViewPosition = (ViewMatrix * BeltMatrix * vec4(Position, 1.0)).xyz;
+	gl_Position = ViewProjectionMatrix * BeltMatrix * vec4(Position, 1.0);
+}
@@ -0,0 +1,126 @@
+#version 330 core
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+// Iguais s constantes de AtmosphereLUT em Atmosphere.h
+const int ScatteringMuSSize = 32;
+const int ScatteringNuSize = 8;
+const float MinMuS = -0.2;
+
+const float PI = 3.14159265;
+
+in vec3 ViewPosition;
+
+// Centro do planeta no espao da cmera e raio
+uniform vec4 PlanetSphere;
+
+// Em raios do planeta
+uniform float TopRadius;
+
+uniform vec3 RayleighScattering;
+uniform vec3 MieScattering;
+uniform float MieAnisotropy;
+
+uniform sampler2D TransmittanceLUT;
+uniform sampler3D ScatteringLUT;
+
+out vec4 OutColor;
+
+// Coordenada de textura de um valor entre Min e Max, no centro dos texels das pontas
+float ToTexCoord(float Value, float Min, float Max, float Size)
+{
+	float Unit = clamp((Value - Min) / (Max - Min), 0.0, 1.0);
+	return (Unit * (Size - 1.0) + 0.5) / Size;
+}
+
+vec4 LookupScattering(float R, float Mu, float MuS, float Nu)
+{
+	// As fatias de nu ficam lado a lado no eixo X e so interpoladas aqui
+	float NuCoord = clamp((Nu + 1.0) * 0.5, 0.0, 1.0) * float(ScatteringNuSize - 1);
+	float Slice = min(floor(NuCoord), float(ScatteringNuSize - 2));
+	float SliceWeight = NuCoord - Slice;
+
+	float MuSCoord = ToTexCoord(MuS, MinMuS, 1.0, float(ScatteringMuSSize));
+	float U = (Slice + MuSCoord) / float(ScatteringNuSize);
+	float V = ToTexCoord(Mu, -1.0, 1.0, float(textureSize(ScatteringLUT, 0).y));
+	float W = ToTexCoord(R, 1.0, TopRadius, float(textureSize(ScatteringLUT, 0).z));
+
+	vec4 Slice0 = texture(ScatteringLUT, vec3(U, V, W));
+	vec4 Slice1 = texture(ScatteringLUT, vec3(U + 1.0 / float(ScatteringNuSize), V, W));
+	return mix(Slice0, Slice1, SliceWeight);
+}
+
+float RayleighPhase(float Nu)
+{
+	return 3.0 / (16.0 * PI) * (1.0 + Nu * Nu);
+}
+
+// Cornette-Shanks
+float MiePhase(float Nu)
+{
+	float G2 = MieAnisotropy * MieAnisotropy;
+	return 3.0 / (8.0 * PI) * (1.0 - G2) * (1.0 + Nu * Nu) / ((2.0 + G2) * pow(1.0 + G2 - 2.0 * MieAnisotropy * Nu, 1.5));
+}
+
+void main()
+{
+	// Tudo em raios do planeta, com o centro do planeta na origem
+	vec3 Direction = normalize(ViewPosition);
+	vec3 Origin = -PlanetSphere.xyz / PlanetSphere.w;
+
+	// Com a cmera fora da atmosfera o raio comea na entrada da casca
+	vec3 Start = Origin;
+	float R = length(Origin);
+	if (R > TopRadius)
+	{
+		float B = dot(Origin, Direction);
+		float Discriminant = B * B - dot(Origin, Origin) + TopRadius * TopRadius;
+		if (Discriminant < 0.0)
+		{
+			discard;
+		}
+
+		float Distance = -B - sqrt(Discriminant);
+		if (Distance < 0.0)
+		{
+			discard;
+		}
+
+		Start = Origin + Direction * Distance;
+		R = TopRadius;
+	}
+
+	vec3 Up = Start / R;
+	vec3 SunDirection = normalize(LightPosition - (PlanetSphere.xyz + Start * PlanetSphere.w));
+
+	float Mu = dot(Direction, Up);
+	float MuS = dot(SunDirection, Up);
+	float Nu = dot(Direction, SunDirection);
+
+	// O Mie s guarda o canal vermelho. Os outros so recuperados pela
+	// proporo do Rayleigh, como em Bruneton.
+	vec4 Scattering = LookupScattering(R, Mu, MuS, Nu);
+	vec3 Mie = Scattering.rgb * Scattering.a / max(Scattering.r, 1e-6) * (RayleighScattering.r / MieScattering.r) * (MieScattering / RayleighScattering);
+	vec3 Inscatter = (Scattering.rgb * RayleighPhase(Nu) + Mie * MiePhase(Nu)) * LightIntensity;
+
+	// Transmitncia at o cho ou at sair da atmosfera. O blending s tem
+	// um fator de atenuao, ento os trs canais so combinados.
+	vec3 Transmittance = texture(TransmittanceLUT, vec2(ToTexCoord(Mu, -1.0, 1.0, float(textureSize(TransmittanceLUT, 0).x)),
+	                                                    ToTexCoord(R, 1.0, TopRadius, float(textureSize(TransmittanceLUT, 0).y)))).rgb;
+
+	OutColor = vec4(Inscatter, dot(Transmittance, vec3(1.0 / 3.0)));
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec3 InPosition;
+
+uniform mat4 ModelViewMatrix;
+uniform mat4 ModelViewProjection;
+
+out vec3 ViewPosition;
+
+void main()
+{
+	ViewPosition = (ModelViewMatrix * vec4(InPosition, 1.0)).xyz;
+	gl_Position = ModelViewProjection * vec4(InPosition, 1.0);
+}
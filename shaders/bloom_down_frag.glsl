@@ -0,0 +1,59 @@
+#version 330 core
+
+// Reduz um nvel do bloom com o filtro de 13 amostras de Jimenez (2014).
+// No primeiro passo cada grupo de 4 amostras  ponderado pelo brilho (mdia
+// de Karis), para que pixels muito brilhantes isolados no pisquem.
+
+in vec2 UV;
+
+uniform sampler2D Source;
+uniform vec2 SourceTexelSize;
+uniform bool bFirstPass;
+
+out vec3 OutColor;
+
+vec3 Fetch(vec2 Offset)
+{
+	return texture(Source, UV + Offset * SourceTexelSize).rgb;
+}
+
+float KarisWeight(vec3 Color)
+{
+	float Luma = dot(Color, vec3(0.2126, 0.7152, 0.0722));
+	return 1.0 / (1.0 + Luma);
+}
+
+void main()
+{
+	vec3 A = Fetch(vec2(-2.0,  2.0));
+	vec3 B = Fetch(vec2( 0.0,  2.0));
+	vec3 C = Fetch(vec2( 2.0,  2.0));
+	vec3 D = Fetch(vec2(-2.0,  0.0));
+	vec3 E = Fetch(vec2( 0.0,  0.0));
+	vec3 F = Fetch(vec2( 2.0,  0.0));
+	vec3 G = Fetch(vec2(-2.0, -2.0));
+	vec3 H = Fetch(vec2( 0.0, -2.0));
+	vec3 I = Fetch(vec2( 2.0, -2.0));
+	vec3 J = Fetch(vec2(-1.0,  1.0));
+	vec3 K = Fetch(vec2( 1.0,  1.0));
+	vec3 L = Fetch(vec2(-1.0, -1.0));
+	vec3 M = Fetch(vec2( 1.0, -1.0));
+
+	// O quadrado central pesa metade e os quatro dos cantos um oitavo cada
+	vec3 Center = (J + K + L + M) * 0.25;
+	vec3 TopLeft = (A + B + D + E) * 0.25;
+	vec3 TopRight = (B + C + E + F) * 0.25;
+	vec3 BottomLeft = (D + E + G + H) * 0.25;
+	vec3 BottomRight = (E + F + H + I) * 0.25;
+
+	vec4 Weights = vec4(0.125);
+	float CenterWeight = 0.5;
+	if (bFirstPass)
+	{
+		Weights *= vec4(KarisWeight(TopLeft), KarisWeight(TopRight), KarisWeight(BottomLeft), KarisWeight(BottomRight));
+		CenterWeight *= KarisWeight(Center);
+	}
+
+	vec3 Sum = Center * CenterWeight + TopLeft * Weights.x + TopRight * Weights.y + BottomLeft * Weights.z + BottomRight * Weights.w;
+	OutColor = Sum / (CenterWeight + dot(Weights, vec4(1.0)));
+}
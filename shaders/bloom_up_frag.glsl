@@ -0,0 +1,25 @@
+#version 330 core
+
+// Amplia um nvel do bloom com um filtro tenda 3x3. O resultado  somado ao
+// nvel maior pelo blending.
+
+in vec2 UV;
+
+uniform sampler2D Source;
+uniform vec2 SourceTexelSize;
+
+out vec3 OutColor;
+
+vec3 Fetch(vec2 Offset)
+{
+	return texture(Source, UV + Offset * SourceTexelSize).rgb;
+}
+
+void main()
+{
+	vec3 Corners = Fetch(vec2(-1.0, 1.0)) + Fetch(vec2(1.0, 1.0)) + Fetch(vec2(-1.0, -1.0)) + Fetch(vec2(1.0, -1.0));
+	vec3 Edges = Fetch(vec2(0.0, 1.0)) + Fetch(vec2(-1.0, 0.0)) + Fetch(vec2(1.0, 0.0)) + Fetch(vec2(0.0, -1.0));
+	vec3 Center = Fetch(vec2(0.0));
+
+	OutColor = (Corners + Edges * 2.0 + Center * 4.0) / 16.0;
+}
@@ -0,0 +1,148 @@
+#version 430 core
+
+// Culling por frustum e por ocluso (contra a pirmide de profundidade do
+// frame anterior) e escolha do nvel de detalhe de cada corpo.
+// LOD_COUNT  definido por quem compila o shader.
+
+layout (local_size_x = 64) in;
+
+struct InstanceData
+{
+	mat4 ModelViewMatrix;
+	mat4 ModelViewProjection;
+	vec4 NormalMatrix[3];
+	vec4 TextureLayers;
+};
+
+struct CullInput
+{
+	vec4 BoundingSphere;
+	uint FirstCommand;
+};
+
+struct DrawElementsIndirectCommand
+{
+	uint Count;
+	uint InstanceCount;
+	uint FirstIndex;
+	int BaseVertex;
+	uint BaseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer SourceInstances
+{
+	InstanceData Instances[];
+};
+
+layout (std430, binding = 1) readonly buffer CullInputs
+{
+	CullInput Inputs[];
+};
+
+layout (std430, binding = 2) buffer DrawCommands
+{
+	DrawElementsIndirectCommand Commands[];
+};
+
+layout (std430, binding = 3) writeonly buffer CulledInstances
+{
+	InstanceData Culled[];
+};
+
+uniform vec4 FrustumPlanes[6];
+uniform vec3 CameraPosition;
+uniform float PixelsPerUnit;
+uniform float LODMinScreenRadius[LOD_COUNT];
+uniform uint NumInstances;
+
+uniform bool bOcclusionCulling;
+uniform sampler2D DepthPyramid;
+uniform int DepthPyramidLevels;
+uniform mat4 OcclusionViewProjection;
+
+// Mesmo teste de DepthPyramid::IsSphereOccluded, mas escolhendo o nvel da
+// pirmide em que a caixa da esfera cobre no mximo 2x2 texels
+bool IsOccluded(vec3 Center, float Radius)
+{
+	vec2 MinUV = vec2(1.0);
+	vec2 MaxUV = vec2(0.0);
+	float NearestDepth = 1.0;
+
+	for (int Corner = 0; Corner < 8; ++Corner)
+	{
+		vec3 Offset = vec3((Corner & 1) != 0 ? Radius : -Radius, (Corner & 2) != 0 ? Radius : -Radius, (Corner & 4) != 0 ? Radius : -Radius);
+		vec4 Clip = OcclusionViewProjection * vec4(Center + Offset, 1.0);
+
+		// A esfera cruza o plano da cmera e no pode ser projetada
+		if (Clip.w <= 0.0)
+		{
+			return false;
+		}
+
+		vec3 Ndc = Clip.xyz / Clip.w;
+		MinUV = min(MinUV, Ndc.xy * 0.5 + 0.5);
+		MaxUV = max(MaxUV, Ndc.xy * 0.5 + 0.5);
+		NearestDepth = min(NearestDepth, Ndc.z * 0.5 + 0.5);
+	}
+
+	ivec2 Size = textureSize(DepthPyramid, 0);
+	ivec2 MinPixel = min(ivec2(clamp(MinUV, 0.0, 1.0) * vec2(Size)), Size - 1);
+	ivec2 MaxPixel = min(ivec2(clamp(MaxUV, 0.0, 1.0) * vec2(Size)), Size - 1);
+	ivec2 Extent = MaxPixel - MinPixel + 1;
+
+	int Level = clamp(int(ceil(log2(float(max(Extent.x, Extent.y))))), 0, DepthPyramidLevels - 1);
+	ivec2 LevelSize = textureSize(DepthPyramid, Level);
+	ivec2 MinTexel = min(MinPixel >> Level, LevelSize - 1);
+	ivec2 MaxTexel = min(MaxPixel >> Level, LevelSize - 1);
+
+	float MaxDepth = max(max(texelFetch(DepthPyramid, MinTexel, Level).r, texelFetch(DepthPyramid, ivec2(MaxTexel.x, MinTexel.y), Level).r),
+	                     max(texelFetch(DepthPyramid, ivec2(MinTexel.x, MaxTexel.y), Level).r, texelFetch(DepthPyramid, MaxTexel, Level).r));
+
+	return NearestDepth > MaxDepth;
+}
+
+void main()
+{
+	uint Index = gl_GlobalInvocationID.x;
+	if (Index >= NumInstances)
+	{
+		return;
+	}
+
+	vec3 Center = Inputs[Index].BoundingSphere.xyz;
+	float Radius = Inputs[Index].BoundingSphere.w;
+
+	// Raio zero: o corpo est sendo desenhado de outro jeito neste frame
+	if (Radius <= 0.0)
+	{
+		return;
+	}
+
+	for (int Plane = 0; Plane < 6; ++Plane)
+	{
+		if (dot(FrustumPlanes[Plane].xyz, Center) + FrustumPlanes[Plane].w < -Radius)
+		{
+			return;
+		}
+	}
+
+	if (bOcclusionCulling && IsOccluded(Center, Radius))
+	{
+		return;
+	}
+
+	// Mesmo critrio de SphereLOD::Select: raio projetado na tela em pixels
+	float ScreenRadius = Radius / max(distance(CameraPosition, Center), 0.0001) * PixelsPerUnit;
+
+	uint LOD = 0;
+	while (LOD < uint(LOD_COUNT - 1) && ScreenRadius < LODMinScreenRadius[LOD])
+	{
+		++LOD;
+	}
+
+	// Cada comando tem espao reservado para todos os corpos da sua variante,
+	// ento o atomicAdd nunca passa do espao do comando
+	uint CommandIndex = Inputs[Index].FirstCommand + LOD;
+	uint Slot = atomicAdd(Commands[CommandIndex].InstanceCount, 1u);
+	Culled[Commands[CommandIndex].BaseInstance + Slot] = Instances[Index];
+}
@@ -0,0 +1,40 @@
+#version 330 core
+
+// Gera um nvel da pirmide de profundidade com a maior profundidade dos
+// texels do nvel anterior. Quando o nvel anterior tem dimenso mpar o
+// ltimo texel tambm cobre a coluna ou linha que sobra.
+
+uniform sampler2D Depth;
+uniform ivec2 SourceSize;
+
+// Limita a leitura ao nvel anterior, que pode ter s 1 texel de largura
+float FetchDepth(ivec2 Texel)
+{
+	return texelFetch(Depth, min(Texel, SourceSize - 1), 0).r;
+}
+
+void main()
+{
+	ivec2 Texel = ivec2(gl_FragCoord.xy) * 2;
+
+	float MaxDepth = max(max(FetchDepth(Texel), FetchDepth(Texel + ivec2(1, 0))),
+	                     max(FetchDepth(Texel + ivec2(0, 1)), FetchDepth(Texel + ivec2(1, 1))));
+
+	bool bExtraColumn = (SourceSize.x & 1) != 0 && Texel.x == SourceSize.x - 3;
+	bool bExtraRow = (SourceSize.y & 1) != 0 && Texel.y == SourceSize.y - 3;
+
+	if (bExtraColumn)
+	{
+		MaxDepth = max(MaxDepth, max(FetchDepth(Texel + ivec2(2, 0)), FetchDepth(Texel + ivec2(2, 1))));
+	}
+	if (bExtraRow)
+	{
+		MaxDepth = max(MaxDepth, max(FetchDepth(Texel + ivec2(0, 2)), FetchDepth(Texel + ivec2(1, 2))));
+	}
+	if (bExtraColumn && bExtraRow)
+	{
+		MaxDepth = max(MaxDepth, FetchDepth(Texel + ivec2(2, 2)));
+	}
+
+	gl_FragDepth = MaxDepth;
+}
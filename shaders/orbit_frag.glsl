@@ -0,0 +1,12 @@
+#version 330 core
+
+in float Fade;
+
+uniform vec3 TrailColor = vec3(0.35, 0.55, 1.0);
+
+out vec4 OutColor;
+
+void main()
+{
+	OutColor = vec4(TrailColor * Fade, 1.0);
+}
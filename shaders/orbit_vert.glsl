@@ -0,0 +1,70 @@
+#version 330 core
+
+// Vrtices das linhas de rbita gerados a partir de gl_VertexID, que no
+// glMultiDrawArrays j inclui o first de cada corpo
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+out float Fade;
+
+#ifdef PREDICTED_ORBIT
+
+// Um texel por corpo. xyz: raio da rbita em X, altura em Y e raio em Z,
+// como em CelestialBody
+uniform samplerBuffer OrbitElements;
+uniform mat4 OrbitMatrix;
+uniform int NumSegments;
+
+void main()
+{
+	int Body = gl_VertexID / (NumSegments + 1);
+	int Segment = gl_VertexID % (NumSegments + 1);
+
+	float Angle = 6.28318530718 * float(Segment) / float(NumSegments);
+	vec3 Radius = texelFetch(OrbitElements, Body).xyz;
+	vec3 Position = vec3(sin(Angle) * Radius.x, Radius.y, cos(Angle) * Radius.z);
+
+	Fade = 0.35;
+	gl_Position = ViewProjectionMatrix * OrbitMatrix * vec4(Position, 1.0);
+}
+
+#else
+
+// Posies no mundo gravadas por OrbitTrails::Update. A amostra S do corpo B
+// fica no texel S * NumBodies + B.
+uniform samplerBuffer TrailPositions;
+uniform int NumBodies;
+uniform int Capacity;
+
+// Amostra mais recente
+uniform int Head;
+
+void main()
+{
+	int Body = gl_VertexID / Capacity;
+
+	// Step 0  a amostra mais antiga e Capacity - 1 a mais recente
+	int Step = gl_VertexID % Capacity;
+	int Sample = (Head + 1 + Step) % Capacity;
+
+	vec3 Position = texelFetch(TrailPositions, Sample * NumBodies + Body).xyz;
+
+	Fade = float(Step + 1) / float(Capacity);
+	gl_Position = ViewProjectionMatrix * vec4(Position, 1.0);
+}
+
+#endif
@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec2 UV;
+
+// Tringulo que cobre a tela inteira, sem vertex buffer
+void main()
+{
+	vec2 Position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	UV = Position;
+	gl_Position = vec4(Position * 2.0 - 1.0, 0.0, 1.0);
+}
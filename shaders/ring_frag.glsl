@@ -0,0 +1,59 @@
+#version 330 core
+
+// Posio no plano do anel, em raios do planeta
+in vec2 RingPosition;
+in vec3 WorldPosition;
+in vec3 WorldNormal;
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+// Cor em rgb e densidade em a, de RingRadii.x at RingRadii.y
+uniform sampler1D RadialTexture;
+uniform vec2 RingRadii;
+
+// Centro (xyz) e raio (w) do planeta no espao do mundo
+uniform vec4 PlanetSphere;
+
+out vec4 OutColor;
+
+void main()
+{
+	// A distncia ao centro  calculada por fragmento, ento a textura no
+	// depende de quantas divises radiais a malha tem
+	float RadialCoord = (length(RingPosition) - RingRadii.x) / (RingRadii.y - RingRadii.x);
+	if (RadialCoord < 0.0 || RadialCoord > 1.0)
+	{
+		discard;
+	}
+	vec4 Ring = texture(RadialTexture, RadialCoord);
+
+	// A posio do Sol no FrameBlock est no espao da cmera
+	vec3 LightWorldPosition = transpose(mat3(ViewMatrix)) * (LightPosition - ViewMatrix[3].xyz);
+	vec3 L = normalize(LightWorldPosition - WorldPosition);
+
+	// Sombra do planeta: o raio que sai do fragmento em direo  luz passa
+	// a menos de um raio do centro do planeta
+	vec3 ToPlanet = PlanetSphere.xyz - WorldPosition;
+	float AlongRay = dot(ToPlanet, L);
+	float DistanceToRay = length(ToPlanet - AlongRay * L);
+	float Shadow = (AlongRay > 0.0) ? smoothstep(PlanetSphere.w * 0.97, PlanetSphere.w * 1.03, DistanceToRay) : 1.0;
+
+	// O anel  fino e espalha a luz para os dois lados
+	float Lambertian = mix(0.3, 1.0, abs(dot(normalize(WorldNormal), L)));
+
+	OutColor = vec4(Ring.rgb * Lambertian * Shadow * LightIntensity, Ring.a);
+}
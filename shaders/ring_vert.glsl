@@ -0,0 +1,35 @@
+#version 330 core
+
+layout (location = 0) in vec2 InPosition;
+
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
+
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+uniform mat4 ModelMatrix;
+
+out vec2 RingPosition;
+out vec3 WorldPosition;
+out vec3 WorldNormal;
+
+void main()
+{
+	vec4 Position = ModelMatrix * vec4(InPosition, 0.0, 1.0);
+
+	RingPosition = InPosition;
+	WorldPosition = Position.xyz;
+	WorldNormal = mat3(ModelMatrix) * vec3(0.0, 0.0, 1.0);
+	gl_Position = ViewProjectionMatrix * Position;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec4 FarPosition;
+
+uniform samplerCube Sky;
+uniform float SkyIntensity = 0.6;
+
+out vec4 OutColor;
+
+void main()
+{
+	vec3 Direction = FarPosition.xyz / FarPosition.w;
+	OutColor = vec4(SkyIntensity * texture(Sky, Direction).rgb, 1.0);
+}
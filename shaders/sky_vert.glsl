@@ -0,0 +1,15 @@
+#version 330 core
+
+// Leva um ponto do plano de fundo (em NDC) para uma direo no mundo
+uniform mat4 InverseViewProjection;
+
+out vec4 FarPosition;
+
+void main()
+{
+	vec2 Position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+	// Interpolado em coordenadas homogneas e dividido por w no fragment shader
+	FarPosition = InverseViewProjection * vec4(Position, 1.0, 1.0);
+	gl_Position = vec4(Position, 1.0, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec3 StarColor;
+
+out vec4 OutColor;
+
+void main()
+{
+	// Perfil gaussiano dentro do ponto, para a estrela no ficar quadrada
+	vec2 Offset = gl_PointCoord * 2.0 - 1.0;
+	float Falloff = exp(-4.0 * dot(Offset, Offset));
+
+	OutColor = vec4(StarColor * Falloff, 1.0);
+}
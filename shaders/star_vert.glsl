@@ -0,0 +1,50 @@
+#version 330 core
+
+// StarRecord lido direto do catlogo: direo octadrica (snorm16),
+// magnitude e ndice de cor B-V em milsimos
+layout (location = 0) in vec2 InDirection;
+layout (location = 1) in float InMagnitude;
+layout (location = 2) in float InColorIndex;
+
+uniform mat4 ViewProjection;
+uniform float MagnitudeLimit;
+
+out vec3 StarColor;
+
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+	vec3 Direction = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+	if (Direction.z < 0.0)
+	{
+		Direction.xy = (1.0 - abs(Direction.yx)) * vec2(Direction.x >= 0.0 ? 1.0 : -1.0, Direction.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(Direction);
+}
+
+// Cor aproximada do corpo negro a partir do ndice B-V: azulada abaixo de 0,
+// branca perto de 0.3, amarela perto de 0.6 e alaranjada acima de 1.5
+vec3 ColorFromIndex(float ColorIndex)
+{
+	float T = clamp((ColorIndex + 0.4) / 2.4, 0.0, 1.0);
+	vec3 Blue = vec3(0.65, 0.75, 1.0);
+	vec3 White = vec3(1.0, 0.97, 0.92);
+	vec3 Red = vec3(1.0, 0.6, 0.35);
+	return T < 0.3 ? mix(Blue, White, T / 0.3) : mix(White, Red, (T - 0.3) / 0.7);
+}
+
+void main()
+{
+	float Magnitude = InMagnitude / 1000.0;
+	float ColorIndex = InColorIndex / 1000.0;
+
+	// Fluxo em relao a uma estrela no limite de magnitude: cada 5
+	// magnitudes a menos so 100 vezes mais luz
+	float Flux = pow(10.0, -0.4 * (Magnitude - MagnitudeLimit));
+
+	gl_PointSize = clamp(1.5 + 0.35 * log2(Flux), 1.0, 8.0);
+	StarColor = ColorFromIndex(ColorIndex) * clamp(0.15 * sqrt(Flux), 0.0, 1.0);
+
+	// w = 0: s a rotao da cmera importa e xyww coloca a estrela no plano de fundo
+	vec4 Position = ViewProjection * vec4(DecodeOctahedral(InDirection), 0.0);
+	gl_Position = Position.xyww;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+in vec2 UV;
+
+uniform sampler2D Scene;
+uniform sampler2D Bloom;
+uniform float Exposure;
+uniform float BloomStrength;
+
+out vec4 OutColor;
+
+// Aproximao da curva ACES de Krzysztof Narkowicz
+vec3 ACESFilm(vec3 Color)
+{
+	return clamp((Color * (2.51 * Color + 0.03)) / (Color * (2.43 * Color + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main()
+{
+	vec3 Color = mix(texture(Scene, UV).rgb, texture(Bloom, UV).rgb, BloomStrength);
+
+	// As texturas so usadas sem converso de sRGB para linear, ento a
+	// sada tambm no recebe correo de gamma
+	OutColor = vec4(ACESFilm(Color * Exposure), 1.0);
+}
@@ -1,28 +1,191 @@
 #version 330 core
 
+#ifdef VIRTUAL_TEXTURE
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shader_image_load_store : require
+
+// Sem isso o teste de profundidade pode rodar depois do shader e os
+// fragmentos escondidos tambm marcariam tiles no feedback. O shader no
+// escreve gl_FragDepth nem usa discard, ento o resultado no muda.
+layout(early_fragment_tests) in;
+#endif
+
 in vec3 Position;
 in vec3 Normal;
 in vec3 Color;
 in vec2 UV;
 
-uniform vec3 LightDirection;
-uniform float LightIntensity;
+// Camadas da texture array: x para a superfcie e y para as nuvens. z  o
+// ndice da textura virtual da superfcie mais 1, ou 0 se o corpo no tem.
+flat in vec3 Layers;
 
-uniform float Time;
+// Igual a MaxShadowOccluders em ShaderData.h
+#define MAX_OCCLUDERS 16
 
-uniform sampler2D Texture;
-uniform sampler2D CloudsTexture;
+// Dados do frame, compartilhados por todos os corpos
+layout (std140) uniform FrameBlock
+{
+	mat4 ViewMatrix;
+	mat4 ViewProjectionMatrix;
+	vec3 LightPosition;
+	float LightIntensity;
+	float Time;
+	float LightRadius;
+	int NumOccluders;
+	float EmissiveIntensity;
+	vec4 Occluders[MAX_OCCLUDERS];
+};
+
+// Texturas de todos os corpos, uma por camada
+uniform sampler2DArray Textures;
+
+#ifdef VIRTUAL_TEXTURE
+// Iguais a VirtualTextureFormat e VirtualTextureCache::MaxTextures
+#define VT_TILE_SIZE 128.0
+#define VT_TILE_BORDER 4.0
+#define VT_PADDED_TILE_SIZE 136.0
+#define VT_MAX_TEXTURES 4
+
+// Tiles residentes de todas as texturas virtuais
+uniform sampler2D VirtualAtlas;
+
+// Uma camada por textura e um mip por nvel. Cada texel aponta o slot do
+// tile no atlas (xy) e o nvel do tile que est l (z), que  um ancestral
+// quando o tile pedido ainda no chegou. w  zero se nada est no atlas.
+uniform sampler2DArray PageTables;
+
+// x, y: tiles no nvel 0, z: nmero de nveis, w: primeiro bit de feedback
+uniform ivec4 VirtualTextureInfo[VT_MAX_TEXTURES];
+
+// Pixel de cada bloco 4x4 que escreve o feedback neste frame
+uniform int FeedbackPhase;
+
+// Um bit por tile, lido de volta pela CPU para carregar os tiles que faltam
+layout (std430) buffer FeedbackBlock
+{
+	uint FeedbackBits[];
+};
+
+// Amostra a textura virtual Index e marca o tile usado no feedback. Retorna
+// false se nenhum nvel da regio est no atlas.
+bool SampleVirtualTexture(int Index, vec2 TexCoord, out vec3 OutColor)
+{
+	ivec4 Info = VirtualTextureInfo[Index];
+
+	// Nvel de detalhe pelas derivadas em texels do nvel 0, como o hardware
+	vec2 LevelZeroSize = vec2(Info.xy) * VT_TILE_SIZE;
+	vec2 TexelDx = dFdx(TexCoord) * LevelZeroSize;
+	vec2 TexelDy = dFdy(TexCoord) * LevelZeroSize;
+	float Lod = 0.5 * log2(max(max(dot(TexelDx, TexelDx), dot(TexelDy, TexelDy)), 1e-8));
+	int Level = clamp(int(floor(Lod)), 0, Info.z - 1);
+
+	// A longitude d a volta e a latitude para nos polos
+	vec2 WrappedUV = vec2(fract(TexCoord.x), clamp(TexCoord.y, 0.0, 1.0));
+	ivec2 Tiles = max(Info.xy >> Level, ivec2(1));
+	ivec2 Tile = min(ivec2(WrappedUV * vec2(Tiles)), Tiles - 1);
+
+	ivec2 FeedbackPixel = ivec2(gl_FragCoord.xy) & 3;
+	if (FeedbackPixel.y * 4 + FeedbackPixel.x == FeedbackPhase)
+	{
+		int FirstTile = 0;
+		for (int PreviousLevel = 0; PreviousLevel < Level; ++PreviousLevel)
+		{
+			ivec2 PreviousTiles = max(Info.xy >> PreviousLevel, ivec2(1));
+			FirstTile += PreviousTiles.x * PreviousTiles.y;
+		}
+
+		uint Bit = uint(Info.w + FirstTile + Tile.y * Tiles.x + Tile.x);
+		atomicOr(FeedbackBits[Bit >> 5u], 1u << (Bit & 31u));
+	}
+
+	ivec4 Entry = ivec4(texelFetch(PageTables, ivec3(Tile, Index), Level) * 255.0 + 0.5);
+	if (Entry.w == 0)
+	{
+		return false;
+	}
+
+	// Posio dentro do tile que est no atlas, que pode ser de um nvel menos detalhado
+	ivec2 MappedTiles = max(Info.xy >> Entry.z, ivec2(1));
+	vec2 MappedPosition = WrappedUV * vec2(MappedTiles);
+	vec2 InTile = MappedPosition - vec2(min(ivec2(MappedPosition), MappedTiles - 1));
+
+	vec2 AtlasTexel = vec2(Entry.xy) * VT_PADDED_TILE_SIZE + VT_TILE_BORDER + InTile * VT_TILE_SIZE;
+	OutColor = textureLod(VirtualAtlas, AtlasTexel / vec2(textureSize(VirtualAtlas, 0)), 0.0).rgb;
+	return true;
+}
+#endif
 
 uniform vec2 CloudsRotationSpeed = vec2(0.008, 0.00);
 
 out vec4 OutColor;
 
+// Frao da luz do Sol que chega em Point, considerando os corpos em
+// Occluders como esferas na frente do disco do Sol. A rea coberta do disco
+//  aproximada a partir dos raios angulares, o que d umbra e penumbra sem
+// shadow maps.
+float EclipseShadow(vec3 Point)
+{
+	vec3 ToLight = LightPosition - Point;
+	float LightDistance = length(ToLight);
+	vec3 LightDir = ToLight / LightDistance;
+	float LightAngle = asin(clamp(LightRadius / LightDistance, 0.0, 1.0));
+
+	float Visibility = 1.0;
+	for (int Index = 0; Index < NumOccluders; ++Index)
+	{
+		vec3 ToOccluder = Occluders[Index].xyz - Point;
+		float OccluderDistance = length(ToOccluder);
+		float OccluderRadius = Occluders[Index].w;
+
+		// O prprio corpo do ponto e os corpos atrs do ponto no fazem sombra
+		if (OccluderDistance <= OccluderRadius * 1.01 || OccluderDistance >= LightDistance)
+		{
+			continue;
+		}
+
+		float OccluderAngle = asin(clamp(OccluderRadius / OccluderDistance, 0.0, 1.0));
+		float Separation = acos(clamp(dot(ToOccluder / OccluderDistance, LightDir), -1.0, 1.0));
+
+		// Cobertura mxima quando os discos esto alinhados, que  menor que 1
+		// se o corpo parece menor que o Sol (eclipse anular)
+		float MaxCoverage = min(1.0, (OccluderAngle * OccluderAngle) / (LightAngle * LightAngle));
+		float Coverage = MaxCoverage * (1.0 - smoothstep(abs(OccluderAngle - LightAngle), OccluderAngle + LightAngle, Separation));
+		Visibility *= 1.0 - Coverage;
+	}
+	return Visibility;
+}
+
 void main()
 {
+#ifdef TERRAIN
+	// O terreno gira a prpria geometria, ento s as nuvens se deslocam, com
+	// a diferena entre a velocidade delas e a da superfcie
+	vec2 SurfaceUV = UV;
+	vec2 CloudsUV = UV + Time * vec2(0.0099 - 0.008, 0.00);
+#else
+	vec2 SurfaceUV = UV + Time * vec2(0.008, 0.00);
+	vec2 CloudsUV = UV + Time * vec2(0.0099, 0.00);
+#endif
+	vec3 SurfaceColor = texture(Textures, vec3(SurfaceUV, Layers.x)).rgb;
+
+#ifdef VIRTUAL_TEXTURE
+	// Layers.z  igual em todo o tringulo, ento as derivadas continuam valendo
+	vec3 VirtualColor;
+	if (Layers.z > 0.5 && SampleVirtualTexture(int(Layers.z) - 1, SurfaceUV, VirtualColor))
+	{
+		SurfaceColor = VirtualColor;
+	}
+#endif
+
+#ifdef EMISSIVE
+	// O Sol  a prpria fonte de luz, ento no tem Lambertiano nem especular.
+	// Com a cena em HDR o brilho passa bem de 1 e alimenta o bloom.
+	OutColor = vec4(EmissiveIntensity * SurfaceColor, 1.0);
+#else
 	vec3 N = normalize(Normal);
 
-	// inverte a direo para calcular o Lambertiano
-	vec3 L = -normalize(LightDirection);
+	// Direo do ponto para o Sol, que  uma luz pontual
+	vec3 L = normalize(LightPosition - Position);
 
 	// Dot entre dois vetores unitrios  equivalente ao cosseno entre esses vetores
 	// Quanto maior o ngulo entre os vetores, menor  o cosseno entre eles
@@ -33,6 +196,23 @@ void main()
 	// oposto a direo da luz.
 	Lambertian = clamp(Lambertian, 0.0, 1.0);
 
+#ifdef HAS_CLOUDS
+	// A textura de nuvens  clara sobre fundo preto, ento o brilho serve de
+	// cobertura. Misturar em vez de somar evita estourar acima de 1.
+	vec3 CloudsColor = texture(Textures, vec3(CloudsUV, Layers.y)).rgb;
+	float CloudCoverage = max(CloudsColor.r, max(CloudsColor.g, CloudsColor.b));
+	SurfaceColor = mix(SurfaceColor, CloudsColor / max(CloudCoverage, 1e-3), CloudCoverage);
+#endif
+
+	// A refleco difusa vai ser o produto do lambertiano com a intensidade
+	// da luz e a cor da textura.
+	vec3 DiffuseReflection = Lambertian * LightIntensity * SurfaceColor;
+
+	// S vale a pena procurar eclipses no lado iluminado
+	float Shadow = (Lambertian > 0.0) ? EclipseShadow(Position) : 1.0;
+	DiffuseReflection *= Shadow;
+
+#ifdef SPECULAR
 	float SpecularReflection = 0.0;
 	if (Lambertian > 0.0)
 	{
@@ -43,20 +223,13 @@ void main()
 		vec3 ReflectionDirection = reflect(-L, N);
 
 		// Termo especular: (R . V) ^ alpha
-		SpecularReflection = pow(dot(ReflectionDirection, ViewDirection), 50.0);
-
 		// Limita o valor da refleco especular a nmeros positivos
-		SpecularReflection = max(0.0, SpecularReflection);
+		SpecularReflection = pow(max(0.0, dot(ReflectionDirection, ViewDirection)), 50.0);
 	}
 
-	vec3 EarthColor = texture(Texture, UV + Time * vec2(0.008, 0.00)).rgb;
-	vec3 CloudsColor = texture(CloudsTexture, UV + Time * vec2(0.0099, 0.00)).rgb;
-
-	vec3 SurfaceColor = EarthColor + CloudsColor;
-
-	// A refleco difusa vai ser o produto do lambertiano com a intensidade
-	// da luz e a cor da textura.
-	vec3 DiffuseReflection = Lambertian * LightIntensity * SurfaceColor;
+	DiffuseReflection += SpecularReflection * LightIntensity * Shadow;
+#endif
 
 	OutColor = vec4(DiffuseReflection, 1.0);
+#endif
 }
\ No newline at end of file
@@ -5,22 +5,26 @@ layout (location = 1) in vec3 InNormal;
 layout (location = 2) in vec3 InColor;
 layout (location = 3) in vec2 InUV;
 
-uniform mat4 NormalMatrix;
-uniform mat4 ModelViewMatrix;
-uniform mat4 ModelViewProjection;
+// Dados de cada corpo, lidos do ring buffer com divisor 1 (um por instncia)
+layout (location = 4) in mat4 ModelViewMatrix;
+layout (location = 8) in mat4 ModelViewProjection;
+layout (location = 12) in mat3 NormalMatrix;
+layout (location = 15) in vec4 TextureLayers;
 
 out vec3 Position;
 out vec3 Normal;
 out vec3 Color;
 out vec2 UV;
+flat out vec3 Layers;
 
 void main()
 {  
 	vec4 ViewPosition = ModelViewMatrix * vec4(InPosition, 1.0);
 
 	Position = ViewPosition.xyz / ViewPosition.w;
-	Normal = vec3(NormalMatrix * vec4(InNormal, 0.0));	
+	Normal = NormalMatrix * InNormal;
 	Color = InColor;
 	UV = InUV;
+	Layers = TextureLayers.xyz;
 	gl_Position = ModelViewProjection * vec4(InPosition, 1.0);
 }
\ No newline at end of file